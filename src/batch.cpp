@@ -0,0 +1,93 @@
+#include "batch.h"
+
+#include <string>
+
+// 本文件实现 cat-file 与 hash-object 的批量协议
+namespace {
+
+// 判断输入是否为 40 位十六进制对象哈希
+bool is_full_hex_hash(const std::string& s) {
+    if (s.size() != 40U) {
+        return false;
+    }
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        bool hex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+        if (!hex) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+namespace minigit {
+
+// 逐行读取对象哈希并输出元信息或内容，全程复用一个读取上下文
+int run_cat_file_batch(ObjectStore& store, std::istream& in, std::ostream& out,
+                       const CatFileBatchOptions& options) {
+    ReadContext ctx;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+
+        bool found = false;
+        if (is_full_hex_hash(line)) {
+            if (options.with_contents) {
+                ObjectView view;
+                if (store.read_object(line, ctx, view)) {
+                    found = true;
+                    out << line << ' ' << object_type_name(view.type) << ' '
+                        << view.size << '\n';
+                    out.write(view.data, static_cast<std::streamsize>(view.size));
+                    out << '\n';
+                }
+            } else {
+                ObjectType type = ObjectType::kNone;
+                std::size_t size = 0;
+                if (store.read_object_info(line, ctx, type, size)) {
+                    found = true;
+                    out << line << ' ' << object_type_name(type) << ' ' << size << '\n';
+                }
+            }
+        }
+        if (!found) {
+            out << line << " missing\n";
+        }
+
+        if (!options.buffer) {
+            out.flush();
+        }
+        if (!out) {
+            return 1;
+        }
+    }
+    out.flush();
+    return out ? 0 : 1;
+}
+
+// 逐行读取文件路径并写入 blob，文件内容复用同一个缓冲区
+int run_hash_object_stdin_paths(ObjectStore& store, std::istream& in,
+                                std::ostream& out, std::ostream& err) {
+    int rc = 0;
+    std::string buffer;
+    std::string path;
+    while (std::getline(in, path)) {
+        if (path.empty()) {
+            continue;
+        }
+        if (!read_file_into(path, buffer)) {
+            err << "failed to open file: " << path << "\n";
+            rc = 1;
+            continue;
+        }
+        out << store.store_blob(buffer.data(), buffer.size()) << '\n';
+        out.flush();
+    }
+    return rc;
+}
+
+}  // namespace minigit
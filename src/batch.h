@@ -0,0 +1,54 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+
+#include "object_store.h"
+
+// 本文件声明基于标准输入/输出的批量对象读写协议
+namespace minigit {
+
+/**
+ * @brief cat-file 批量模式的选项。
+ */
+struct CatFileBatchOptions {
+    /// 为 true 时输出对象内容（--batch），否则只输出类型与长度（--batch-check）。
+    bool with_contents;
+    /// 为 true 时仅在输入结束时刷新输出（--buffer），否则每个应答后立即刷新。
+    bool buffer;
+};
+
+/**
+ * @brief 执行 cat-file --batch / --batch-check 协议。
+ *
+ * 从 in 逐行读取对象哈希，对每一行输出：
+ *   "<hash> <type> <size>\\n"，--batch 模式下随后输出 "<内容>\\n"；
+ *   对象不存在或输入非法时输出 "<输入> missing\\n"。
+ * 全程复用同一个读取上下文；--batch-check 只解压对象头部。
+ *
+ * @param store   对象存储实例。
+ * @param in      请求输入流。
+ * @param out     应答输出流。
+ * @param options 批量模式选项。
+ * @return 进程退出码，输出流出错时返回 1，否则返回 0。
+ */
+int run_cat_file_batch(ObjectStore& store, std::istream& in, std::ostream& out,
+                       const CatFileBatchOptions& options);
+
+/**
+ * @brief 执行 hash-object --stdin-paths 协议。
+ *
+ * 从 in 逐行读取文件路径，将文件内容写入为 blob 对象并输出 "<hash>\\n"。
+ * 文件读取复用同一个缓冲区；无法读取的文件会在 err 中报告并使返回码为 1，
+ * 但不会中断后续路径的处理。
+ *
+ * @param store 对象存储实例。
+ * @param in    路径输入流。
+ * @param out   哈希输出流，每个应答后刷新。
+ * @param err   错误信息输出流。
+ * @return 全部成功返回 0，否则返回 1。
+ */
+int run_hash_object_stdin_paths(ObjectStore& store, std::istream& in,
+                                std::ostream& out, std::ostream& err);
+
+}  // namespace minigit
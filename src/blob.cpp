@@ -1,6 +1,5 @@
 #include "blob.h"
 
-#include <sstream>
 #include <string>
 
 // 本文件实现 Git 风格的 blob 对象内容构造
@@ -8,10 +7,19 @@ namespace minigit {
 
 // 使用 "blob <size>\\0<data>" 形式构造 blob 对象内容
 std::string build_blob_object(const std::string& data) {
-    std::ostringstream oss;
-    oss << "blob " << data.size() << '\0';
-    oss << data;
-    return oss.str();
+    std::string header = build_blob_header(data.size());
+    std::string content;
+    content.reserve(header.size() + data.size());
+    content.append(header);
+    content.append(data);
+    return content;
+}
+
+// 构造 "blob <size>\\0" 形式的对象头部
+std::string build_blob_header(std::size_t size) {
+    std::string header = "blob " + std::to_string(size);
+    header.push_back('\0');
+    return header;
 }
 
 }  // namespace minigit
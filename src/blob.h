@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 // 本文件声明 blob 对象构造函数，用于生成 Git 风格 blob 对象内容
@@ -15,4 +16,15 @@ namespace minigit {
  */
 std::string build_blob_object(const std::string& data);
 
+/**
+ * @brief 构造 blob 对象头部 "blob <size>\\0"。
+ *
+ * 写入路径将头部与调用方的数据缓冲区作为两段切片分别处理，
+ * 从而无需构造完整的对象内容副本。
+ *
+ * @param size blob 正文长度（字节）。
+ * @return 含结尾 '\\0' 的头部字符串。
+ */
+std::string build_blob_header(std::size_t size);
+
 }  // namespace minigit
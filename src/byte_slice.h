@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// 本文件声明只读字节切片类型，用于在不拼接的前提下描述一段或多段数据
+namespace minigit {
+
+/**
+ * @brief 指向外部缓冲区的只读字节切片。
+ *
+ * 类似 POSIX 的 iovec，仅记录起始地址与长度，不拥有数据；
+ * 调用方需保证切片在使用期间所指向的缓冲区保持有效。
+ */
+struct ByteSlice {
+    /// 数据起始地址，size 为 0 时允许为 nullptr。
+    const char* data;
+    /// 数据长度（字节）。
+    std::size_t size;
+};
+
+/**
+ * @brief 以字符串内容构造字节切片。
+ *
+ * @param s 源字符串，切片生命周期不能超过该字符串。
+ * @return 指向字符串内部缓冲区的切片。
+ */
+inline ByteSlice make_slice(const std::string& s) {
+    ByteSlice slice = {s.data(), s.size()};
+    return slice;
+}
+
+/**
+ * @brief 以任意缓冲区构造字节切片。
+ *
+ * @param data 数据起始地址。
+ * @param size 数据长度（字节）。
+ * @return 对应的字节切片。
+ */
+inline ByteSlice make_slice(const char* data, std::size_t size) {
+    ByteSlice slice = {data, size};
+    return slice;
+}
+
+}  // namespace minigit
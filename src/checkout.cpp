@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <dirent.h>
+#include <map>
 #include <string>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -105,59 +106,38 @@ bool remove_tree_except_root(const std::string& root_path) {
     return true;
 }
 
-// 根据 tree 条目递归写回目录结构
-bool restore_tree(minigit::ObjectStore& store,
-                  const std::string& root_dir,
-                  const std::string& tree_hash) {
-    std::string tree_content;
-    if (!store.read_object(tree_hash, tree_content)) {
-        return false;
+// 逐级创建文件路径中的父目录，已存在的目录保持不变
+bool make_parent_dirs(const std::string& root_dir, const std::string& rel) {
+    for (std::size_t pos = rel.find('/'); pos != std::string::npos;
+         pos = rel.find('/', pos + 1)) {
+        std::string dir = join_paths(root_dir, rel.substr(0, pos));
+        if (::mkdir(dir.c_str(), 0777) != 0) {
+            struct stat st;
+            if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    std::vector<minigit::TreeEntry> entries;
-    if (!minigit::parse_tree_object(tree_content, entries)) {
+// 将 blob 正文写入文件，已存在的文件被覆盖
+bool write_blob_file(const std::string& path, const minigit::ObjectView& blob) {
+    if (blob.type != minigit::ObjectType::kBlob) {
         return false;
     }
-
-    for (std::size_t i = 0; i < entries.size(); ++i) {
-        const minigit::TreeEntry& e = entries[i];
-        std::string path = join_paths(root_dir, e.name);
-
-        if (e.mode == "40000") {
-            if (::mkdir(path.c_str(), 0777) != 0) {
-                struct stat st;
-                if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
-                    return false;
-                }
-            }
-            if (!restore_tree(store, path, e.hash)) {
-                return false;
-            }
-        } else if (e.mode == "100644") {
-            std::string blob_data;
-            if (!store.read_object(e.hash, blob_data)) {
-                return false;
-            }
-            std::FILE* fp = std::fopen(path.c_str(), "wb");
-            if (!fp) {
-                return false;
-            }
-            if (!blob_data.empty()) {
-                std::size_t written =
-                    std::fwrite(blob_data.data(), 1, blob_data.size(), fp);
-                if (written != blob_data.size()) {
-                    std::fclose(fp);
-                    return false;
-                }
-            }
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+    if (blob.size > 0) {
+        std::size_t written = std::fwrite(blob.data, 1, blob.size, fp);
+        if (written != blob.size) {
             std::fclose(fp);
-        } else {
-            // 暂不处理其他文件模式
-            continue;
+            return false;
         }
     }
-
-    return true;
+    return std::fclose(fp) == 0;
 }
 
 }  // namespace
@@ -170,19 +150,38 @@ bool checkout_tree(ObjectStore& store,
     if (!remove_tree_except_root(root_dir)) {
         return false;
     }
-    return restore_tree(store, root_dir, tree_hash);
+    // 先展开 tree 并建好目录，再按磁盘顺序批量读取全部 blob；相同内容可能写到多个路径
+    std::vector<IndexEntry> files;
+    if (!flatten_tree_to_index(store, tree_hash, files)) {
+        return false;
+    }
+    std::multimap<std::string, std::string> paths;
+    std::vector<std::string> hashes;
+    hashes.reserve(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (!make_parent_dirs(root_dir, files[i].path)) {
+            return false;
+        }
+        paths.insert(std::make_pair(files[i].hash, join_paths(root_dir, files[i].path)));
+        hashes.push_back(files[i].hash);
+    }
+    return store.read_many(hashes, [&paths](const std::string& hash, const ObjectView& blob) {
+        auto range = paths.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (!write_blob_file(it->second, blob)) {
+                return false;
+            }
+        }
+        return true;
+    });
 }
 
 bool checkout_commit(ObjectStore& store,
                      const std::string& root_dir,
                      const std::string& commit_hash) {
-    std::string content;
-    if (!store.read_object(commit_hash, content)) {
-        return false;
-    }
-
+    ReadContext ctx;
     Commit commit;
-    if (!parse_commit_object(content, commit)) {
+    if (!read_commit(store, commit_hash, ctx, commit)) {
         return false;
     }
 
@@ -15,7 +15,7 @@ namespace minigit {
  *
  * 当前实现采用“清空再重建”的策略：
  *   1. 删除工作目录下除 .minigit 以外的所有文件和子目录；
- *   2. 递归展开 tree，将 blob 写回文件系统。
+ *   2. 展开 tree 并创建目录，再用 ObjectStore::read_many 按磁盘顺序批量读取 blob 写回文件。
  *
  * @param store     对象存储实例，用于读取 tree 与 blob 对象内容。
  * @param root_dir  工作区根目录路径，例如 "."。
@@ -1,25 +1,63 @@
 #include "commit.h"
 
 #include <cstddef>
+#include <cstring>
 #include <string>
 
 // 本文件实现 commit 对象的编码、解码及写入逻辑
 namespace {
 
-// 从给定位置读取一行（包含到换行符之前），返回行内容并更新索引
-std::string read_line(const std::string& s, std::size_t& index) {
-    if (index >= s.size()) {
-        return std::string();
+// 从正文中逐行解析头部字段与提交消息，字段以 assign 写入以复用容量
+bool parse_commit_body(const char* data, std::size_t size,
+                       minigit::Commit& commit) {
+    commit.tree.clear();
+    commit.author.clear();
+    commit.committer.clear();
+    commit.message.clear();
+    std::size_t parent_count = 0;
+
+    const char* p = data;
+    const char* end = data + size;
+
+    // 逐行解析头部字段，直到遇到空行
+    while (p < end) {
+        const char* eol =
+            static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        const char* line_end = eol ? eol : end;
+        std::size_t len = static_cast<std::size_t>(line_end - p);
+        const char* next = eol ? eol + 1 : end;
+
+        if (len == 0) {
+            // 空行：后续为提交消息
+            p = next;
+            break;
+        }
+
+        if (len >= 5 && std::memcmp(p, "tree ", 5) == 0) {
+            commit.tree.assign(p + 5, line_end);
+        } else if (len >= 7 && std::memcmp(p, "parent ", 7) == 0) {
+            if (parent_count == commit.parents.size()) {
+                commit.parents.push_back(std::string());
+            }
+            commit.parents[parent_count++].assign(p + 7, line_end);
+        } else if (len >= 7 && std::memcmp(p, "author ", 7) == 0) {
+            commit.author.assign(p + 7, line_end);
+        } else if (len >= 10 && std::memcmp(p, "committer ", 10) == 0) {
+            commit.committer.assign(p + 10, line_end);
+        }
+        // 未识别的头字段，保持兼容性：忽略该行
+
+        p = next;
     }
-    std::size_t pos = s.find('\n', index);
-    if (pos == std::string::npos) {
-        std::string line = s.substr(index);
-        index = s.size();
-        return line;
+    commit.parents.resize(parent_count);
+
+    if (p < end) {
+        // 剩余部分全部作为提交消息
+        commit.message.assign(p, end);
     }
-    std::string line = s.substr(index, pos - index);
-    index = pos + 1;
-    return line;
+
+    // 最基本的有效性检查：必须至少包含 tree
+    return !commit.tree.empty();
 }
 
 }  // namespace
@@ -61,55 +99,35 @@ std::string build_commit_object(const Commit& commit) {
 }
 
 bool parse_commit_object(const std::string& content, Commit& commit) {
-    commit = Commit();
-
     std::size_t idx = 0;
 
     // 兼容两种输入：带头部的完整对象 或 仅正文
     std::size_t pos = content.find('\0');
     if (pos != std::string::npos) {
-        std::string header = content.substr(0, pos);
-        if (header.compare(0, 7, "commit ") == 0) {
+        if (content.compare(0, 7, "commit ") == 0) {
             idx = pos + 1;
-        } else {
-            idx = 0;
         }
     }
 
-    // 逐行解析头部字段，直到遇到空行
-    while (idx < content.size()) {
-        std::size_t line_start = idx;
-        std::string line = read_line(content, idx);
-
-        if (line.empty()) {
-            // 空行：后续为提交消息
-            break;
-        }
-
-        if (line.compare(0, 5, "tree ") == 0) {
-            commit.tree = line.substr(5);
-        } else if (line.compare(0, 7, "parent ") == 0) {
-            commit.parents.push_back(line.substr(7));
-        } else if (line.compare(0, 7, "author ") == 0) {
-            commit.author = line.substr(7);
-        } else if (line.compare(0, 10, "committer ") == 0) {
-            commit.committer = line.substr(10);
-        } else {
-            // 未识别的头字段，保持兼容性：忽略该行
-            (void)line_start;
-        }
-    }
+    return parse_commit_body(content.data() + idx, content.size() - idx, commit);
+}
 
-    if (idx < content.size()) {
-        // 剩余部分全部作为提交消息
-        commit.message = content.substr(idx);
+// 校验视图类型后直接在视图缓冲区上解析
+bool parse_commit_object(const ObjectView& view, Commit& commit) {
+    if (view.type != ObjectType::kCommit) {
+        return false;
     }
+    return parse_commit_body(view.data, view.size, commit);
+}
 
-    // 最基本的有效性检查：必须至少包含 tree
-    if (commit.tree.empty()) {
+// 通过读取上下文读取 commit 对象并解析
+bool read_commit(ObjectStore& store, const std::string& hash, ReadContext& ctx,
+                 Commit& commit) {
+    ObjectView view;
+    if (!store.read_object(hash, ctx, view)) {
         return false;
     }
-    return true;
+    return parse_commit_object(view, commit);
 }
 
 std::string write_commit(ObjectStore& store, const Commit& commit) {
@@ -117,6 +135,28 @@ std::string write_commit(ObjectStore& store, const Commit& commit) {
     return store.store_commit(content);
 }
 
+CommitCache::CommitCache(std::size_t max_commits) : cache_(max_commits) {}
+
+// 先查缓存，未命中时读取解析并放入缓存；禁用缓存时使用内部暂存对象
+const Commit* CommitCache::lookup(ObjectStore& store, const std::string& hash) {
+    const Commit* hit = cache_.get(hash);
+    if (hit) {
+        return hit;
+    }
+    if (!read_commit(store, hash, ctx_, scratch_)) {
+        return nullptr;
+    }
+    if (cache_.capacity() == 0) {
+        return &scratch_;
+    }
+    cache_.put(hash, scratch_, 1);
+    return cache_.get(hash);
+}
+
+void CommitCache::set_capacity(std::size_t max_commits) {
+    cache_.set_capacity(max_commits);
+}
+
 }  // namespace minigit
 
 #include <ctime>
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 
+#include "lru_cache.h"
 #include "object_store.h"
 
 // 本文件声明 commit 对象及 commit DAG 相关接口
@@ -56,6 +57,32 @@ std::string build_commit_object(const Commit& commit);
  */
 bool parse_commit_object(const std::string& content, Commit& commit);
 
+/**
+ * @brief 在对象视图上原地解析 commit 对象。
+ *
+ * 会校验视图类型必须为 commit。字段通过 assign 写入 commit，
+ * 复用同一个 Commit 实例反复解析时可沿用其字符串与父列表的容量。
+ *
+ * @param view   ObjectStore::read_object 返回的对象视图。
+ * @param commit 输出参数，用于接收解析后的结果。
+ * @return 类型正确且解析成功返回 true，否则返回 false。
+ */
+bool parse_commit_object(const ObjectView& view, Commit& commit);
+
+/**
+ * @brief 读取并解析指定哈希的 commit 对象。
+ *
+ * 历史遍历时复用同一个 ctx 与 commit，可使每个提交几乎不产生堆分配。
+ *
+ * @param store  对象存储实例。
+ * @param hash   commit 对象哈希。
+ * @param ctx    可复用的读取上下文。
+ * @param commit 输出参数，用于接收解析后的结果。
+ * @return 对象存在、类型为 commit 且解析成功时返回 true。
+ */
+bool read_commit(ObjectStore& store, const std::string& hash, ReadContext& ctx,
+                 Commit& commit);
+
 /**
  * @brief 使用对象存储写入 commit 对象并返回其哈希。
  *
@@ -67,6 +94,43 @@ bool parse_commit_object(const std::string& content, Commit& commit);
  */
 std::string write_commit(ObjectStore& store, const Commit& commit);
 
+/**
+ * @brief 已解析 commit 的 LRU 缓存。
+ *
+ * 历史遍历（log、合并基准查找等）会反复访问相同的提交，
+ * 缓存解析结果可以同时省去磁盘读取、解压与解析。commit 对象不可变，无需失效处理。
+ */
+class CommitCache {
+public:
+    /**
+     * @brief 使用给定条目上限构造缓存。
+     *
+     * @param max_commits 最多缓存的提交数量，0 表示禁用缓存（每次都重新读取）。
+     */
+    explicit CommitCache(std::size_t max_commits);
+
+    /**
+     * @brief 查找提交，未命中时从对象存储读取并解析后放入缓存。
+     *
+     * @param store 对象存储实例。
+     * @param hash  commit 对象哈希。
+     * @return 成功返回指向提交的指针，在下一次调用 lookup 之前有效；失败返回 nullptr。
+     */
+    const Commit* lookup(ObjectStore& store, const std::string& hash);
+
+    /**
+     * @brief 调整条目上限。
+     *
+     * @param max_commits 新的条目上限。
+     */
+    void set_capacity(std::size_t max_commits);
+
+private:
+    LruCache<std::string, Commit> cache_;
+    ReadContext ctx_;
+    Commit scratch_;
+};
+
 std::string build_identity_from_env(const char* name_env, const char* email_env, const char* date_env);
 
 }  // namespace minigit
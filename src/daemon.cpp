@@ -0,0 +1,259 @@
+#include "daemon.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 本文件实现基于 Unix 域套接字的 daemon 服务端与客户端
+namespace {
+
+// 单个帧字段的长度上限，防止异常请求导致超大内存分配
+const std::uint32_t kMaxFieldSize = 256U * 1024U * 1024U;
+
+// 单个请求允许的最大参数个数
+const std::uint32_t kMaxArgs = 4096U;
+
+// 已接受连接上单次收发的超时秒数，防止停滞的客户端阻塞串行的 serve 循环
+const long kConnectionTimeoutSeconds = 10;
+
+// 收到 SIGTERM/SIGINT 时置位，serve 循环据此退出
+volatile std::sig_atomic_t g_terminate = 0;
+
+// 终止信号处理函数，仅设置标志位
+void on_terminate_signal(int /*signo*/) {
+    g_terminate = 1;
+}
+
+// 将缓冲区完整写入套接字，处理短写与 EINTR
+bool send_all(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// 从套接字完整读取 size 字节，对端提前关闭时返回 false
+bool recv_all(int fd, char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// 以 32 位大端序追加整数
+void append_u32(std::string& out, std::uint32_t v) {
+    out.push_back(static_cast<char>((v >> 24) & 0xff));
+    out.push_back(static_cast<char>((v >> 16) & 0xff));
+    out.push_back(static_cast<char>((v >> 8) & 0xff));
+    out.push_back(static_cast<char>(v & 0xff));
+}
+
+// 以 "长度 + 字节" 形式追加一个字段
+void append_field(std::string& out, const std::string& field) {
+    append_u32(out, static_cast<std::uint32_t>(field.size()));
+    out.append(field);
+}
+
+// 读取一个 32 位大端序整数
+bool recv_u32(int fd, std::uint32_t& v) {
+    unsigned char b[4];
+    if (!recv_all(fd, reinterpret_cast<char*>(b), sizeof(b))) {
+        return false;
+    }
+    v = (static_cast<std::uint32_t>(b[0]) << 24) |
+        (static_cast<std::uint32_t>(b[1]) << 16) |
+        (static_cast<std::uint32_t>(b[2]) << 8) |
+        static_cast<std::uint32_t>(b[3]);
+    return true;
+}
+
+// 读取一个 "长度 + 字节" 字段
+bool recv_field(int fd, std::string& field) {
+    std::uint32_t len = 0;
+    if (!recv_u32(fd, len) || len > kMaxFieldSize) {
+        return false;
+    }
+    field.resize(len);
+    return len == 0 || recv_all(fd, &field[0], len);
+}
+
+// 填充 Unix 域套接字地址，路径过长时返回 false
+bool make_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 连接到指定路径的套接字，失败返回 -1
+int connect_socket(const std::string& path) {
+    sockaddr_un addr;
+    if (!make_address(path, addr)) {
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}  // namespace
+
+namespace minigit {
+
+DaemonServer::DaemonServer(std::string socket_path)
+    : socket_path_(std::move(socket_path)), listen_fd_(-1), stop_(false) {}
+
+DaemonServer::~DaemonServer() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(socket_path_.c_str());
+    }
+}
+
+// 检测已有实例并清理残留套接字文件后绑定监听
+bool DaemonServer::listen() {
+    int probe = connect_socket(socket_path_);
+    if (probe >= 0) {
+        ::close(probe);
+        return false;
+    }
+    ::unlink(socket_path_.c_str());
+
+    sockaddr_un addr;
+    if (!make_address(socket_path_, addr)) {
+        return false;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    mode_t old_mask = ::umask(0077);
+    int rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (rc != 0 || ::listen(fd, 64) != 0) {
+        ::close(fd);
+        return false;
+    }
+    listen_fd_ = fd;
+    return true;
+}
+
+// 串行接受连接：读取参数、调用处理函数并回写应答
+void DaemonServer::serve(const Handler& handler) {
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_terminate_signal;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(SIGTERM, &sa, nullptr);
+    ::sigaction(SIGINT, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    while (!stop_ && !g_terminate) {
+        int conn = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = kConnectionTimeoutSeconds;
+        timeout.tv_usec = 0;
+        ::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        std::uint32_t argc = 0;
+        std::vector<std::string> args;
+        bool ok = recv_u32(conn, argc) && argc <= kMaxArgs;
+        for (std::uint32_t i = 0; ok && i < argc; ++i) {
+            std::string arg;
+            ok = recv_field(conn, arg);
+            args.push_back(arg);
+        }
+        if (!ok) {
+            ::close(conn);
+            continue;
+        }
+
+        std::string out;
+        std::string err;
+        int code = handler(args, out, err);
+
+        std::string reply;
+        reply.reserve(12U + out.size() + err.size());
+        append_u32(reply, static_cast<std::uint32_t>(code));
+        append_field(reply, out);
+        append_field(reply, err);
+        send_all(conn, reply.data(), reply.size());
+        ::close(conn);
+    }
+}
+
+void DaemonServer::request_stop() {
+    stop_ = true;
+}
+
+// 连接 daemon，发送参数帧并等待应答
+bool daemon_request(const std::string& socket_path,
+                    const std::vector<std::string>& args,
+                    DaemonResponse& response) {
+    int fd = connect_socket(socket_path);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::string request;
+    append_u32(request, static_cast<std::uint32_t>(args.size()));
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        append_field(request, args[i]);
+    }
+
+    std::uint32_t code = 0;
+    bool ok = send_all(fd, request.data(), request.size()) &&
+              recv_u32(fd, code) &&
+              recv_field(fd, response.out) &&
+              recv_field(fd, response.err);
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+    response.exit_code = static_cast<int>(code);
+    return true;
+}
+
+}  // namespace minigit
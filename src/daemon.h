@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 本文件声明 mini-git 常驻服务（daemon）的服务端与客户端接口
+namespace minigit {
+
+/**
+ * @brief daemon 对单个请求的应答。
+ */
+struct DaemonResponse {
+    /// 命令退出码。
+    int exit_code;
+    /// 命令写往标准输出的内容。
+    std::string out;
+    /// 命令写往标准错误的内容。
+    std::string err;
+};
+
+/**
+ * @brief 基于 Unix 域套接字的常驻请求服务。
+ *
+ * 协议为简单的长度前缀帧，所有整数均为 32 位大端序：
+ *   请求：<参数个数> 后接每个参数的 <长度><字节>；
+ *   应答：<退出码><stdout 长度><stdout 字节><stderr 长度><stderr 字节>。
+ * 每个连接只处理一个请求。请求按到达顺序串行处理，
+ * 因此处理函数可以安全地共享进程内缓存。
+ */
+class DaemonServer {
+public:
+    /**
+     * @brief 请求处理函数：输入参数列表，填充输出并返回退出码。
+     */
+    typedef std::function<int(const std::vector<std::string>& args,
+                              std::string& out, std::string& err)> Handler;
+
+    /**
+     * @brief 使用套接字路径构造服务端，此时尚未监听。
+     *
+     * @param socket_path Unix 域套接字路径，例如 ".minigit/daemon.sock"。
+     */
+    explicit DaemonServer(std::string socket_path);
+
+    /**
+     * @brief 关闭监听套接字并删除套接字文件。
+     */
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    /**
+     * @brief 绑定并开始监听套接字。
+     *
+     * 若路径上已存在可连接的套接字，说明已有 daemon 在运行，返回 false；
+     * 若是上次异常退出残留的套接字文件，则先删除再绑定。
+     *
+     * @return 监听成功返回 true，否则返回 false。
+     */
+    bool listen();
+
+    /**
+     * @brief 循环接受并处理请求，直到 request_stop 被调用或收到终止信号。
+     *
+     * @param handler 请求处理函数。
+     */
+    void serve(const Handler& handler);
+
+    /**
+     * @brief 请求在当前请求处理完成后退出 serve 循环。
+     */
+    void request_stop();
+
+private:
+    std::string socket_path_;
+    int listen_fd_;
+    bool stop_;
+};
+
+/**
+ * @brief 将一次命令调用转发给正在运行的 daemon。
+ *
+ * @param socket_path daemon 的套接字路径。
+ * @param args        命令参数（不含程序名）。
+ * @param response    输出参数，用于接收 daemon 的应答。
+ * @return 成功完成一次请求返回 true；套接字不存在或无法连接时返回 false，
+ *         调用方应回退为在本进程内执行。
+ */
+bool daemon_request(const std::string& socket_path,
+                    const std::vector<std::string>& args,
+                    DaemonResponse& response);
+
+}  // namespace minigit
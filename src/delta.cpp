@@ -0,0 +1,241 @@
+#include "delta.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 本文件实现基于块哈希的 delta 生成与应用
+namespace {
+
+const std::uint32_t kPrime = 0x01000193U;
+const std::uint32_t kNone = 0xffffffffU;
+// 每个哈希桶最多比较的候选块数，避免高度重复的数据退化为平方复杂度
+const std::size_t kMaxChain = 64;
+// 单条复制指令的最大长度（三字节长度字段）
+const std::size_t kMaxCopy = 0xffffffU;
+
+// 计算一个块的多项式哈希，与 roll_hash 的滚动更新保持一致
+std::uint32_t block_hash(const unsigned char* p) {
+    std::uint32_t h = 0;
+    for (std::size_t i = 0; i < minigit::DeltaIndex::kBlockSize; ++i) {
+        h = h * kPrime + p[i];
+    }
+    return h;
+}
+
+// 预先计算 kPrime^(kBlockSize-1)，用于移出窗口首字节
+std::uint32_t top_power() {
+    std::uint32_t p = 1;
+    for (std::size_t i = 1; i < minigit::DeltaIndex::kBlockSize; ++i) {
+        p *= kPrime;
+    }
+    return p;
+}
+
+void put_varint(std::string& out, std::size_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool get_varint(const unsigned char*& p, const unsigned char* end, std::size_t& v) {
+    v = 0;
+    unsigned shift = 0;
+    while (p < end && shift < 64) {
+        unsigned char c = *p++;
+        v |= static_cast<std::size_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+// 以不超过 127 字节的插入指令输出待插入的字面数据
+void flush_insert(std::string& out, const char* data, std::size_t size) {
+    while (size > 0) {
+        std::size_t n = size > 127U ? 127U : size;
+        out.push_back(static_cast<char>(n));
+        out.append(data, n);
+        data += n;
+        size -= n;
+    }
+}
+
+// 输出复制指令：只写入非零的偏移与长度字节，并在指令字节中置对应标志位
+void emit_copy(std::string& out, std::size_t offset, std::size_t size) {
+    std::size_t op_pos = out.size();
+    unsigned char op = 0x80;
+    out.push_back(0);
+    for (unsigned i = 0; i < 4; ++i) {
+        unsigned char b = static_cast<unsigned char>((offset >> (8 * i)) & 0xff);
+        if (b) {
+            op |= static_cast<unsigned char>(1U << i);
+            out.push_back(static_cast<char>(b));
+        }
+    }
+    for (unsigned i = 0; i < 3; ++i) {
+        unsigned char b = static_cast<unsigned char>((size >> (8 * i)) & 0xff);
+        if (b) {
+            op |= static_cast<unsigned char>(0x10U << i);
+            out.push_back(static_cast<char>(b));
+        }
+    }
+    out[op_pos] = static_cast<char>(op);
+}
+
+}  // namespace
+
+namespace minigit {
+
+// 按块长度步进计算基准数据各块的哈希，以链表形式挂入哈希桶
+DeltaIndex::DeltaIndex(const char* base, std::size_t size)
+    : base_(base), size_(size), mask_(0) {
+    std::size_t blocks = size / kBlockSize;
+    if (blocks == 0) {
+        return;
+    }
+    std::size_t table = 1;
+    while (table < blocks) {
+        table <<= 1;
+    }
+    mask_ = static_cast<std::uint32_t>(table - 1);
+    heads_.assign(table, kNone);
+    next_.assign(blocks, kNone);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(base);
+    // 逆序插入使链表中偏移较小的块排在前面
+    for (std::size_t b = blocks; b-- > 0;) {
+        std::uint32_t slot = block_hash(p + b * kBlockSize) & mask_;
+        next_[b] = heads_[slot];
+        heads_[slot] = static_cast<std::uint32_t>(b);
+    }
+}
+
+// 在目标数据上滚动计算块哈希，命中基准块后向前后两个方向扩展为最长匹配
+bool create_delta(const DeltaIndex& index, const char* target, std::size_t target_size,
+                  std::size_t max_size, std::string& out) {
+    out.clear();
+    put_varint(out, index.size_);
+    put_varint(out, target_size);
+
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(index.base_);
+    const unsigned char* t = reinterpret_cast<const unsigned char*>(target);
+    const std::size_t block = DeltaIndex::kBlockSize;
+    const std::uint32_t top = top_power();
+
+    std::size_t insert_start = 0;
+    std::size_t i = 0;
+    bool have_hash = false;
+    std::uint32_t h = 0;
+    while (i + block <= target_size && !index.heads_.empty()) {
+        if (!have_hash) {
+            h = block_hash(t + i);
+            have_hash = true;
+        }
+        std::size_t best_len = 0;
+        std::size_t best_off = 0;
+        std::size_t best_back = 0;
+        std::uint32_t b = index.heads_[h & index.mask_];
+        for (std::size_t chain = 0; b != kNone && chain < kMaxChain;
+             b = index.next_[b], ++chain) {
+            std::size_t off = static_cast<std::size_t>(b) * block;
+            if (std::memcmp(base + off, t + i, block) != 0) {
+                continue;
+            }
+            std::size_t len = block;
+            while (off + len < index.size_ && i + len < target_size &&
+                   len < kMaxCopy && base[off + len] == t[i + len]) {
+                ++len;
+            }
+            std::size_t back = 0;
+            while (back < i - insert_start && back < off && len + back < kMaxCopy &&
+                   base[off - back - 1] == t[i - back - 1]) {
+                ++back;
+            }
+            if (len + back > best_len + best_back) {
+                best_len = len;
+                best_off = off;
+                best_back = back;
+            }
+        }
+
+        if (best_len == 0) {
+            if (i + block < target_size) {
+                h = (h - t[i] * top) * kPrime + t[i + block];
+            }
+            ++i;
+            continue;
+        }
+        flush_insert(out, target + insert_start, i - best_back - insert_start);
+        emit_copy(out, best_off - best_back, best_len + best_back);
+        i += best_len;
+        insert_start = i;
+        have_hash = false;
+        if (max_size != 0 && out.size() > max_size) {
+            return false;
+        }
+    }
+    flush_insert(out, target + insert_start, target_size - insert_start);
+    return max_size == 0 || out.size() <= max_size;
+}
+
+// 逐条执行复制与插入指令，所有范围在执行前检查
+bool apply_delta(const char* base, std::size_t base_size, const char* delta,
+                 std::size_t delta_size, std::string& out) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(delta);
+    const unsigned char* end = p + delta_size;
+    std::size_t expect_base = 0;
+    std::size_t result_size = 0;
+    if (!get_varint(p, end, expect_base) || expect_base != base_size ||
+        !get_varint(p, end, result_size)) {
+        return false;
+    }
+    out.clear();
+    // result_size 来自未校验的 delta 头部，预留量按 delta 实际能产生的数据量封顶，
+    // 防止损坏的对象触发巨大的内存分配；超出预留时字符串自行增长
+    out.reserve(std::min(result_size, base_size + 64U * delta_size));
+    while (p < end) {
+        unsigned char op = *p++;
+        if (op & 0x80) {
+            std::size_t offset = 0;
+            std::size_t size = 0;
+            for (unsigned i = 0; i < 4; ++i) {
+                if (op & (1U << i)) {
+                    if (p >= end) {
+                        return false;
+                    }
+                    offset |= static_cast<std::size_t>(*p++) << (8 * i);
+                }
+            }
+            for (unsigned i = 0; i < 3; ++i) {
+                if (op & (0x10U << i)) {
+                    if (p >= end) {
+                        return false;
+                    }
+                    size |= static_cast<std::size_t>(*p++) << (8 * i);
+                }
+            }
+            if (size == 0) {
+                size = 0x10000;
+            }
+            if (offset > base_size || size > base_size - offset ||
+                size > result_size - out.size()) {
+                return false;
+            }
+            out.append(base + offset, size);
+        } else if (op != 0) {
+            if (static_cast<std::size_t>(end - p) < op || op > result_size - out.size()) {
+                return false;
+            }
+            out.append(reinterpret_cast<const char*>(p), op);
+            p += op;
+        } else {
+            return false;
+        }
+    }
+    return out.size() == result_size;
+}
+
+}  // namespace minigit
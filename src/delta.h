@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 本文件声明 copy/insert 形式的增量（delta）编码
+namespace minigit {
+
+/**
+ * @brief 基准数据的块索引，用于在目标数据中快速查找可复制的片段。
+ *
+ * 基准数据按固定长度分块计算哈希，同一个基准对多个目标生成 delta 时
+ * 只需建立一次索引。索引不复制基准数据，基准缓冲区需在索引使用期间保持有效。
+ */
+class DeltaIndex {
+public:
+    /**
+     * @brief 为基准数据建立块索引。
+     *
+     * @param base 基准数据起始地址。
+     * @param size 基准数据长度（字节）。
+     */
+    DeltaIndex(const char* base, std::size_t size);
+
+    const char* base() const { return base_; }
+    std::size_t size() const { return size_; }
+
+    /// 建立索引时使用的块长度，也是可被编码为复制指令的最短匹配长度。
+    static const std::size_t kBlockSize = 16;
+
+private:
+    friend bool create_delta(const DeltaIndex& index, const char* target,
+                             std::size_t target_size, std::size_t max_size,
+                             std::string& out);
+
+    const char* base_;
+    std::size_t size_;
+    std::uint32_t mask_;
+    std::vector<std::uint32_t> heads_;
+    std::vector<std::uint32_t> next_;
+};
+
+/**
+ * @brief 生成把基准数据变换为目标数据的 delta。
+ *
+ * delta 格式与 Git 相同：开头为基准长度与结果长度两个变长整数，随后是指令序列。
+ * 最高位为 1 的指令表示从基准复制（后续字节按标志位给出偏移与长度），
+ * 1~127 表示随后紧跟的若干字节原样插入。
+ *
+ * @param index       基准数据的块索引。
+ * @param target      目标数据起始地址。
+ * @param target_size 目标数据长度。
+ * @param max_size    delta 长度上限，为 0 表示不限制。
+ * @param out         输出参数，生成的 delta。
+ * @return 生成成功且长度不超过上限时返回 true，否则返回 false。
+ */
+bool create_delta(const DeltaIndex& index, const char* target, std::size_t target_size,
+                  std::size_t max_size, std::string& out);
+
+/**
+ * @brief 将 delta 应用到基准数据上，重建目标数据。
+ *
+ * 会校验 delta 中记录的基准长度、每条复制指令的范围以及最终结果长度。
+ *
+ * @param base       基准数据起始地址。
+ * @param base_size  基准数据长度。
+ * @param delta      delta 起始地址。
+ * @param delta_size delta 长度。
+ * @param out        输出参数，重建的目标数据，复用其已有容量。
+ * @return delta 合法时返回 true，否则返回 false。
+ */
+bool apply_delta(const char* base, std::size_t base_size, const char* delta,
+                 std::size_t delta_size, std::string& out);
+
+}  // namespace minigit
@@ -0,0 +1,175 @@
+#include "ewah.h"
+
+// 本文件实现未压缩位图的集合运算与 EWAH 编解码
+namespace {
+
+const std::uint64_t kAllOnes = ~static_cast<std::uint64_t>(0);
+// 标记字中游程长度与字面字个数两个字段的上限
+const std::uint64_t kMaxRun = 0xffffffffULL;
+const std::uint64_t kMaxLiterals = 0x7fffffffULL;
+
+void put_u32_be(std::string& out, std::uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((v >> shift) & 0xff));
+    }
+}
+
+void put_u64_be(std::string& out, std::uint64_t v) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((v >> shift) & 0xff));
+    }
+}
+
+std::uint64_t get_be(const char* data, int bytes) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// 计算 64 位字中置 1 的位数
+std::size_t popcount64(std::uint64_t v) {
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<std::size_t>((v * 0x0101010101010101ULL) >> 56);
+}
+
+}  // namespace
+
+namespace minigit {
+
+void Bitmap::set(std::size_t pos) {
+    std::size_t word = pos / 64U;
+    if (word >= words_.size()) {
+        words_.resize(word + 1U, 0);
+    }
+    words_[word] |= static_cast<std::uint64_t>(1) << (pos % 64U);
+}
+
+bool Bitmap::get(std::size_t pos) const {
+    std::size_t word = pos / 64U;
+    return word < words_.size() && ((words_[word] >> (pos % 64U)) & 1U) != 0;
+}
+
+void Bitmap::or_with(const Bitmap& other) {
+    if (other.words_.size() > words_.size()) {
+        words_.resize(other.words_.size(), 0);
+    }
+    for (std::size_t i = 0; i < other.words_.size(); ++i) {
+        words_[i] |= other.words_[i];
+    }
+}
+
+void Bitmap::and_with(const Bitmap& other) {
+    if (words_.size() > other.words_.size()) {
+        words_.resize(other.words_.size());
+    }
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+        words_[i] &= other.words_[i];
+    }
+}
+
+void Bitmap::and_not(const Bitmap& other) {
+    std::size_t n = words_.size() < other.words_.size() ? words_.size() : other.words_.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        words_[i] &= ~other.words_[i];
+    }
+}
+
+std::size_t Bitmap::count() const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+        n += popcount64(words_[i]);
+    }
+    return n;
+}
+
+// 逐字跳过全 0 的字，在非零字内逐位取出最低的 1
+void Bitmap::positions(std::vector<std::size_t>& out) const {
+    out.clear();
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+        std::uint64_t w = words_[i];
+        while (w != 0) {
+            std::uint64_t low = w & (~w + 1U);
+            out.push_back(i * 64U + popcount64(low - 1U));
+            w ^= low;
+        }
+    }
+}
+
+void Bitmap::clear() {
+    words_.clear();
+}
+
+// 交替收集全 0/全 1 字的游程与随后的字面字，每组输出一个标记字
+void ewah_encode(const Bitmap& bitmap, std::string& out) {
+    const std::vector<std::uint64_t>& words = bitmap.words();
+    std::string body;
+    std::uint32_t compressed = 0;
+    std::size_t i = 0;
+    while (i < words.size()) {
+        bool run_bit = words[i] == kAllOnes;
+        std::uint64_t fill = run_bit ? kAllOnes : 0;
+        std::uint64_t run = 0;
+        while (i < words.size() && words[i] == fill && run < kMaxRun) {
+            ++run;
+            ++i;
+        }
+        std::size_t literal_start = i;
+        while (i < words.size() && words[i] != 0 && words[i] != kAllOnes &&
+               i - literal_start < kMaxLiterals) {
+            ++i;
+        }
+        std::uint64_t literals = i - literal_start;
+        put_u64_be(body, (run_bit ? 1U : 0U) | (run << 1) | (literals << 33));
+        for (std::size_t k = literal_start; k < i; ++k) {
+            put_u64_be(body, words[k]);
+        }
+        compressed += static_cast<std::uint32_t>(1U + literals);
+    }
+    put_u32_be(out, static_cast<std::uint32_t>(words.size()));
+    put_u32_be(out, compressed);
+    out.append(body);
+}
+
+// 逐组展开标记字，检查展开后的字数与头部记录一致
+bool ewah_decode(const char* data, std::size_t size, Bitmap& out, std::size_t& consumed) {
+    if (size < 8U) {
+        return false;
+    }
+    std::size_t word_count = static_cast<std::size_t>(get_be(data, 4));
+    std::size_t compressed = static_cast<std::size_t>(get_be(data + 4, 4));
+    if (compressed > (size - 8U) / 8U) {
+        return false;
+    }
+    std::vector<std::uint64_t>& words = out.words();
+    words.clear();
+    words.reserve(word_count);
+    const char* p = data + 8;
+    std::size_t k = 0;
+    while (k < compressed) {
+        std::uint64_t marker = get_be(p + k * 8U, 8);
+        ++k;
+        std::uint64_t run = (marker >> 1) & kMaxRun;
+        std::uint64_t literals = marker >> 33;
+        if (run > word_count - words.size() || literals > compressed - k ||
+            literals > word_count - words.size() - run) {
+            return false;
+        }
+        words.insert(words.end(), static_cast<std::size_t>(run),
+                     (marker & 1U) ? kAllOnes : 0);
+        for (std::uint64_t l = 0; l < literals; ++l, ++k) {
+            words.push_back(get_be(p + k * 8U, 8));
+        }
+    }
+    if (words.size() != word_count) {
+        return false;
+    }
+    consumed = 8U + compressed * 8U;
+    return true;
+}
+
+}  // namespace minigit
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 本文件声明未压缩位图及其 EWAH 压缩编码
+namespace minigit {
+
+/**
+ * @brief 按 64 位字存储的未压缩位图。
+ *
+ * 长度随 set 自动增长，未设置的高位视为 0；
+ * 集合运算在两个位图长度不同时按较短的一方补 0 处理。
+ */
+class Bitmap {
+public:
+    /**
+     * @brief 将第 pos 位置 1。
+     */
+    void set(std::size_t pos);
+
+    /**
+     * @brief 返回第 pos 位是否为 1，超出长度返回 false。
+     */
+    bool get(std::size_t pos) const;
+
+    /**
+     * @brief 按位或：this |= other。
+     */
+    void or_with(const Bitmap& other);
+
+    /**
+     * @brief 按位与：this &= other。
+     */
+    void and_with(const Bitmap& other);
+
+    /**
+     * @brief 按位与非：this &= ~other，用于求 "A 可达但 B 不可达"。
+     */
+    void and_not(const Bitmap& other);
+
+    /**
+     * @brief 返回置 1 的位数。
+     */
+    std::size_t count() const;
+
+    /**
+     * @brief 按升序输出所有置 1 的位置。
+     */
+    void positions(std::vector<std::size_t>& out) const;
+
+    /**
+     * @brief 清空位图。
+     */
+    void clear();
+
+    /**
+     * @brief 返回底层的 64 位字数组，第 i 位位于 words()[i / 64] 的第 i % 64 位。
+     */
+    const std::vector<std::uint64_t>& words() const { return words_; }
+    std::vector<std::uint64_t>& words() { return words_; }
+
+private:
+    std::vector<std::uint64_t> words_;
+};
+
+/**
+ * @brief 将位图编码为 EWAH（Enhanced Word-Aligned Hybrid）压缩格式并追加到 out。
+ *
+ * 编码（整数均为大端序）：u32 字数 + u32 压缩后 u64 个数 + 压缩后的 u64 序列。
+ * 压缩序列由若干组 "游程标记字 + 若干字面字" 组成：标记字第 0 位为游程的填充值，
+ * 第 1~32 位为全 0 或全 1 字的重复次数，第 33~63 位为随后字面字的个数。
+ * 稀疏或成片连续的位图因此只占极少空间。
+ *
+ * @param bitmap 待编码的位图。
+ * @param out    输出参数，编码结果追加到末尾。
+ */
+void ewah_encode(const Bitmap& bitmap, std::string& out);
+
+/**
+ * @brief 解码 EWAH 格式的位图。
+ *
+ * @param data     编码数据起始地址。
+ * @param size     可用数据长度。
+ * @param out      输出参数，解码得到的位图。
+ * @param consumed 输出参数，编码占用的字节数。
+ * @return 数据完整且各段长度一致时返回 true，否则返回 false。
+ */
+bool ewah_decode(const char* data, std::size_t size, Bitmap& out, std::size_t& consumed);
+
+}  // namespace minigit
@@ -0,0 +1,837 @@
+#include "fast_import.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "byte_slice.h"
+#include "blob.h"
+#include "commit.h"
+#include "hash.h"
+#include "pack.h"
+#include "refs.h"
+#include "tree.h"
+
+// 本文件实现 fast-import：解析导入流，在内存中维护目录树并将对象写入包文件
+namespace {
+
+using minigit::ByteSlice;
+using minigit::ObjectView;
+
+// 内存中的目录树节点；目录节点在首次访问子节点时才从已有 tree 对象加载
+struct TreeNode {
+    bool is_dir;
+    /// 子节点是否已加载；新建目录视为已加载。
+    bool loaded;
+    /// 文件为 blob 哈希；目录为 tree 哈希，被修改后清空，提交时重新计算。
+    std::string hash;
+    /// 文件的 tree 条目模式，例如 "100644" 或 "100755"；目录不使用。
+    std::string mode;
+    std::map<std::string, std::unique_ptr<TreeNode> > children;
+};
+
+std::unique_ptr<TreeNode> make_dir(const std::string& tree_hash) {
+    std::unique_ptr<TreeNode> node(new TreeNode);
+    node->is_dir = true;
+    node->loaded = tree_hash.empty();
+    node->hash = tree_hash;
+    return node;
+}
+
+std::unique_ptr<TreeNode> make_file(const std::string& blob_hash, const std::string& mode) {
+    std::unique_ptr<TreeNode> node(new TreeNode);
+    node->is_dir = false;
+    node->loaded = true;
+    node->hash = blob_hash;
+    node->mode = mode;
+    return node;
+}
+
+// 判断字符串是否为 40 位小写十六进制哈希
+bool is_hex_hash(const std::string& s) {
+    if (s.size() != 40U) {
+        return false;
+    }
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 解析可能带 C 风格引号的路径，next 返回路径之后的位置
+bool parse_path(const std::string& s, std::size_t pos, bool to_end,
+                std::string& out, std::size_t& next) {
+    out.clear();
+    if (pos < s.size() && s[pos] == '"') {
+        std::size_t i = pos + 1;
+        while (i < s.size() && s[i] != '"') {
+            char c = s[i++];
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (i >= s.size()) {
+                return false;
+            }
+            char e = s[i++];
+            switch (e) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                default:
+                    if (e >= '0' && e <= '3' && i + 1 < s.size()) {
+                        int v = (e - '0') * 64 + (s[i] - '0') * 8 + (s[i + 1] - '0');
+                        out.push_back(static_cast<char>(v));
+                        i += 2;
+                    } else {
+                        return false;
+                    }
+            }
+        }
+        if (i >= s.size()) {
+            return false;
+        }
+        next = i + 1;
+    } else {
+        std::size_t end = to_end ? s.size() : s.find(' ', pos);
+        if (end == std::string::npos) {
+            return false;
+        }
+        out.assign(s, pos, end - pos);
+        next = end;
+    }
+    if (to_end && next != s.size()) {
+        return false;
+    }
+    return !out.empty() && out[0] != '/' && out[out.size() - 1] != '/';
+}
+
+// 按 '/' 拆分路径，拒绝空段与 "."、".." 段
+bool split_path(const std::string& path, std::vector<std::string>& parts) {
+    parts.clear();
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        std::size_t slash = path.find('/', start);
+        if (slash == std::string::npos) {
+            slash = path.size();
+        }
+        std::string part = path.substr(start, slash - start);
+        if (part.empty() || part == "." || part == ".." || part == ".minigit") {
+            return false;
+        }
+        parts.push_back(part);
+        start = slash + 1;
+    }
+    return !parts.empty();
+}
+
+class FastImporter {
+public:
+    FastImporter(minigit::ObjectStore& store, const minigit::FileSystem& fs,
+                 std::istream& in, std::ostream& out,
+                 minigit::FastImportStats& stats)
+        : store_(store), fs_(fs), in_(in), out_(out), stats_(stats),
+          line_no_(0), pending_(false), require_done_(false) {}
+
+    // 逐条执行导入流中的命令，出错时 error_ 中包含说明
+    bool run() {
+        if (!writer_.begin(fs_)) {
+            return fail("cannot create pack file");
+        }
+        std::string line;
+        bool done = false;
+        while (next_line(line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            bool ok = true;
+            if (line == "blob") {
+                ok = parse_blob();
+            } else if (starts_with(line, "commit ")) {
+                ok = parse_commit(line.substr(7));
+            } else if (starts_with(line, "reset ")) {
+                ok = parse_reset(line.substr(6));
+            } else if (line == "checkpoint") {
+                ok = checkpoint(true);
+            } else if (starts_with(line, "progress ")) {
+                out_ << line << "\n";
+                out_.flush();
+            } else if (line == "done") {
+                done = true;
+                break;
+            } else if (starts_with(line, "feature ")) {
+                ok = parse_feature(line.substr(8));
+            } else if (starts_with(line, "option ")) {
+                // 与 git 一致：面向其他工具的选项忽略，git 自身的选项均不支持
+                if (starts_with(line, "option git ")) {
+                    ok = fail("unsupported option: " + line.substr(7));
+                }
+            } else {
+                ok = fail("unsupported command: " + line);
+            }
+            if (!ok) {
+                writer_.abort();
+                return false;
+            }
+        }
+        if (require_done_ && !done) {
+            writer_.abort();
+            return fail("stream ended without done");
+        }
+        return checkpoint(false);
+    }
+
+    const std::string& error() const { return error_; }
+    std::size_t line_no() const { return line_no_; }
+
+private:
+    struct Branch {
+        std::string tip;
+        std::unique_ptr<TreeNode> root;
+    };
+
+    static bool starts_with(const std::string& s, const char* prefix) {
+        return s.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+
+    // 只接受不改变导入语义的特性，未知特性必须报错以免悄悄导入错误的历史
+    bool parse_feature(const std::string& feature) {
+        if (feature == "done") {
+            require_done_ = true;
+            return true;
+        }
+        if (feature == "date-format=raw") {
+            return true;
+        }
+        return fail("unsupported feature: " + feature);
+    }
+
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    bool next_line(std::string& line) {
+        if (pending_) {
+            pending_ = false;
+            line.swap(pending_line_);
+            return true;
+        }
+        if (!std::getline(in_, line)) {
+            return false;
+        }
+        ++line_no_;
+        return true;
+    }
+
+    void unread_line(std::string& line) {
+        pending_line_.swap(line);
+        pending_ = true;
+    }
+
+    // 读取 "data <n>" 或 "data <<分隔符" 之后的数据体
+    bool read_data(std::string& out) {
+        std::string line;
+        if (!next_line(line) || !starts_with(line, "data ")) {
+            return fail("expected data command");
+        }
+        out.clear();
+        if (starts_with(line, "data <<")) {
+            std::string delim = line.substr(7);
+            std::string body_line;
+            while (true) {
+                if (!std::getline(in_, body_line)) {
+                    return fail("unterminated delimited data");
+                }
+                ++line_no_;
+                if (body_line == delim) {
+                    return true;
+                }
+                out.append(body_line);
+                out.push_back('\n');
+            }
+        }
+        char* end = nullptr;
+        unsigned long long n = std::strtoull(line.c_str() + 5, &end, 10);
+        if (end == line.c_str() + 5 || *end != '\0') {
+            return fail("invalid data length: " + line);
+        }
+        out.resize(static_cast<std::size_t>(n));
+        if (n > 0 && !in_.read(&out[0], static_cast<std::streamsize>(n))) {
+            return fail("truncated data");
+        }
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            if (out[i] == '\n') {
+                ++line_no_;
+            }
+        }
+        if (in_.peek() == '\n') {
+            in_.get();
+        }
+        return true;
+    }
+
+    // 可选的 "mark :<n>" 行
+    bool read_mark(std::uint64_t& mark) {
+        mark = 0;
+        std::string line;
+        if (!next_line(line)) {
+            return true;
+        }
+        if (!starts_with(line, "mark :")) {
+            unread_line(line);
+            return true;
+        }
+        char* end = nullptr;
+        mark = std::strtoull(line.c_str() + 6, &end, 10);
+        if (mark == 0 || *end != '\0') {
+            return fail("invalid mark: " + line);
+        }
+        return true;
+    }
+
+    // 对象已存在于仓库或当前包时跳过，否则追加到当前包
+    bool put_object(const std::string& hash, const ByteSlice* slices,
+                    std::size_t count, std::size_t& counter) {
+        if (writer_.contains(hash) || store_.has_object(hash)) {
+            ++stats_.duplicates;
+            return true;
+        }
+        if (!writer_.add_object(hash, slices, count)) {
+            return fail("failed to write object " + hash);
+        }
+        ++counter;
+        return true;
+    }
+
+    bool store_blob(const std::string& data, std::string& hash) {
+        std::string header = minigit::build_blob_header(data.size());
+        ByteSlice slices[2] = {minigit::make_slice(header), minigit::make_slice(data)};
+        hash = minigit::sha1_hex(slices, 2);
+        return put_object(hash, slices, 2, stats_.blobs);
+    }
+
+    // 读取本次导入写入的对象或仓库中已有的对象
+    bool read_view(const std::string& hash, ObjectView& view) {
+        if (writer_.contains(hash)) {
+            if (!writer_.read_object(hash, scratch_)) {
+                return false;
+            }
+            std::size_t header_len = 0;
+            if (!minigit::parse_object_header(scratch_.data(), scratch_.size(),
+                                              view.type, view.size, header_len)) {
+                return false;
+            }
+            view.data = scratch_.data() + header_len;
+            return view.size == scratch_.size() - header_len;
+        }
+        return store_.read_object(hash, ctx_, view);
+    }
+
+    bool parse_blob() {
+        std::uint64_t mark = 0;
+        if (!read_mark(mark) || !read_data(data_)) {
+            return false;
+        }
+        std::string hash;
+        if (!store_blob(data_, hash)) {
+            return false;
+        }
+        if (mark != 0) {
+            marks_[mark] = hash;
+        }
+        return true;
+    }
+
+    // 将 :mark、40 位哈希或 ref 名解析为对象哈希
+    bool resolve(const std::string& ref, std::string& hash) {
+        if (!ref.empty() && ref[0] == ':') {
+            std::uint64_t mark = std::strtoull(ref.c_str() + 1, nullptr, 10);
+            std::unordered_map<std::uint64_t, std::string>::const_iterator it =
+                marks_.find(mark);
+            if (it == marks_.end()) {
+                return fail("unknown mark: " + ref);
+            }
+            hash = it->second;
+            return true;
+        }
+        if (is_hex_hash(ref)) {
+            hash = ref;
+            return true;
+        }
+        std::map<std::string, Branch>::const_iterator b = branches_.find(ref);
+        if (b != branches_.end() && !b->second.tip.empty()) {
+            hash = b->second.tip;
+            return true;
+        }
+        if (minigit::read_ref(fs_, ref, hash)) {
+            return true;
+        }
+        return fail("cannot resolve: " + ref);
+    }
+
+    // 查找提交对应的 tree 哈希，本次导入的提交直接查表
+    bool commit_tree(const std::string& commit, std::string& tree) {
+        std::unordered_map<std::string, std::string>::const_iterator it =
+            commit_trees_.find(commit);
+        if (it != commit_trees_.end()) {
+            tree = it->second;
+            return true;
+        }
+        ObjectView view;
+        if (!read_view(commit, view) || !minigit::parse_commit_object(view, commit_)) {
+            return fail("not a commit: " + commit);
+        }
+        tree = commit_.tree;
+        return true;
+    }
+
+    // 获取分支状态；首次出现的分支若磁盘上已有 ref，则从其提交继续
+    bool branch(const std::string& ref, Branch*& out) {
+        if (!starts_with(ref, "refs/") || ref.find("..") != std::string::npos ||
+            ref[ref.size() - 1] == '/') {
+            return fail("invalid ref name: " + ref);
+        }
+        std::map<std::string, Branch>::iterator it = branches_.find(ref);
+        if (it == branches_.end()) {
+            Branch b;
+            std::string tree;
+            if (minigit::read_ref(fs_, ref, b.tip)) {
+                if (!commit_tree(b.tip, tree)) {
+                    return false;
+                }
+            }
+            b.root = make_dir(tree);
+            it = branches_.insert(std::make_pair(ref, std::move(b))).first;
+        }
+        out = &it->second;
+        return true;
+    }
+
+    // 加载目录节点的子节点
+    bool load(TreeNode& node) {
+        if (node.loaded) {
+            return true;
+        }
+        ObjectView view;
+        if (!read_view(node.hash, view) ||
+            !minigit::parse_tree_object(view, entries_)) {
+            return fail("cannot read tree " + node.hash);
+        }
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            const minigit::TreeEntry& e = entries_[i];
+            node.children[e.name] =
+                e.mode == "40000" ? make_dir(e.hash) : make_file(e.hash, e.mode);
+        }
+        node.loaded = true;
+        return true;
+    }
+
+    // 沿路径找到（必要时创建）父目录，途经的目录都标记为已修改
+    bool parent_dir(TreeNode& root, const std::vector<std::string>& parts,
+                    bool create, TreeNode*& out) {
+        TreeNode* node = &root;
+        out = nullptr;
+        for (std::size_t i = 0; i + 1 < parts.size(); ++i) {
+            if (!load(*node)) {
+                return false;
+            }
+            std::unique_ptr<TreeNode>& child = node->children[parts[i]];
+            if (!child || !child->is_dir) {
+                if (!create) {
+                    if (!child) {
+                        node->children.erase(parts[i]);
+                    }
+                    return true;
+                }
+                child = make_dir(std::string());
+            }
+            node = child.get();
+        }
+        if (!load(*node)) {
+            return false;
+        }
+        out = node;
+        return true;
+    }
+
+    // 清除路径上所有目录的 tree 哈希，使其在提交时重新计算
+    bool touch(TreeNode& root, const std::vector<std::string>& parts) {
+        TreeNode* node = &root;
+        node->hash.clear();
+        for (std::size_t i = 0; i + 1 < parts.size(); ++i) {
+            std::map<std::string, std::unique_ptr<TreeNode> >::iterator it =
+                node->children.find(parts[i]);
+            if (it == node->children.end()) {
+                break;
+            }
+            node = it->second.get();
+            node->hash.clear();
+        }
+        return true;
+    }
+
+    bool set_entry(TreeNode& root, const std::string& path,
+                   std::unique_ptr<TreeNode> entry) {
+        std::vector<std::string> parts;
+        if (!split_path(path, parts)) {
+            return fail("invalid path: " + path);
+        }
+        TreeNode* dir = nullptr;
+        if (!parent_dir(root, parts, true, dir)) {
+            return false;
+        }
+        dir->children[parts.back()] = std::move(entry);
+        return touch(root, parts);
+    }
+
+    // 从树中摘下路径对应的节点，不存在时返回空指针
+    bool take_entry(TreeNode& root, const std::string& path,
+                    std::unique_ptr<TreeNode>& out) {
+        std::vector<std::string> parts;
+        if (!split_path(path, parts)) {
+            return fail("invalid path: " + path);
+        }
+        TreeNode* dir = nullptr;
+        if (!parent_dir(root, parts, false, dir)) {
+            return false;
+        }
+        out.reset();
+        if (!dir) {
+            return true;
+        }
+        std::map<std::string, std::unique_ptr<TreeNode> >::iterator it =
+            dir->children.find(parts.back());
+        if (it == dir->children.end()) {
+            return true;
+        }
+        out = std::move(it->second);
+        dir->children.erase(it);
+        return touch(root, parts);
+    }
+
+    // 复制节点：未修改的目录只复制 tree 哈希，修改过的目录逐层复制
+    static std::unique_ptr<TreeNode> clone(const TreeNode& node) {
+        if (!node.is_dir) {
+            return make_file(node.hash, node.mode);
+        }
+        if (!node.hash.empty()) {
+            return make_dir(node.hash);
+        }
+        std::unique_ptr<TreeNode> copy = make_dir(std::string());
+        std::map<std::string, std::unique_ptr<TreeNode> >::const_iterator it;
+        for (it = node.children.begin(); it != node.children.end(); ++it) {
+            copy->children[it->first] = clone(*it->second);
+        }
+        return copy;
+    }
+
+    bool file_modify(TreeNode& root, const std::string& line) {
+        std::size_t sp1 = line.find(' ', 2);
+        std::size_t sp2 = sp1 == std::string::npos ? sp1 : line.find(' ', sp1 + 1);
+        if (sp2 == std::string::npos) {
+            return fail("invalid filemodify: " + line);
+        }
+        std::string mode = line.substr(2, sp1 - 2);
+        std::string ref = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string path;
+        std::size_t next = 0;
+        if (!parse_path(line, sp2 + 1, true, path, next)) {
+            return fail("invalid path: " + line);
+        }
+        if (mode == "040000" || mode == "40000") {
+            if (!is_hex_hash(ref)) {
+                return fail("tree must be given by hash: " + line);
+            }
+            return set_entry(root, path, make_dir(ref));
+        }
+        if (mode == "644" || mode == "755") {
+            mode = "100" + mode;
+        } else if (mode != "100644" && mode != "100755") {
+            return fail("unsupported mode: " + mode);
+        }
+        std::string hash;
+        if (ref == "inline") {
+            if (!read_data(data_) || !store_blob(data_, hash)) {
+                return false;
+            }
+        } else if (!resolve(ref, hash)) {
+            return false;
+        }
+        return set_entry(root, path, make_file(hash, mode));
+    }
+
+    bool copy_or_rename(TreeNode& root, const std::string& line, bool rename) {
+        std::string src;
+        std::string dst;
+        std::size_t next = 0;
+        if (!parse_path(line, 2, false, src, next) || next >= line.size() ||
+            line[next] != ' ' || !parse_path(line, next + 1, true, dst, next)) {
+            return fail("invalid path: " + line);
+        }
+        std::unique_ptr<TreeNode> node;
+        if (!take_entry(root, src, node)) {
+            return false;
+        }
+        if (!node) {
+            return fail("path not found: " + src);
+        }
+        if (!rename) {
+            std::unique_ptr<TreeNode> copy = clone(*node);
+            if (!set_entry(root, src, std::move(node))) {
+                return false;
+            }
+            node = std::move(copy);
+        }
+        return set_entry(root, dst, std::move(node));
+    }
+
+    // 自底向上写出被修改的目录；空目录不生成 tree，由父目录省略
+    bool write_tree(TreeNode& node, bool is_root) {
+        if (!node.hash.empty()) {
+            return true;
+        }
+        std::vector<minigit::TreeEntry> entries;
+        entries.reserve(node.children.size());
+        std::map<std::string, std::unique_ptr<TreeNode> >::iterator it;
+        for (it = node.children.begin(); it != node.children.end(); ++it) {
+            TreeNode& child = *it->second;
+            if (child.is_dir) {
+                if (!write_tree(child, false)) {
+                    return false;
+                }
+                if (child.hash.empty()) {
+                    continue;
+                }
+            }
+            entries.push_back(minigit::TreeEntry{child.is_dir ? "40000" : child.mode,
+                                                 it->first, child.hash});
+        }
+        if (entries.empty() && !is_root) {
+            return true;
+        }
+        std::string content = minigit::build_tree_object(entries);
+        std::string hash = minigit::sha1_hex(content);
+        ByteSlice slice = minigit::make_slice(content);
+        if (!put_object(hash, &slice, 1, stats_.trees)) {
+            return false;
+        }
+        node.hash = hash;
+        return true;
+    }
+
+    bool parse_commit(const std::string& ref) {
+        Branch* b = nullptr;
+        if (!branch(ref, b)) {
+            return false;
+        }
+        std::uint64_t mark = 0;
+        if (!read_mark(mark)) {
+            return false;
+        }
+
+        minigit::Commit c;
+        std::string line;
+        while (next_line(line)) {
+            if (starts_with(line, "author ")) {
+                c.author = line.substr(7);
+            } else if (starts_with(line, "committer ")) {
+                c.committer = line.substr(10);
+            } else if (starts_with(line, "original-oid ") ||
+                       starts_with(line, "encoding ")) {
+                // 与对象内容无关的元信息，忽略
+            } else {
+                unread_line(line);
+                break;
+            }
+        }
+        if (c.committer.empty()) {
+            return fail("missing committer in commit " + ref);
+        }
+        if (c.author.empty()) {
+            c.author = c.committer;
+        }
+        if (!read_data(c.message)) {
+            return false;
+        }
+
+        bool has_from = false;
+        while (next_line(line)) {
+            if (starts_with(line, "from ") && !has_from && c.parents.empty()) {
+                std::string parent;
+                std::string tree;
+                if (!resolve(line.substr(5), parent) || !commit_tree(parent, tree)) {
+                    return false;
+                }
+                c.parents.push_back(parent);
+                b->root = make_dir(tree);
+                has_from = true;
+            } else if (starts_with(line, "merge ")) {
+                if (!has_from && c.parents.empty() && !b->tip.empty()) {
+                    c.parents.push_back(b->tip);
+                }
+                has_from = true;
+                std::string parent;
+                if (!resolve(line.substr(6), parent)) {
+                    return false;
+                }
+                c.parents.push_back(parent);
+            } else {
+                unread_line(line);
+                break;
+            }
+        }
+        if (!has_from && !b->tip.empty()) {
+            c.parents.push_back(b->tip);
+        }
+
+        while (next_line(line)) {
+            bool ok = true;
+            if (starts_with(line, "M ")) {
+                ok = file_modify(*b->root, line);
+            } else if (starts_with(line, "D ")) {
+                std::string path;
+                std::size_t next = 0;
+                std::unique_ptr<TreeNode> removed;
+                ok = parse_path(line, 2, true, path, next)
+                         ? take_entry(*b->root, path, removed)
+                         : fail("invalid path: " + line);
+            } else if (starts_with(line, "C ")) {
+                ok = copy_or_rename(*b->root, line, false);
+            } else if (starts_with(line, "R ")) {
+                ok = copy_or_rename(*b->root, line, true);
+            } else if (line == "deleteall") {
+                b->root = make_dir(std::string());
+            } else {
+                if (!line.empty()) {
+                    unread_line(line);
+                }
+                break;
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+
+        if (!write_tree(*b->root, true)) {
+            return false;
+        }
+        c.tree = b->root->hash;
+        std::string content = minigit::build_commit_object(c);
+        std::string hash = minigit::sha1_hex(content);
+        ByteSlice slice = minigit::make_slice(content);
+        if (!put_object(hash, &slice, 1, stats_.commits)) {
+            return false;
+        }
+        commit_trees_[hash] = c.tree;
+        b->tip = hash;
+        if (mark != 0) {
+            marks_[mark] = hash;
+        }
+        return true;
+    }
+
+    bool parse_reset(const std::string& ref) {
+        Branch* b = nullptr;
+        if (!branch(ref, b)) {
+            return false;
+        }
+        b->tip.clear();
+        b->root = make_dir(std::string());
+        std::string line;
+        if (!next_line(line)) {
+            return true;
+        }
+        if (!starts_with(line, "from ")) {
+            if (!line.empty()) {
+                unread_line(line);
+            }
+            return true;
+        }
+        std::string tree;
+        if (!resolve(line.substr(5), b->tip) || !commit_tree(b->tip, tree)) {
+            return false;
+        }
+        b->root = make_dir(tree);
+        return true;
+    }
+
+    // 将当前包落盘并更新 ref，reopen 为 true 时随后开始新的包
+    bool checkpoint(bool reopen) {
+        if (writer_.object_count() > 0) {
+            std::string path;
+            if (!writer_.finish(path)) {
+                return fail("failed to finish pack");
+            }
+            ++stats_.packs;
+        } else {
+            writer_.abort();
+        }
+        std::map<std::string, Branch>::const_iterator it;
+        for (it = branches_.begin(); it != branches_.end(); ++it) {
+            std::string current;
+            if (it->second.tip.empty() ||
+                (minigit::read_ref(fs_, it->first, current) && current == it->second.tip)) {
+                continue;
+            }
+            if (!minigit::update_ref(fs_, it->first, it->second.tip)) {
+                return fail("failed to update " + it->first);
+            }
+            ++stats_.refs;
+        }
+        if (reopen && !writer_.begin(fs_)) {
+            return fail("cannot create pack file");
+        }
+        return true;
+    }
+
+    minigit::ObjectStore& store_;
+    const minigit::FileSystem& fs_;
+    std::istream& in_;
+    std::ostream& out_;
+    minigit::FastImportStats& stats_;
+
+    minigit::PackWriter writer_;
+    std::size_t line_no_;
+    bool pending_;
+    /// 流中声明了 feature done，必须以 done 命令结束。
+    bool require_done_;
+    std::string pending_line_;
+    std::string error_;
+
+    std::unordered_map<std::uint64_t, std::string> marks_;
+    std::map<std::string, Branch> branches_;
+    std::unordered_map<std::string, std::string> commit_trees_;
+
+    minigit::ReadContext ctx_;
+    std::string scratch_;
+    std::string data_;
+    minigit::Commit commit_;
+    std::vector<minigit::TreeEntry> entries_;
+};
+
+}  // namespace
+
+namespace minigit {
+
+// 执行导入并在出错时报告所在行号
+int run_fast_import(ObjectStore& store, const FileSystem& fs, std::istream& in,
+                    std::ostream& out, std::ostream& err, FastImportStats& stats) {
+    FastImporter importer(store, fs, in, out, stats);
+    if (!importer.run()) {
+        err << "fast-import: line " << importer.line_no() << ": "
+            << importer.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace minigit
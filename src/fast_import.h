@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+#include "filesystem.h"
+#include "object_store.h"
+
+// 本文件声明 fast-import 流式历史导入
+namespace minigit {
+
+/**
+ * @brief 一次 fast-import 导入的统计信息。
+ */
+struct FastImportStats {
+    /// 新写入的 blob 数量。
+    std::size_t blobs = 0;
+    /// 新写入的 tree 数量。
+    std::size_t trees = 0;
+    /// 新写入的 commit 数量。
+    std::size_t commits = 0;
+    /// 已存在于仓库或本次导入中、因而被跳过的对象数量。
+    std::size_t duplicates = 0;
+    /// 导入结束时更新的 ref 数量。
+    std::size_t refs = 0;
+    /// 生成的包文件数量（每个 checkpoint 以及结束时各一个）。
+    std::size_t packs = 0;
+};
+
+/**
+ * @brief 从文本流导入历史，对象直接写入新的包文件。
+ *
+ * 支持 git fast-import 格式的常用子集：
+ *   - blob / mark / data（计数形式与 "<<分隔符" 形式）；
+ *   - commit <ref>，含 mark、author、committer、data、from、merge；
+ *   - 文件操作 M（100644/644 与 100755/755 保留可执行位，040000 引用已有 tree）、
+ *     D、C、R、deleteall，数据引用可以是 :mark、40 位哈希或 inline；
+ *   - reset、checkpoint、progress、done 与 "#" 注释；
+ *   - feature 只接受 done 与 date-format=raw，其余特性报错；声明 feature done 后
+ *     流必须以 done 结束；"option git ..." 报错，面向其他工具的 option 忽略。
+ * tree 在内存中按目录懒加载，只有被修改的目录会在提交时重新写出。
+ * 所有 ref 在包文件落盘后才更新；出错时放弃尚未落盘的包且不更新 ref。
+ *
+ * @param store 对象存储实例，用于去重以及读取已有的 commit/tree。
+ * @param fs    仓库根目录对应的文件系统对象。
+ * @param in    导入流。
+ * @param out   progress 命令的输出流。
+ * @param err   错误信息输出流。
+ * @param stats 输出参数，导入统计信息。
+ * @return 进程退出码，成功返回 0，否则返回 1。
+ */
+int run_fast_import(ObjectStore& store, const FileSystem& fs, std::istream& in,
+                    std::ostream& out, std::ostream& err, FastImportStats& stats);
+
+}  // namespace minigit
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -120,6 +121,34 @@ bool FileSystem::read_file(const std::string& relative,
     return true;
 }
 
+// 按 fstat 得到的长度一次调整缓冲区后读入，处理短读与 EINTR
+bool read_file_into(const std::string& path, std::string& buffer) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    buffer.resize(static_cast<std::size_t>(st.st_size));
+    std::size_t done = 0;
+    while (done < buffer.size()) {
+        ssize_t n = ::read(fd, &buffer[done], buffer.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ::close(fd);
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return true;
+}
+
 // 判断相对路径对应的文件或目录是否存在
 bool FileSystem::exists(const std::string& relative) const {
     std::string full = make_path(relative);
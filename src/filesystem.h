@@ -83,4 +83,16 @@ private:
     std::string root_;
 };
 
+/**
+ * @brief 将普通文件完整读入可复用的缓冲区。
+ *
+ * 先用 fstat 取得文件长度，把缓冲区一次调整到该长度后直接读入，
+ * 内存峰值约等于文件大小，不会因逐步增长而重新分配和复制。
+ *
+ * @param path   文件完整路径。
+ * @param buffer 输出参数，文件内容；失败时内容不确定。
+ * @return 文件是普通文件且完整读取时返回 true，否则返回 false。
+ */
+bool read_file_into(const std::string& path, std::string& buffer);
+
 }  // namespace minigit
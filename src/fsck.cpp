@@ -0,0 +1,291 @@
+#include "fsck.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#include "commit.h"
+#include "hash.h"
+#include "object_store.h"
+#include "pack.h"
+#include "pack_index.h"
+#include "refs.h"
+#include "tree.h"
+#include "zlib_utils.h"
+
+// 本文件实现仓库完整性检查
+namespace {
+
+using minigit::ObjectType;
+
+// 每个包对象检查任务覆盖的对象数，足够大以摊薄任务调度开销，又足够小以均衡负载
+const std::size_t kPackRangeSize = 1024;
+
+// 一个待检查的包：索引、包文件映射与按偏移排序的索引序号，由所有线程只读共享
+struct FsckPack {
+    std::string rel;
+    std::string name;
+    minigit::PackIndex index;
+    minigit::PackReader reader;
+    std::vector<std::uint32_t> order;
+};
+
+// 一项检查任务：一个松散对象、一个包的校验和，或一个包中按偏移排列的一段对象
+struct FsckTask {
+    enum Kind { kLoose, kPackChecksum, kPackRange };
+    Kind kind;
+    std::string hash;
+    std::size_t pack;
+    std::size_t begin;
+    std::size_t end;
+};
+
+// 对象之间的一条引用：from 引用了 to，且 to 应为 expected 类型
+struct FsckLink {
+    std::string from;
+    std::string to;
+    ObjectType expected;
+};
+
+// 每个工作线程独立收集的结果，全部任务完成后合并
+struct FsckShard {
+    FsckShard() : loose(0), packed(0) {}
+
+    std::unordered_map<std::string, ObjectType> objects;
+    std::vector<FsckLink> links;
+    std::vector<std::string> errors;
+    std::size_t loose;
+    std::size_t packed;
+};
+
+// 校验对象内容的哈希并记录其类型，提交与 tree 还要记录它们引用的对象
+void check_object(const std::string& hash, const std::string& content, const char* where,
+                  FsckShard& shard) {
+    ObjectType type = ObjectType::kNone;
+    std::size_t size = 0;
+    std::size_t header_len = 0;
+    if (!minigit::parse_object_header(content.data(), content.size(), type, size, header_len) ||
+        header_len + size != content.size()) {
+        shard.errors.push_back(hash + ": malformed object header (" + where + ")");
+        return;
+    }
+    if (minigit::sha1_hex(content) != hash) {
+        shard.errors.push_back(hash + ": hash mismatch (" + where + ")");
+        return;
+    }
+    shard.objects[hash] = type;
+    minigit::ObjectView view;
+    view.type = type;
+    view.size = size;
+    view.data = content.data() + header_len;
+    if (type == ObjectType::kCommit) {
+        minigit::Commit commit;
+        if (!minigit::parse_commit_object(view, commit)) {
+            shard.errors.push_back(hash + ": malformed commit");
+            return;
+        }
+        FsckLink link = {hash, commit.tree, ObjectType::kTree};
+        shard.links.push_back(link);
+        for (std::size_t i = 0; i < commit.parents.size(); ++i) {
+            FsckLink parent = {hash, commit.parents[i], ObjectType::kCommit};
+            shard.links.push_back(parent);
+        }
+    } else if (type == ObjectType::kTree) {
+        std::vector<minigit::TreeEntry> entries;
+        if (!minigit::parse_tree_object(view, entries)) {
+            shard.errors.push_back(hash + ": malformed tree");
+            return;
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const std::string& mode = entries[i].mode;
+            if (mode == "160000") {
+                continue;
+            }
+            FsckLink link = {hash, entries[i].hash,
+                             mode == "40000" || mode == "040000" ? ObjectType::kTree
+                                                                 : ObjectType::kBlob};
+            shard.links.push_back(link);
+        }
+    }
+}
+
+// 依次领取任务直到全部完成；包对象通过线程自己的 PackSet 按偏移重建，以复用 delta 基准缓存
+void run_tasks(const minigit::FileSystem& fs, const std::vector<FsckTask>& tasks,
+               const std::vector<std::unique_ptr<FsckPack> >& packs,
+               std::atomic<std::size_t>& next, FsckShard& shard) {
+    minigit::PackSet set(fs.root());
+    std::string compressed;
+    std::string content;
+    for (std::size_t t = next++; t < tasks.size(); t = next++) {
+        const FsckTask& task = tasks[t];
+        if (task.kind == FsckTask::kLoose) {
+            ++shard.loose;
+            const std::string& h = task.hash;
+            if (!fs.read_file("objects/" + h.substr(0, 2) + "/" + h.substr(2), compressed) ||
+                !minigit::zlib_inflate_into(compressed.data(), compressed.size(), content)) {
+                shard.errors.push_back(h + ": loose object does not inflate");
+                continue;
+            }
+            check_object(h, content, "loose", shard);
+            continue;
+        }
+        const FsckPack& pack = *packs[task.pack];
+        if (task.kind == FsckTask::kPackChecksum) {
+            // MPK1 没有末尾校验和，只能依靠条目 CRC 与对象哈希检查
+            if (pack.reader.version() != 1 && !pack.reader.verify_checksum()) {
+                shard.errors.push_back(pack.rel + ": pack checksum mismatch");
+            }
+            if (!pack.index.verify_checksum()) {
+                shard.errors.push_back(pack.rel + ": index checksum mismatch");
+            }
+            continue;
+        }
+        for (std::size_t r = task.begin; r < task.end; ++r) {
+            ++shard.packed;
+            std::uint32_t pos = pack.order[r];
+            std::string hash = pack.index.hash_at(pos);
+            minigit::PackEntryView entry;
+            if (!pack.reader.entry_at(pack.index.offset_at(pos), entry)) {
+                shard.errors.push_back(hash + ": truncated entry in " + pack.rel);
+                continue;
+            }
+            if (pack.reader.entry_crc(entry) != pack.index.crc_at(pos)) {
+                shard.errors.push_back(hash + ": crc mismatch in " + pack.rel);
+                continue;
+            }
+            if (!set.read_packed_at(pack.name, entry.offset, content)) {
+                shard.errors.push_back(hash + ": cannot inflate from " + pack.rel);
+                continue;
+            }
+            check_object(hash, content, pack.rel.c_str(), shard);
+        }
+    }
+}
+
+// 打开包与索引，借助 .rev 得到按偏移排列的对象顺序；反向索引不可用时现场排序
+bool open_pack(const minigit::FileSystem& fs, const std::string& rel, FsckPack& pack) {
+    pack.rel = rel;
+    pack.name = rel.substr(rel.find_last_of('/') + 1);
+    if (!pack.index.open(fs.make_path(minigit::pack_sibling_path(rel, ".idx"))) ||
+        !pack.reader.open(fs.make_path(rel), minigit::PackReader::Access::kSequential) ||
+        !pack.reader.content_id() || pack.index.count() != pack.reader.count()) {
+        return false;
+    }
+    pack.order.resize(pack.index.count());
+    minigit::PackReverseIndex rev;
+    if (rev.open(fs.make_path(minigit::pack_sibling_path(rel, ".rev")), pack.index.count(),
+                 pack.reader.content_id())) {
+        for (std::size_t r = 0; r < pack.order.size(); ++r) {
+            pack.order[r] = rev.index_position(r);
+        }
+        return true;
+    }
+    for (std::size_t i = 0; i < pack.order.size(); ++i) {
+        pack.order[i] = static_cast<std::uint32_t>(i);
+    }
+    const minigit::PackIndex& index = pack.index;
+    std::sort(pack.order.begin(), pack.order.end(),
+              [&index](std::uint32_t a, std::uint32_t b) {
+                  return index.offset_at(a) < index.offset_at(b);
+              });
+    return true;
+}
+
+}  // namespace
+
+namespace minigit {
+
+// 先拆分任务并行检查每个对象，再在合并后的对象表上检查引用关系与 ref
+bool fsck_repository(const FileSystem& fs, const FsckOptions& options, FsckReport& report) {
+    report = FsckReport();
+    std::vector<FsckTask> tasks;
+    std::vector<std::unique_ptr<FsckPack> > packs;
+    std::vector<std::string> rels;
+    list_pack_files(fs, rels);
+    for (std::size_t p = 0; p < rels.size(); ++p) {
+        std::unique_ptr<FsckPack> pack(new FsckPack);
+        if (!open_pack(fs, rels[p], *pack)) {
+            report.errors.push_back(rels[p] + ": cannot open pack or index");
+            continue;
+        }
+        FsckTask checksum = {FsckTask::kPackChecksum, std::string(), packs.size(), 0, 0};
+        tasks.push_back(checksum);
+        for (std::size_t b = 0; b < pack->order.size(); b += kPackRangeSize) {
+            FsckTask range = {FsckTask::kPackRange, std::string(), packs.size(), b,
+                              std::min(pack->order.size(), b + kPackRangeSize)};
+            tasks.push_back(range);
+        }
+        packs.push_back(std::move(pack));
+    }
+    report.packs = packs.size();
+    std::vector<std::string> loose;
+    list_loose_objects(fs, loose);
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        FsckTask task = {FsckTask::kLoose, loose[i], 0, 0, 0};
+        tasks.push_back(task);
+    }
+
+    std::size_t threads = options.threads != 0
+                              ? options.threads
+                              : std::max(1U, std::thread::hardware_concurrency());
+    threads = std::max<std::size_t>(1U, std::min(threads, tasks.size()));
+    std::vector<FsckShard> shards(threads);
+    {
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.push_back(std::thread(run_tasks, std::cref(fs), std::cref(tasks),
+                                          std::cref(packs), std::ref(next),
+                                          std::ref(shards[t])));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+    }
+
+    std::unordered_map<std::string, ObjectType> objects;
+    for (std::size_t t = 0; t < shards.size(); ++t) {
+        report.loose_objects += shards[t].loose;
+        report.packed_objects += shards[t].packed;
+        report.errors.insert(report.errors.end(), shards[t].errors.begin(),
+                             shards[t].errors.end());
+        objects.insert(shards[t].objects.begin(), shards[t].objects.end());
+        shards[t].objects.clear();
+    }
+    for (std::size_t t = 0; t < shards.size(); ++t) {
+        const std::vector<FsckLink>& links = shards[t].links;
+        for (std::size_t i = 0; i < links.size(); ++i) {
+            std::unordered_map<std::string, ObjectType>::const_iterator it =
+                objects.find(links[i].to);
+            if (it == objects.end()) {
+                report.errors.push_back(links[i].from + ": broken link to " + links[i].to);
+            } else if (it->second != links[i].expected) {
+                report.errors.push_back(links[i].from + ": " + links[i].to + " should be a " +
+                                        object_type_name(links[i].expected) + ", found " +
+                                        object_type_name(it->second));
+            }
+        }
+    }
+
+    std::map<std::string, std::string> refs;
+    list_refs(fs, refs);
+    Head head;
+    if (read_head(fs, head) && !head.symbolic) {
+        refs["HEAD"] = head.target;
+    }
+    for (std::map<std::string, std::string>::const_iterator it = refs.begin();
+         it != refs.end(); ++it) {
+        std::unordered_map<std::string, ObjectType>::const_iterator obj =
+            objects.find(it->second);
+        if (obj == objects.end() || obj->second != ObjectType::kCommit) {
+            report.errors.push_back(it->first + ": points to missing commit " + it->second);
+        }
+    }
+    std::sort(report.errors.begin(), report.errors.end());
+    return report.errors.empty();
+}
+
+}  // namespace minigit
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "filesystem.h"
+
+// 本文件声明仓库完整性检查（fsck）
+namespace minigit {
+
+/**
+ * @brief 完整性检查的参数。
+ */
+struct FsckOptions {
+    /// 工作线程数，0 表示使用全部 CPU 核心。
+    std::size_t threads = 0;
+};
+
+/**
+ * @brief 完整性检查的结果。
+ */
+struct FsckReport {
+    /// 检查过的松散对象数量。
+    std::size_t loose_objects = 0;
+    /// 检查过的包内对象数量（同一对象出现在多个包中时分别计数）。
+    std::size_t packed_objects = 0;
+    /// 检查过的包文件数量。
+    std::size_t packs = 0;
+    /// 发现的问题，每条为一行可读描述，按字典序排列。
+    std::vector<std::string> errors;
+};
+
+/**
+ * @brief 检查仓库中全部对象与包文件的完整性。
+ *
+ * 检查内容：
+ *   - 每个松散对象与包内对象都能解压（包内对象需能解析 delta 链）；
+ *   - 每个对象内容的 SHA-1 与其名称一致；
+ *   - 包内条目的 CRC32 与 .idx 一致，包文件与 .idx 末尾的校验和正确；
+ *   - 提交引用的 tree 与父提交、tree 引用的子 tree 与 blob 都存在且类型正确，
+ *     每个 ref 与游离 HEAD 都指向存在的提交。
+ * 松散对象、包校验和以及每个包中按偏移排列的若干段对象被拆分为独立任务，
+ * 由 options.threads 个工作线程并行处理；包文件经 mmap 按偏移顺序读取，
+ * 每个线程使用自己的 delta 基准缓存。
+ *
+ * @param fs      仓库根目录对应的文件系统对象。
+ * @param options 检查参数。
+ * @param report  输出参数，检查统计与发现的问题。
+ * @return 没有发现任何问题返回 true，否则返回 false。
+ */
+bool fsck_repository(const FileSystem& fs, const FsckOptions& options, FsckReport& report);
+
+}  // namespace minigit
@@ -0,0 +1,160 @@
+#include "gc.h"
+
+#include <ctime>
+#include <fcntl.h>
+#include <map>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include "byte_slice.h"
+#include "index.h"
+#include "object_store.h"
+#include "pack_bitmap.h"
+#include "pack_index.h"
+#include "refs.h"
+#include "zlib_utils.h"
+
+// 本文件实现基于可达性的垃圾回收
+namespace minigit {
+
+// 把完整对象内容写为松散对象，并把修改时间设置为 mtime
+static bool write_loose_object(const FileSystem& fs, const std::string& hash,
+                               const std::string& content, std::time_t mtime) {
+    std::string dir = "objects/" + hash.substr(0, 2);
+    if (!fs.ensure_directory(dir)) {
+        return false;
+    }
+    std::string tmp = fs.make_path(dir + "/tmp_obj_XXXXXX");
+    int fd = ::mkstemp(&tmp[0]);
+    if (fd < 0) {
+        return false;
+    }
+    ::fchmod(fd, 0444);
+    ByteSlice slice = make_slice(content);
+    struct timespec times[2];
+    times[0].tv_sec = mtime;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    bool ok = zlib_deflate_to_fd(&slice, 1, fd) && ::futimens(fd, times) == 0;
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), fs.make_path(dir + "/" + hash.substr(2)).c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 收集需要保留的对象：ref 与游离 HEAD 可达的全部对象，以及暂存区引用的 blob
+static bool collect_reachable(FileSystem& fs, std::unordered_set<std::string>& keep,
+                              std::size_t& reachable) {
+    std::map<std::string, std::string> refs;
+    list_refs(fs, refs);
+    std::vector<std::string> tips;
+    for (std::map<std::string, std::string>::const_iterator it = refs.begin();
+         it != refs.end(); ++it) {
+        tips.push_back(it->second);
+    }
+    Head head;
+    if (read_head(fs, head) && !head.symbolic && !head.target.empty()) {
+        tips.push_back(head.target);
+    }
+    ObjectStore store(fs.root());
+    std::vector<std::string> listed;
+    if (!list_reachable_objects(store, tips, std::vector<std::string>(), true, listed)) {
+        return false;
+    }
+    reachable = listed.size();
+    keep.insert(listed.begin(), listed.end());
+    std::vector<IndexEntry> entries;
+    if (!read_index(fs, entries)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        keep.insert(entries[i].hash);
+    }
+    return true;
+}
+
+// 仍在保留期内的包中的不可达对象改存为松散对象，使它们在旧包删除后继续按保留期过期
+static bool loosen_recent_unreachable(const FileSystem& fs,
+                                      const std::unordered_set<std::string>& keep,
+                                      std::time_t expiry, std::size_t& loosened) {
+    std::vector<std::string> rels;
+    list_pack_files(fs, rels);
+    PackSet packs(fs.root());
+    std::string content;
+    for (std::size_t p = 0; p < rels.size(); ++p) {
+        struct stat st;
+        if (::stat(fs.make_path(rels[p]).c_str(), &st) != 0 || st.st_mtime < expiry) {
+            continue;
+        }
+        PackIndex index;
+        if (!index.open(fs.make_path(pack_sibling_path(rels[p], ".idx")))) {
+            return false;
+        }
+        for (std::size_t i = 0; i < index.count(); ++i) {
+            std::string hash = index.hash_at(i);
+            if (keep.count(hash) != 0 ||
+                fs.exists("objects/" + hash.substr(0, 2) + "/" + hash.substr(2))) {
+                continue;
+            }
+            if (!packs.read_object(hash, content) ||
+                !write_loose_object(fs, hash, content, st.st_mtime)) {
+                return false;
+            }
+            ++loosened;
+        }
+    }
+    return true;
+}
+
+// 删除修改时间早于 expiry 的不可达松散对象，随后尝试删除变空的扇出目录
+static void prune_unreachable_loose(const FileSystem& fs,
+                                    const std::unordered_set<std::string>& keep,
+                                    std::time_t expiry, std::size_t& pruned) {
+    std::vector<std::string> loose;
+    list_loose_objects(fs, loose);
+    std::set<std::string> dirs;
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        if (keep.count(loose[i]) != 0) {
+            continue;
+        }
+        std::string dir = "objects/" + loose[i].substr(0, 2);
+        std::string path = fs.make_path(dir + "/" + loose[i].substr(2));
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0 && st.st_mtime < expiry &&
+            ::unlink(path.c_str()) == 0) {
+            ++pruned;
+            dirs.insert(dir);
+        }
+    }
+    for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+        ::rmdir(fs.make_path(*it).c_str());
+    }
+}
+
+// 先确定保留集合并保护保留期内的包中对象，再重打包，最后删除过期的不可达松散对象
+bool gc_repository(FileSystem& fs, const GcOptions& options, GcReport& report) {
+    report = GcReport();
+    std::unordered_set<std::string> keep;
+    if (!collect_reachable(fs, keep, report.reachable)) {
+        return false;
+    }
+    std::time_t now = std::time(nullptr);
+    std::time_t expiry = options.grace_seconds >= static_cast<std::uint64_t>(now)
+                             ? 0
+                             : now - static_cast<std::time_t>(options.grace_seconds);
+    std::string out;
+    if (!loosen_recent_unreachable(fs, keep, expiry, report.loosened) ||
+        !repack_objects(fs, options.pack, keep, report.pack, out)) {
+        return false;
+    }
+    prune_unreachable_loose(fs, keep, expiry, report.pruned);
+    return true;
+}
+
+}  // namespace minigit
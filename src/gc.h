@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "filesystem.h"
+#include "pack.h"
+
+// 本文件声明基于可达性的垃圾回收（gc）
+namespace minigit {
+
+/**
+ * @brief 垃圾回收的参数。
+ */
+struct GcOptions {
+    /// 重打包使用的 delta 搜索参数。
+    PackOptions pack;
+    /// 不可达对象的保留期（秒），修改时间在此之内的不可达对象不会被删除。
+    std::uint64_t grace_seconds = 14U * 24U * 3600U;
+};
+
+/**
+ * @brief 垃圾回收的结果。
+ */
+struct GcReport {
+    /// 从 ref、游离 HEAD 与暂存区出发可达的对象数量。
+    std::size_t reachable = 0;
+    /// 重打包的统计信息。
+    PackStats pack;
+    /// 从旧包中取出、因仍在保留期内而改存为松散对象的不可达对象数量。
+    std::size_t loosened = 0;
+    /// 被删除的不可达松散对象数量。
+    std::size_t pruned = 0;
+};
+
+/**
+ * @brief 按可达性回收仓库中不再需要的对象。
+ *
+ * 步骤：
+ *   1. 从全部 ref、游离 HEAD 以及暂存区中的 blob 出发遍历提交、tree 与 blob，
+ *      得到需要保留的对象集合；遍历中遇到缺失对象时立即失败，不删除任何文件；
+ *   2. 修改时间仍在保留期内的包中的不可达对象被写为松散对象，并沿用包的修改时间，
+ *      使其按同样的保留期过期；
+ *   3. 可达对象重写为单个新包（见 repack_objects），删除旧包与已入包的松散对象；
+ *   4. 删除修改时间早于保留期的不可达松散对象。
+ *
+ * @param fs      仓库根目录对应的文件系统对象。
+ * @param options 回收参数。
+ * @param report  输出参数，回收统计。
+ * @return 成功返回 true，遍历、读取或写入失败返回 false。
+ */
+bool gc_repository(FileSystem& fs, const GcOptions& options, GcReport& report);
+
+}  // namespace minigit
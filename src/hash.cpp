@@ -1,11 +1,7 @@
 #include "hash.h"
 
-#include <array>
 #include <cstdint>
 #include <cstring>
-#include <iomanip>
-#include <sstream>
-#include <vector>
 
 // 本文件实现 SHA-1 哈希算法，用于对对象内容进行散列
 namespace {
@@ -73,40 +69,138 @@ void sha1_transform(uint32_t state[5], const uint8_t block[64]) {
 
 namespace minigit {
 
-// 计算任意长度输入数据的 SHA-1 哈希值
-std::string sha1_hex(const std::string& data) {
-    uint32_t state[5] = {
-        0x67452301U,
-        0xEFCDAB89U,
-        0x98BADCFEU,
-        0x10325476U,
-        0xC3D2E1F0U,
-    };
+// 使用 SHA-1 标准初始向量构造计算器
+Sha1::Sha1() : total_len_(0), block_len_(0) {
+    state_[0] = 0x67452301U;
+    state_[1] = 0xEFCDAB89U;
+    state_[2] = 0x98BADCFEU;
+    state_[3] = 0x10325476U;
+    state_[4] = 0xC3D2E1F0U;
+}
 
-    uint64_t bit_len = static_cast<uint64_t>(data.size()) * 8U;
+// 追加输入数据：先补齐缓冲区中的残余分组，再直接处理整块数据
+void Sha1::update(const void* data, std::size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total_len_ += static_cast<uint64_t>(size);
 
-    std::vector<uint8_t> buffer(data.begin(), data.end());
-    buffer.push_back(0x80U);
+    if (block_len_ > 0) {
+        std::size_t take = 64U - block_len_;
+        if (take > size) {
+            take = size;
+        }
+        std::memcpy(block_ + block_len_, p, take);
+        block_len_ += take;
+        p += take;
+        size -= take;
+        if (block_len_ < 64U) {
+            return;
+        }
+        sha1_transform(state_, block_);
+        block_len_ = 0;
+    }
 
-    while ((buffer.size() % 64U) != 56U) {
-        buffer.push_back(0x00U);
+    while (size >= 64U) {
+        sha1_transform(state_, p);
+        p += 64;
+        size -= 64U;
     }
 
-    for (int i = 7; i >= 0; --i) {
-        buffer.push_back(static_cast<uint8_t>((bit_len >> (i * 8)) & 0xFFU));
+    if (size > 0) {
+        std::memcpy(block_, p, size);
+        block_len_ = size;
     }
+}
 
-    for (std::size_t i = 0; i < buffer.size(); i += 64) {
-        sha1_transform(state, &buffer[i]);
+// 追加 0x80 与填充字节及 64 位长度后输出最终摘要
+void Sha1::final_raw(unsigned char out[20]) {
+    uint64_t bit_len = total_len_ * 8U;
+
+    block_[block_len_++] = 0x80U;
+    if (block_len_ > 56U) {
+        std::memset(block_ + block_len_, 0, 64U - block_len_);
+        sha1_transform(state_, block_);
+        block_len_ = 0;
+    }
+    std::memset(block_ + block_len_, 0, 56U - block_len_);
+    for (int i = 7; i >= 0; --i) {
+        block_[56 + (7 - i)] = static_cast<uint8_t>((bit_len >> (i * 8)) & 0xFFU);
     }
+    sha1_transform(state_, block_);
+    block_len_ = 0;
 
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
     for (int i = 0; i < 5; ++i) {
-        oss << std::setw(8) << state[i];
+        out[i * 4] = static_cast<unsigned char>((state_[i] >> 24) & 0xFFU);
+        out[i * 4 + 1] = static_cast<unsigned char>((state_[i] >> 16) & 0xFFU);
+        out[i * 4 + 2] = static_cast<unsigned char>((state_[i] >> 8) & 0xFFU);
+        out[i * 4 + 3] = static_cast<unsigned char>(state_[i] & 0xFFU);
+    }
+}
+
+// 输出十六进制形式的最终摘要
+std::string Sha1::final_hex() {
+    unsigned char raw[20];
+    final_raw(raw);
+    return raw_to_hex(raw);
+}
+
+// 计算任意长度输入数据的 SHA-1 哈希值
+std::string sha1_hex(const std::string& data) {
+    Sha1 sha;
+    sha.update(data.data(), data.size());
+    return sha.final_hex();
+}
+
+// 依次喂入各段切片，计算其逻辑拼接结果的 SHA-1 哈希值
+std::string sha1_hex(const ByteSlice* slices, std::size_t count) {
+    Sha1 sha;
+    for (std::size_t i = 0; i < count; ++i) {
+        sha.update(slices[i].data, slices[i].size);
     }
+    return sha.final_hex();
+}
+
+// 逐字节查表输出高低两个十六进制位
+void raw_to_hex_into(const unsigned char* raw, std::string& out) {
+    static const char kHex[] = "0123456789abcdef";
+    out.resize(40U);
+    for (std::size_t i = 0; i < 20U; ++i) {
+        out[i * 2U] = kHex[raw[i] >> 4];
+        out[i * 2U + 1U] = kHex[raw[i] & 0x0f];
+    }
+}
 
-    return oss.str();
+// 把 20 字节二进制哈希转换为新的十六进制字符串
+std::string raw_to_hex(const unsigned char* raw) {
+    std::string hex;
+    raw_to_hex_into(raw, hex);
+    return hex;
+}
+
+// 两个十六进制位合成一个字节，遇到非法字符立即失败
+bool hex_to_raw(const std::string& hex, unsigned char raw[20]) {
+    if (hex.size() != 40U) {
+        return false;
+    }
+    for (std::size_t i = 0; i < 40U; ++i) {
+        char c = hex[i];
+        int v = -1;
+        if (c >= '0' && c <= '9') {
+            v = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            v = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            v = c - 'A' + 10;
+        }
+        if (v < 0) {
+            return false;
+        }
+        if (i % 2U == 0) {
+            raw[i / 2U] = static_cast<unsigned char>(v << 4);
+        } else {
+            raw[i / 2U] = static_cast<unsigned char>(raw[i / 2U] | v);
+        }
+    }
+    return true;
 }
 
 }  // namespace minigit
@@ -1,10 +1,58 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "byte_slice.h"
+
 // 本文件声明用于计算 SHA-1 哈希值的接口
 namespace minigit {
 
+/**
+ * @brief 增量式 SHA-1 计算器。
+ *
+ * 允许分多次喂入数据，内部只保留一个 64 字节的分组缓冲区，
+ * 因此对大对象或多段切片计算哈希时不需要先拼接成完整缓冲区。
+ */
+class Sha1 {
+public:
+    /**
+     * @brief 构造处于初始状态的计算器。
+     */
+    Sha1();
+
+    /**
+     * @brief 追加一段输入数据。
+     *
+     * @param data 数据起始地址。
+     * @param size 数据长度（字节）。
+     */
+    void update(const void* data, std::size_t size);
+
+    /**
+     * @brief 结束计算并输出 20 字节二进制摘要。
+     *
+     * 调用后计算器不可继续 update，如需复用请重新构造。
+     *
+     * @param out 输出缓冲区，至少 20 字节。
+     */
+    void final_raw(unsigned char out[20]);
+
+    /**
+     * @brief 结束计算并返回 40 位十六进制摘要。
+     *
+     * @return 长度为 40 的十六进制字符串。
+     */
+    std::string final_hex();
+
+private:
+    std::uint32_t state_[5];
+    std::uint64_t total_len_;
+    unsigned char block_[64];
+    std::size_t block_len_;
+};
+
 /**
  * @brief 计算输入数据的 SHA-1 哈希值。
  *
@@ -15,4 +63,42 @@ namespace minigit {
  */
 std::string sha1_hex(const std::string& data);
 
+/**
+ * @brief 对按顺序排列的多段切片计算 SHA-1 哈希值。
+ *
+ * 结果等价于先将所有切片拼接再调用 sha1_hex，但不会产生拼接副本。
+ *
+ * @param slices 切片数组。
+ * @param count  切片数量。
+ * @return 返回长度为 40 的十六进制字符串。
+ */
+std::string sha1_hex(const ByteSlice* slices, std::size_t count);
+
+/**
+ * @brief 把 20 字节二进制哈希转换为 40 位小写十六进制形式，写入 out。
+ *
+ * 复用 out 的已有容量，适合在循环中反复转换。
+ *
+ * @param raw 20 字节二进制哈希。
+ * @param out 输出参数，长度为 40 的十六进制字符串。
+ */
+void raw_to_hex_into(const unsigned char* raw, std::string& out);
+
+/**
+ * @brief 把 20 字节二进制哈希转换为 40 位小写十六进制形式。
+ *
+ * @param raw 20 字节二进制哈希。
+ * @return 长度为 40 的十六进制字符串。
+ */
+std::string raw_to_hex(const unsigned char* raw);
+
+/**
+ * @brief 把 40 位十六进制哈希转换为 20 字节二进制形式，大小写均可。
+ *
+ * @param hex 十六进制哈希。
+ * @param raw 输出缓冲区，至少 20 字节。
+ * @return 长度不是 40 或含非十六进制字符时返回 false。
+ */
+bool hex_to_raw(const std::string& hex, unsigned char raw[20]);
+
 }  // namespace minigit
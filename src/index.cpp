@@ -2,6 +2,9 @@
 
 #include <cstddef>
 #include <sstream>
+#include <unordered_map>
+
+#include <sys/stat.h>
 
 // 本文件实现 index（暂存区）文件的解析与写回逻辑
 namespace {
@@ -90,5 +93,60 @@ void upsert_index_entry(std::vector<IndexEntry>& entries,
     entries.push_back(entry);
 }
 
-}  // namespace minigit
+// 先建立路径到位置的映射，再逐个覆盖已有条目或追加新条目
+void upsert_index_entries(std::vector<IndexEntry>& entries,
+                          const std::vector<IndexEntry>& updates) {
+    std::unordered_map<std::string, std::size_t> positions;
+    positions.reserve(entries.size() + updates.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        positions[entries[i].path] = i;
+    }
+    for (std::size_t i = 0; i < updates.size(); ++i) {
+        std::unordered_map<std::string, std::size_t>::const_iterator it =
+            positions.find(updates[i].path);
+        if (it != positions.end()) {
+            entries[it->second].mode = updates[i].mode;
+            entries[it->second].hash = updates[i].hash;
+        } else {
+            positions[updates[i].path] = entries.size();
+            entries.push_back(updates[i]);
+        }
+    }
+}
+
+IndexCache::IndexCache()
+    : valid_(false), ino_(0), size_(0), mtime_sec_(0), mtime_nsec_(0) {}
+
+// 比较 index 文件的 stat 信息，仅在文件变化时重新解析
+bool IndexCache::load(const FileSystem& fs) {
+    struct stat st;
+    if (::stat(fs.make_path("index").c_str(), &st) != 0) {
+        entries_.clear();
+        valid_ = false;
+        return true;
+    }
 
+    if (valid_ && ino_ == static_cast<std::uint64_t>(st.st_ino) &&
+        size_ == static_cast<std::uint64_t>(st.st_size) &&
+        mtime_sec_ == static_cast<std::int64_t>(st.st_mtim.tv_sec) &&
+        mtime_nsec_ == static_cast<std::int64_t>(st.st_mtim.tv_nsec)) {
+        return true;
+    }
+
+    valid_ = false;
+    if (!read_index(fs, entries_)) {
+        return false;
+    }
+    ino_ = static_cast<std::uint64_t>(st.st_ino);
+    size_ = static_cast<std::uint64_t>(st.st_size);
+    mtime_sec_ = static_cast<std::int64_t>(st.st_mtim.tv_sec);
+    mtime_nsec_ = static_cast<std::int64_t>(st.st_mtim.tv_nsec);
+    valid_ = true;
+    return true;
+}
+
+const std::vector<IndexEntry>& IndexCache::entries() const {
+    return entries_;
+}
+
+}  // namespace minigit
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -57,5 +58,53 @@ bool write_index(const FileSystem& fs, const std::vector<IndexEntry>& entries);
 void upsert_index_entry(std::vector<IndexEntry>& entries,
                         const IndexEntry& entry);
 
+/**
+ * @brief 在暂存区列表中批量插入或更新条目。
+ *
+ * 语义与逐个调用 upsert_index_entry 相同（同一路径以 updates 中最后一个为准），
+ * 但借助路径到位置的映射只遍历列表一次，适合一次添加大量文件。
+ *
+ * @param entries 暂存区条目列表。
+ * @param updates 需要插入或更新的条目。
+ */
+void upsert_index_entries(std::vector<IndexEntry>& entries,
+                          const std::vector<IndexEntry>& updates);
+
+/**
+ * @brief index 文件的内存缓存。
+ *
+ * 记录上次读取时 index 文件的 inode、大小与纳秒级修改时间，
+ * 文件未发生变化时直接复用已解析的条目，供长驻进程在多次请求间共享。
+ */
+class IndexCache {
+public:
+    IndexCache();
+
+    /**
+     * @brief 确保缓存与磁盘上的 index 文件一致。
+     *
+     * 文件状态未变化时不做任何 I/O 之外的工作；变化时重新读取并解析。
+     *
+     * @param fs 指向仓库根目录的文件系统对象。
+     * @return 读取成功或文件不存在时返回 true，解析错误返回 false。
+     */
+    bool load(const FileSystem& fs);
+
+    /**
+     * @brief 返回最近一次 load 成功后的条目列表。
+     *
+     * @return 条目列表的常量引用。
+     */
+    const std::vector<IndexEntry>& entries() const;
+
+private:
+    bool valid_;
+    std::uint64_t ino_;
+    std::uint64_t size_;
+    std::int64_t mtime_sec_;
+    std::int64_t mtime_nsec_;
+    std::vector<IndexEntry> entries_;
+};
+
 }  // namespace minigit
 
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// 本文件声明按代价计量容量的 LRU 缓存模板，供对象、提交等缓存复用
+namespace minigit {
+
+/**
+ * @brief 最近最少使用（LRU）淘汰策略的键值缓存。
+ *
+ * 每个条目插入时给出一个代价（例如字节数或固定为 1），
+ * 缓存保证所有条目代价之和不超过容量，超出时从最久未使用的条目开始淘汰。
+ * 容量为 0 表示禁用缓存，此时 put 不保存任何内容。
+ * 该类不是线程安全的。
+ *
+ * @tparam Key   键类型。
+ * @tparam Value 值类型。
+ * @tparam Hash  键的哈希函数类型。
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class LruCache {
+public:
+    /**
+     * @brief 使用给定容量构造缓存。
+     *
+     * @param capacity 代价总和上限，0 表示禁用。
+     */
+    explicit LruCache(std::size_t capacity = 0)
+        : capacity_(capacity), used_(0), hits_(0), misses_(0) {}
+
+    /**
+     * @brief 调整容量，必要时立即淘汰多余条目。
+     *
+     * @param capacity 新的代价总和上限。
+     */
+    void set_capacity(std::size_t capacity) {
+        capacity_ = capacity;
+        evict();
+    }
+
+    /// 返回容量上限。
+    std::size_t capacity() const { return capacity_; }
+
+    /// 返回当前已占用的代价总和。
+    std::size_t used() const { return used_; }
+
+    /// 返回当前条目数量。
+    std::size_t size() const { return index_.size(); }
+
+    /// 返回累计命中次数。
+    std::uint64_t hits() const { return hits_; }
+
+    /// 返回累计未命中次数。
+    std::uint64_t misses() const { return misses_; }
+
+    /**
+     * @brief 查找条目并将其标记为最近使用。
+     *
+     * @param key 查找的键。
+     * @return 命中时返回指向值的指针，在下一次 put/clear 之前有效；未命中返回 nullptr。
+     */
+    const Value* get(const Key& key) {
+        typename Index::iterator it = index_.find(key);
+        if (it == index_.end()) {
+            ++misses_;
+            return nullptr;
+        }
+        ++hits_;
+        items_.splice(items_.begin(), items_, it->second);
+        return &it->second->value;
+    }
+
+    /**
+     * @brief 插入或替换条目，并按容量淘汰最久未使用的条目。
+     *
+     * 单个条目代价超过容量时不会被保存。
+     *
+     * @param key   键。
+     * @param value 值。
+     * @param cost  条目代价。
+     */
+    void put(const Key& key, const Value& value, std::size_t cost) {
+        erase(key);
+        if (cost > capacity_) {
+            return;
+        }
+        items_.push_front(Item(key, value, cost));
+        index_[key] = items_.begin();
+        used_ += cost;
+        evict();
+    }
+
+    /**
+     * @brief 删除指定条目（若存在）。
+     *
+     * @param key 键。
+     */
+    void erase(const Key& key) {
+        typename Index::iterator it = index_.find(key);
+        if (it == index_.end()) {
+            return;
+        }
+        used_ -= it->second->cost;
+        items_.erase(it->second);
+        index_.erase(it);
+    }
+
+    /**
+     * @brief 清空所有条目，统计计数保持不变。
+     */
+    void clear() {
+        items_.clear();
+        index_.clear();
+        used_ = 0;
+    }
+
+private:
+    struct Item {
+        Item(const Key& k, const Value& v, std::size_t c) : key(k), value(v), cost(c) {}
+        Key key;
+        Value value;
+        std::size_t cost;
+    };
+    typedef std::list<Item> List;
+    typedef std::unordered_map<Key, typename List::iterator, Hash> Index;
+
+    // 从链表尾部淘汰条目直到满足容量约束
+    void evict() {
+        while (used_ > capacity_ && !items_.empty()) {
+            Item& victim = items_.back();
+            used_ -= victim.cost;
+            index_.erase(victim.key);
+            items_.pop_back();
+        }
+    }
+
+    std::size_t capacity_;
+    std::size_t used_;
+    std::uint64_t hits_;
+    std::uint64_t misses_;
+    List items_;
+    Index index_;
+};
+
+}  // namespace minigit
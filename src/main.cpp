@@ -1,57 +1,231 @@
 #include <algorithm>
-#include <fstream>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
-#include <iterator>
+#include <queue>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include <spdlog/spdlog.h>
 
+#include "batch.h"
 #include "checkout.h"
 #include "commit.h"
+#include "daemon.h"
+#include "fast_import.h"
 #include "filesystem.h"
+#include "fsck.h"
+#include "gc.h"
 #include "index.h"
+#include "maintenance.h"
 #include "object_store.h"
 #include "refs.h"
 #include "tree.h"
 #include "pack.h"
+#include "pack_bitmap.h"
 #include <set>
 #include <map>
 
 // 本文件实现 mini-git 命令行入口及子命令分发
 namespace {
 
-// 实现 hash-object 子命令，将文件内容存储为 blob 对象
+// daemon 监听的 Unix 域套接字路径（相对于工作区根目录）
+const char* kDaemonSocket = ".minigit/daemon.sock";
+
+// 进程级共享的对象存储；daemon 模式下跨请求保留其对象缓存
+minigit::ObjectStore& repo_store() {
+    static minigit::ObjectStore store(".minigit");
+    return store;
+}
+
+// 进程级共享的提交缓存，供 log 与合并基准查找复用
+minigit::CommitCache& repo_commit_cache() {
+    static minigit::CommitCache cache(10000);
+    return cache;
+}
+
+// 进程级共享的 index 缓存，index 文件未变化时不重复解析
+minigit::IndexCache& repo_index_cache() {
+    static minigit::IndexCache cache;
+    return cache;
+}
+
+// 缩写有歧义时最多列出的候选对象数量
+const std::size_t kAbbrevCandidates = 10;
+
+// 把完整哈希或唯一缩写解析为完整哈希；缩写有歧义时在标准错误中列出候选对象
+bool resolve_object_name(const std::string& name, std::string& hash) {
+    if (name.size() == 40U) {
+        hash = name;
+        return true;
+    }
+    minigit::ObjectStore& store = repo_store();
+    std::vector<std::string> matches;
+    if (!store.find_objects_by_prefix(name, kAbbrevCandidates, matches) || matches.empty()) {
+        return false;
+    }
+    if (matches.size() > 1U) {
+        std::cerr << "short object ID " << name << " is ambiguous; candidates:\n";
+        minigit::ReadContext ctx;
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            minigit::ObjectType type = minigit::ObjectType::kNone;
+            std::size_t size = 0;
+            store.read_object_info(matches[i], ctx, type, size);
+            std::cerr << "  " << matches[i] << " " << minigit::object_type_name(type) << "\n";
+        }
+        return false;
+    }
+    hash = matches[0];
+    return true;
+}
+
+// 实现 hash-object 子命令，将文件内容存储为 blob 对象；--stdin-paths 时从标准输入批量读取路径
 int command_hash_object(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "usage: mini-git hash-object <file>\n";
+    bool stdin_paths = false;
+    std::string path;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-w") {
+            // 对象总是会被写入，保留该参数以兼容 Git 的调用方式
+            continue;
+        } else if (a == "--stdin-paths") {
+            stdin_paths = true;
+        } else if (path.empty()) {
+            path = a;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+
+    if (stdin_paths) {
+        if (!path.empty()) {
+            std::cerr << "hash-object: --stdin-paths does not take file arguments\n";
+            return 1;
+        }
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+        return minigit::run_hash_object_stdin_paths(repo_store(), std::cin,
+                                                    std::cout, std::cerr);
+    }
+
+    if (path.empty()) {
+        std::cerr << "usage: mini-git hash-object [-w] <file>\n";
+        std::cerr << "       mini-git hash-object [-w] --stdin-paths\n";
         return 1;
     }
 
-    std::string path = argv[2];
-    std::ifstream ifs(path.c_str(), std::ios::binary);
-    if (!ifs) {
+    // 按文件长度一次读入，内存峰值约等于文件大小
+    std::string data;
+    if (!minigit::read_file_into(path, data)) {
         std::cerr << "failed to open file: " << path << "\n";
         return 1;
     }
 
-    std::string data((std::istreambuf_iterator<char>(ifs)),
-                     std::istreambuf_iterator<char>());
-
-    minigit::ObjectStore store(".minigit");
-    std::string hash = store.store_blob(data);
+    minigit::ObjectStore& store = repo_store();
+    std::string hash = store.store_blob(data.data(), data.size());
 
     spdlog::info("stored blob {}", hash);
     std::cout << hash << "\n";
     return 0;
 }
 
-// 实现 write-tree 子命令，从当前工作目录构建目录快照
-int command_write_tree(int /*argc*/, char** /*argv*/) {
-    minigit::ObjectStore store(".minigit");
+// 实现 cat-file 子命令：查询单个对象，或以 --batch/--batch-check 批量处理标准输入
+int command_cat_file(int argc, char** argv) {
+    bool batch = false;
+    bool batch_check = false;
+    bool buffer = false;
+    std::vector<std::string> rest;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--batch") {
+            batch = true;
+        } else if (a == "--batch-check") {
+            batch_check = true;
+        } else if (a == "--buffer") {
+            buffer = true;
+        } else {
+            rest.push_back(a);
+        }
+    }
+
+    if (batch || batch_check) {
+        if (!rest.empty() || (batch && batch_check)) {
+            std::cerr << "usage: mini-git cat-file (--batch|--batch-check) [--buffer]\n";
+            return 1;
+        }
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+        minigit::CatFileBatchOptions options;
+        options.with_contents = batch;
+        options.buffer = buffer;
+        return minigit::run_cat_file_batch(repo_store(), std::cin, std::cout, options);
+    }
+
+    if (rest.size() != 2U) {
+        std::cerr << "usage: mini-git cat-file (-t|-s|-p|<type>) <object>\n";
+        return 1;
+    }
+
+    const std::string& mode = rest[0];
+    std::string hash;
+    minigit::ReadContext ctx;
+    minigit::ObjectView view;
+    if (!resolve_object_name(rest[1], hash) || !repo_store().read_object(hash, ctx, view)) {
+        std::cerr << "fatal: not a valid object name " << rest[1] << "\n";
+        return 1;
+    }
+
+    if (mode == "-t") {
+        std::cout << minigit::object_type_name(view.type) << "\n";
+    } else if (mode == "-s") {
+        std::cout << view.size << "\n";
+    } else if (mode == "-p" && view.type == minigit::ObjectType::kTree) {
+        std::vector<minigit::TreeEntry> entries;
+        if (!minigit::parse_tree_object(view, entries)) {
+            std::cerr << "fatal: corrupt tree " << hash << "\n";
+            return 1;
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const minigit::TreeEntry& e = entries[i];
+            std::string mode_str = e.mode.size() < 6U ? "0" + e.mode : e.mode;
+            std::cout << mode_str << " " << (e.mode == "40000" ? "tree" : "blob")
+                      << " " << e.hash << "\t" << e.name << "\n";
+        }
+    } else if (mode == "-p" || mode == minigit::object_type_name(view.type)) {
+        std::cout.write(view.data, static_cast<std::streamsize>(view.size));
+    } else {
+        std::cerr << "fatal: " << hash << " is not a " << mode << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// 实现 write-tree 子命令，从当前工作目录构建目录快照；--bulk 时新对象写入同一个新包
+int command_write_tree(int argc, char** argv) {
+    bool bulk = argc == 3 && std::string(argv[2]) == "--bulk";
+    if (argc > 3 || (argc == 3 && !bulk)) {
+        std::cerr << "usage: mini-git write-tree [--bulk]\n";
+        return 1;
+    }
+    minigit::ObjectStore& store = repo_store();
+    if (bulk && !store.begin_bulk_checkin()) {
+        std::cerr << "failed to start bulk check-in\n";
+        return 1;
+    }
     std::string tree_hash = minigit::write_tree(store, ".");
+    if (bulk && !store.end_bulk_checkin()) {
+        std::cerr << "failed to write bulk check-in pack\n";
+        return 1;
+    }
     spdlog::info("write tree {}", tree_hash);
     std::cout << tree_hash << "\n";
     return 0;
@@ -156,7 +330,76 @@ int command_symbolic_ref(int argc, char** argv) {
     return 0;
 }
 
-// 实现 status 子命令，显示当前分支或游离 HEAD 状态
+// 返回给定 tree 展开后的 "路径 -> blob 哈希" 快照，对最近一次的 tree 结果做缓存
+const std::map<std::string, std::string>* tree_snapshot(const std::string& tree_hash) {
+    static std::string cached_tree;
+    static std::map<std::string, std::string> cached_snapshot;
+    if (!cached_tree.empty() && cached_tree == tree_hash) {
+        return &cached_snapshot;
+    }
+    std::vector<minigit::IndexEntry> flat;
+    if (!minigit::flatten_tree_to_index(repo_store(), tree_hash, flat)) {
+        return nullptr;
+    }
+    cached_snapshot.clear();
+    for (std::size_t i = 0; i < flat.size(); ++i) {
+        cached_snapshot[flat[i].path] = flat[i].hash;
+    }
+    cached_tree = tree_hash;
+    return &cached_snapshot;
+}
+
+// 比较 index 与 HEAD 提交的 tree，输出待提交的变更
+void print_staged_changes(const std::string& head_commit) {
+    minigit::FileSystem fs(".minigit");
+    minigit::IndexCache& index = repo_index_cache();
+    if (!index.load(fs)) {
+        std::cout << "failed to read index\n";
+        return;
+    }
+
+    std::map<std::string, std::string> empty;
+    const std::map<std::string, std::string>* head_files = &empty;
+    if (!head_commit.empty()) {
+        const minigit::Commit* c = repo_commit_cache().lookup(repo_store(), head_commit);
+        if (c) {
+            const std::map<std::string, std::string>* snap = tree_snapshot(c->tree);
+            if (snap) {
+                head_files = snap;
+            }
+        }
+    }
+
+    std::vector<std::string> lines;
+    std::set<std::string> staged;
+    const std::vector<minigit::IndexEntry>& entries = index.entries();
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const minigit::IndexEntry& e = entries[i];
+        staged.insert(e.path);
+        std::map<std::string, std::string>::const_iterator it = head_files->find(e.path);
+        if (it == head_files->end()) {
+            lines.push_back("  new file:   " + e.path);
+        } else if (it->second != e.hash) {
+            lines.push_back("  modified:   " + e.path);
+        }
+    }
+    for (std::map<std::string, std::string>::const_iterator it = head_files->begin();
+         it != head_files->end(); ++it) {
+        if (!staged.count(it->first)) {
+            lines.push_back("  deleted:    " + it->first);
+        }
+    }
+
+    if (lines.empty()) {
+        return;
+    }
+    std::cout << "Changes to be committed:\n";
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        std::cout << lines[i] << "\n";
+    }
+}
+
+// 实现 status 子命令，显示当前分支或游离 HEAD 状态以及待提交的变更
 int command_status(int /*argc*/, char** /*argv*/) {
     minigit::FileSystem fs(".minigit");
     minigit::Head head;
@@ -166,6 +409,7 @@ int command_status(int /*argc*/, char** /*argv*/) {
         return 0;
     }
 
+    std::string head_commit;
     if (head.symbolic) {
         std::string refname = head.target;
         std::string branch = refname;
@@ -180,24 +424,23 @@ int command_status(int /*argc*/, char** /*argv*/) {
         std::cout << "On branch " << branch << "\n";
         if (has_hash) {
             std::cout << "HEAD commit: " << hash << "\n";
+            head_commit = hash;
         } else {
             std::cout << "HEAD commit: (no commit)\n";
         }
     } else {
         std::string hash = head.target;
-        std::string short_hash = hash;
-        if (short_hash.size() > 7U) {
-            short_hash = short_hash.substr(0, 7U);
-        }
-        std::cout << "HEAD detached at " << short_hash << "\n";
+        std::cout << "HEAD detached at " << repo_store().abbreviate(hash) << "\n";
+        head_commit = hash;
     }
 
+    print_staged_changes(head_commit);
     return 0;
 }
 
 // 实现 checkout 子命令，根据 HEAD 或显式对象哈希重建工作区
 int command_checkout(int argc, char** argv) {
-    minigit::ObjectStore store(".minigit");
+    minigit::ObjectStore& store = repo_store();
 
     std::string root_dir = ".";
 
@@ -212,10 +455,18 @@ int command_checkout(int argc, char** argv) {
 
     if (argc == 3) {
         std::string arg = argv[2];
-        if (arg.size() == 40U) {
-            bool ok = minigit::checkout_commit(store, root_dir, arg);
+        std::string refname = "refs/heads/" + arg;
+        minigit::FileSystem fs(".minigit");
+        std::string hash;
+        // 完整哈希直接使用，其次是分支名，最后才按唯一缩写查找对象
+        if (arg.size() == 40U || !minigit::read_ref(fs, refname, hash)) {
+            if (!resolve_object_name(arg, hash)) {
+                std::cerr << "unknown revision: " << arg << "\n";
+                return 1;
+            }
+            bool ok = minigit::checkout_commit(store, root_dir, hash);
             if (!ok) {
-                ok = minigit::checkout_tree(store, root_dir, arg);
+                ok = minigit::checkout_tree(store, root_dir, hash);
             }
             if (!ok) {
                 std::cerr << "checkout " << arg << " failed\n";
@@ -224,14 +475,6 @@ int command_checkout(int argc, char** argv) {
             return 0;
         }
 
-        std::string refname = "refs/heads/" + arg;
-        minigit::FileSystem fs(".minigit");
-        std::string hash;
-        if (!minigit::read_ref(fs, refname, hash)) {
-            std::cerr << "unknown revision: " << arg << "\n";
-            return 1;
-        }
-
         if (!minigit::checkout_commit(store, root_dir, hash)) {
             std::cerr << "checkout " << arg << " failed\n";
             return 1;
@@ -249,26 +492,97 @@ int command_checkout(int argc, char** argv) {
     return 1;
 }
 
-// 实现 add 子命令，将指定路径的文件加入暂存区
+// 展开 add 的路径参数：目录递归收集其中的普通文件（跳过 .minigit），路径去掉开头的 "./"
+bool collect_add_paths(const std::string& arg, std::vector<std::string>& files) {
+    std::string path = arg;
+    while (path.compare(0, 2, "./") == 0) {
+        path.erase(0, 2);
+    }
+    if (path == ".") {
+        path.clear();
+    }
+    struct stat st;
+    if (::stat(path.empty() ? "." : path.c_str(), &st) != 0) {
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return true;
+    }
+    DIR* dir = ::opendir(path.empty() ? "." : path.c_str());
+    if (!dir) {
+        return false;
+    }
+    std::vector<std::string> names;
+    dirent* de;
+    while ((de = ::readdir(dir)) != nullptr) {
+        std::string name = de->d_name;
+        if (name != "." && name != ".." && name != ".minigit") {
+            names.push_back(name);
+        }
+    }
+    ::closedir(dir);
+    std::sort(names.begin(), names.end());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::string child = path.empty() ? names[i] : path + "/" + names[i];
+        if (::lstat(child.c_str(), &st) != 0) {
+            return false;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (!collect_add_paths(child, files)) {
+                return false;
+            }
+        } else if (S_ISREG(st.st_mode)) {
+            files.push_back(child);
+        }
+    }
+    return true;
+}
+
+// 实现 add 子命令，将指定的文件或目录下的全部文件加入暂存区；
+// --bulk 时新 blob 直接流式写入同一个新包，而不是逐个生成松散对象
 int command_add(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "usage: mini-git add <file>\n";
+    bool bulk = false;
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--bulk") {
+            bulk = true;
+        } else if (!collect_add_paths(a, files)) {
+            std::cerr << "failed to open file: " << a << "\n";
+            return 1;
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "usage: mini-git add [--bulk] <path>...\n";
         return 1;
     }
 
-    std::string path = argv[2];
-
-    std::ifstream ifs(path.c_str(), std::ios::binary);
-    if (!ifs) {
-        std::cerr << "failed to open file: " << path << "\n";
+    minigit::ObjectStore& store = repo_store();
+    if (bulk && !store.begin_bulk_checkin()) {
+        std::cerr << "failed to start bulk check-in\n";
+        return 1;
+    }
+    std::vector<minigit::IndexEntry> added;
+    added.reserve(files.size());
+    // 所有文件复用一个按文件长度一次读入的缓冲区
+    std::string data;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (!minigit::read_file_into(files[i], data)) {
+            std::cerr << "failed to open file: " << files[i] << "\n";
+            return 1;
+        }
+        minigit::IndexEntry e;
+        e.mode = "100644";
+        e.path = files[i];
+        e.hash = store.store_blob(data.data(), data.size());
+        added.push_back(e);
+    }
+    // 包与索引必须先于引用它们的 index 落盘
+    if (bulk && !store.end_bulk_checkin()) {
+        std::cerr << "failed to write bulk check-in pack\n";
         return 1;
     }
-
-    std::string data((std::istreambuf_iterator<char>(ifs)),
-                     std::istreambuf_iterator<char>());
-
-    minigit::ObjectStore store(".minigit");
-    std::string hash = store.store_blob(data);
 
     minigit::FileSystem fs(".minigit");
     std::vector<minigit::IndexEntry> entries;
@@ -276,12 +590,7 @@ int command_add(int argc, char** argv) {
         std::cerr << "failed to read index\n";
         return 1;
     }
-
-    minigit::IndexEntry e;
-    e.mode = "100644";
-    e.path = path;
-    e.hash = hash;
-    minigit::upsert_index_entry(entries, e);
+    minigit::upsert_index_entries(entries, added);
 
     if (!minigit::write_index(fs, entries)) {
         std::cerr << "failed to write index\n";
@@ -306,7 +615,7 @@ int command_commit(int argc, char** argv) {
         return 1;
     }
 
-    minigit::ObjectStore store(".minigit");
+    minigit::ObjectStore& store = repo_store();
     std::string tree_hash = minigit::write_tree_from_index(store, entries);
 
     minigit::Head head;
@@ -352,19 +661,13 @@ int command_commit(int argc, char** argv) {
 }
 }  // namespace
 // 实现 merge 子命令：与指定提交或分支进行三方合并并生成 merge commit
-static bool read_commit(minigit::ObjectStore& store, const std::string& h, minigit::Commit& c) {
-    std::string body;
-    if (!store.read_object(h, body)) return false;
-    return minigit::parse_commit_object(body, c);
-}
-
 static std::string resolve_target_commit_hash(minigit::FileSystem& fs, const std::string& arg) {
     if (arg.size() == 40U) {
         return arg;
     }
     std::string refname = "refs/heads/" + arg;
     std::string hash;
-    if (minigit::read_ref(fs, refname, hash)) {
+    if (minigit::read_ref(fs, refname, hash) || resolve_object_name(arg, hash)) {
         return hash;
     }
     return std::string();
@@ -377,13 +680,14 @@ static std::string find_common_ancestor(minigit::ObjectStore& store,
     std::vector<std::string> aq;
     aq.push_back(a);
     std::set<std::string> Aanc;
+    minigit::ReadContext ctx;
+    minigit::Commit c;
     while (!aq.empty()) {
         std::string x = aq.back();
         aq.pop_back();
         if (Aanc.count(x)) continue;
         Aanc.insert(x);
-        minigit::Commit c;
-        if (!read_commit(store, x, c)) continue;
+        if (!minigit::read_commit(store, x, ctx, c)) continue;
         for (const auto& p : c.parents) {
             aq.push_back(p);
         }
@@ -396,8 +700,7 @@ static std::string find_common_ancestor(minigit::ObjectStore& store,
         if (visited.count(y)) continue;
         visited.insert(y);
         if (Aanc.count(y)) return y;
-        minigit::Commit c;
-        if (!read_commit(store, y, c)) continue;
+        if (!minigit::read_commit(store, y, ctx, c)) continue;
         for (const auto& p : c.parents) {
             queue.push_back(p);
         }
@@ -411,14 +714,15 @@ static bool is_ancestor(minigit::ObjectStore& store,
     std::vector<std::string> stack;
     stack.push_back(desc);
     std::set<std::string> visited;
+    minigit::ReadContext ctx;
+    minigit::Commit c;
     while (!stack.empty()) {
         std::string x = stack.back();
         stack.pop_back();
         if (x == anc) return true;
         if (visited.count(x)) continue;
         visited.insert(x);
-        minigit::Commit c;
-        if (!read_commit(store, x, c)) continue;
+        if (!minigit::read_commit(store, x, ctx, c)) continue;
         for (const auto& p : c.parents) {
             stack.push_back(p);
         }
@@ -454,7 +758,7 @@ int command_merge(int argc, char** argv) {
         return 1;
     }
     minigit::FileSystem fs(".minigit");
-    minigit::ObjectStore store(".minigit");
+    minigit::ObjectStore& store = repo_store();
     minigit::Head head;
     if (!minigit::read_head(fs, head)) {
         std::cerr << "HEAD is not set\n";
@@ -474,8 +778,10 @@ int command_merge(int argc, char** argv) {
         std::cerr << "unknown revision: " << target << "\n";
         return 1;
     }
+    minigit::ReadContext ctx;
     minigit::Commit oc, tc;
-    if (!read_commit(store, ours_commit, oc) || !read_commit(store, theirs_commit, tc)) {
+    if (!minigit::read_commit(store, ours_commit, ctx, oc) ||
+        !minigit::read_commit(store, theirs_commit, ctx, tc)) {
         std::cerr << "failed to read commits\n";
         return 1;
     }
@@ -509,7 +815,7 @@ int command_merge(int argc, char** argv) {
     std::vector<minigit::IndexEntry> ibase, iours, itheirs;
     if (!base.empty()) {
         minigit::Commit bc;
-        if (!read_commit(store, base, bc)) {
+        if (!minigit::read_commit(store, base, ctx, bc)) {
             std::cerr << "failed to read base commit\n";
             return 1;
         }
@@ -584,46 +890,799 @@ int command_merge(int argc, char** argv) {
     return 0;
 }
 
+// 解析 "--name=<非负整数>" 形式的选项，名称不匹配时返回 false
+static bool parse_size_option(const std::string& arg, const std::string& name,
+                              std::size_t& value, bool& valid) {
+    std::string prefix = name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    std::string digits = arg.substr(prefix.size());
+    valid = !digits.empty() && digits.find_first_not_of("0123456789") == std::string::npos;
+    if (valid) {
+        value = static_cast<std::size_t>(std::strtoull(digits.c_str(), nullptr, 10));
+    }
+    return true;
+}
+
+// 增量打包新的松散对象，必要时把最小的若干个包合并为一个
 int command_pack(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "usage: mini-git pack\n";
+    minigit::PackOptions options;
+    bool write_bitmap = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool valid = false;
+        if ((!parse_size_option(arg, "--window", options.window, valid) &&
+             !parse_size_option(arg, "--depth", options.depth, valid) &&
+             !parse_size_option(arg, "--threads", options.threads, valid) &&
+             !parse_size_option(arg, "--geometric", options.geometric_factor, valid)) ||
+            !valid) {
+            if (arg == "--all") {
+                options.all = true;
+                continue;
+            }
+            if (arg == "--write-bitmap") {
+                write_bitmap = true;
+                continue;
+            }
+            if (arg == "--uncompressed-metadata") {
+                options.uncompressed_metadata = true;
+                continue;
+            }
+            std::cerr << "usage: mini-git pack [--window=<n>] [--depth=<n>] [--threads=<n>]"
+                         " [--geometric=<factor>] [--all] [--write-bitmap]"
+                         " [--uncompressed-metadata]\n";
+            return 1;
+        }
+    }
+    minigit::FileSystem fs(".minigit");
+    minigit::MaintenanceLock lock;
+    if (!lock.try_acquire(fs)) {
+        std::cerr << "another maintenance process is running\n";
+        return 1;
+    }
+    minigit::PackStats stats;
+    std::string pack_path;
+    if (!minigit::repack_incremental(fs, options, stats, pack_path)) {
+        std::cerr << "failed to write pack\n";
+        return 1;
+    }
+    if (pack_path.empty()) {
+        std::cout << "nothing new to pack\n";
+    } else {
+        std::cout << "objects packed to " << pack_path << " (" << stats.objects << " objects, "
+                  << stats.deltas << " deltas, " << stats.merged_packs << " packs merged, "
+                  << stats.reused << " reused)\n";
+    }
+    if (!write_bitmap) {
+        return 0;
+    }
+    // 位图要求可达对象都在同一个包中，只在仓库只剩一个包时生成
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    if (packs.size() != 1U) {
+        std::cerr << "bitmaps need a single pack; rerun with --all\n";
+        return 1;
+    }
+    std::map<std::string, std::string> refs;
+    minigit::list_refs(fs, refs);
+    std::vector<std::string> tips;
+    for (std::map<std::string, std::string>::const_iterator it = refs.begin();
+         it != refs.end(); ++it) {
+        tips.push_back(it->second);
+    }
+    minigit::Head head;
+    if (minigit::read_head(fs, head) && !head.symbolic) {
+        tips.push_back(head.target);
+    }
+    minigit::ObjectStore store(".minigit");
+    std::size_t written = 0;
+    if (!minigit::write_pack_bitmap(store, fs, packs[0], tips, written)) {
+        std::cerr << "failed to write bitmap for " << packs[0] << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << written << " commit bitmaps\n";
+    return 0;
+}
+
+// 为 objects/pack 下的全部包增量更新多包索引
+int command_multi_pack_index(int argc, char** argv) {
+    if (argc != 3 || std::string(argv[2]) != "write") {
+        std::cerr << "usage: mini-git multi-pack-index write\n";
+        return 1;
+    }
+    minigit::FileSystem fs(".minigit");
+    if (!minigit::update_multi_pack_index(fs)) {
+        std::cerr << "failed to write multi-pack-index\n";
+        return 1;
+    }
+    return 0;
+}
+
+// 从 ref 出发回收不可达对象：可达对象重打包为单个包，过期的不可达对象被删除
+int command_gc(int argc, char** argv) {
+    minigit::GcOptions options;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool valid = false;
+        std::size_t grace = 0;
+        if (parse_size_option(arg, "--grace", grace, valid) && valid) {
+            options.grace_seconds = grace;
+            continue;
+        }
+        if (arg == "--uncompressed-metadata") {
+            options.pack.uncompressed_metadata = true;
+            continue;
+        }
+        if ((!parse_size_option(arg, "--window", options.pack.window, valid) &&
+             !parse_size_option(arg, "--depth", options.pack.depth, valid) &&
+             !parse_size_option(arg, "--threads", options.pack.threads, valid)) ||
+            !valid) {
+            std::cerr << "usage: mini-git gc [--grace=<seconds>] [--window=<n>] [--depth=<n>]"
+                         " [--threads=<n>] [--uncompressed-metadata]\n";
+            return 1;
+        }
+    }
+    minigit::FileSystem fs(".minigit");
+    minigit::MaintenanceLock lock;
+    if (!lock.try_acquire(fs)) {
+        std::cerr << "another maintenance process is running\n";
+        return 1;
+    }
+    minigit::GcReport report;
+    if (!minigit::gc_repository(fs, options, report)) {
+        std::cerr << "gc failed: cannot read every reachable object or write the new pack\n";
+        return 1;
+    }
+    std::cout << "packed " << report.pack.objects << " objects (" << report.reachable
+              << " reachable from refs, " << report.pack.deltas << " deltas, "
+              << report.pack.merged_packs << " old packs removed), " << report.loosened
+              << " recent unreachable objects kept, " << report.pruned << " pruned\n";
+    return 0;
+}
+
+// 把标准输入、输出与错误重定向到 /dev/null，供脱离终端的后台进程使用
+void redirect_stdio_to_devnull() {
+    int devnull = ::open("/dev/null", O_RDWR);
+    if (devnull >= 0) {
+        ::dup2(devnull, 0);
+        ::dup2(devnull, 1);
+        ::dup2(devnull, 2);
+        if (devnull > 2) {
+            ::close(devnull);
+        }
+    }
+}
+
+// 派生脱离终端、CPU 与 I/O 优先级都最低的后台子进程；返回值与 fork 相同
+pid_t fork_low_priority_background() {
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = ::fork();
+    if (pid != 0) {
+        return pid;
+    }
+    ::setsid();
+    ::setpriority(PRIO_PROCESS, 0, 19);
+#ifdef SYS_ioprio_set
+    // IOPRIO_WHO_PROCESS 为 1，IOPRIO_CLASS_IDLE 为 3，类别位于第 13 位之上
+    ::syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+    redirect_stdio_to_devnull();
+    return 0;
+}
+
+// 读取非负整数环境变量，未设置或非法时返回 fallback
+std::size_t size_from_env(const char* name, std::size_t fallback) {
+    const char* v = std::getenv(name);
+    if (!v || v[0] == '\0' ||
+        std::string(v).find_first_not_of("0123456789") != std::string::npos) {
+        return fallback;
+    }
+    return static_cast<std::size_t>(std::strtoull(v, nullptr, 10));
+}
+
+// 环境变量被显式设置为 "0" 时返回 true
+bool env_is_zero(const char* name) {
+    const char* v = std::getenv(name);
+    return v && std::string(v) == "0";
+}
+
+// 自动维护的阈值：MINIGIT_AUTO_LOOSE_LIMIT 与 MINIGIT_AUTO_PACK_LIMIT，0 表示不按该项触发
+minigit::MaintenanceOptions maintenance_options_from_env() {
+    minigit::MaintenanceOptions options;
+    options.loose_limit = size_from_env("MINIGIT_AUTO_LOOSE_LIMIT", options.loose_limit);
+    options.pack_limit = size_from_env("MINIGIT_AUTO_PACK_LIMIT", options.pack_limit);
+    return options;
+}
+
+// 输出一次维护的结果摘要
+void print_maintenance_report(const minigit::MaintenanceReport& report) {
+    if (report.skipped) {
+        std::cout << "maintenance skipped: another maintenance process is running\n";
+        return;
+    }
+    if (report.collected) {
+        std::cout << "gc: packed " << report.gc.pack.objects << " objects, pruned "
+                  << report.gc.pruned << " unreachable objects\n";
+    }
+    if (report.repacked) {
+        std::cout << "repack: " << report.pack.objects << " objects packed, "
+                  << report.pack.merged_packs << " packs merged\n";
+    }
+    if (report.rev_written != 0 || report.midx_written) {
+        std::cout << "indexes: " << report.rev_written << " reverse indexes written"
+                  << (report.midx_written ? ", multi-pack-index rewritten" : "") << "\n";
+    }
+    if (!report.collected && !report.repacked && report.rev_written == 0 &&
+        !report.midx_written) {
+        std::cout << "maintenance: nothing to do\n";
+    }
+}
+
+// 执行维护任务：默认做完整的垃圾回收，--auto 时只做达到阈值的任务，--detach 时在后台执行
+int command_maintenance(int argc, char** argv) {
+    bool auto_only = false;
+    bool detach = false;
+    bool valid = argc >= 3 && std::string(argv[2]) == "run";
+    for (int i = 3; valid && i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--auto") {
+            auto_only = true;
+        } else if (arg == "--detach") {
+            detach = true;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        std::cerr << "usage: mini-git maintenance run [--auto] [--detach]\n";
+        return 1;
+    }
+    minigit::FileSystem fs(".minigit");
+    if (!fs.exists("")) {
+        std::cerr << "not a mini-git repository\n";
+        return 1;
+    }
+    if (detach) {
+        pid_t pid = fork_low_priority_background();
+        if (pid < 0) {
+            std::cerr << "fork failed\n";
+            return 1;
+        }
+        if (pid > 0) {
+            std::cout << "maintenance started in background, pid " << pid << "\n";
+            return 0;
+        }
+    }
+    minigit::MaintenanceReport report;
+    bool ok = minigit::run_maintenance(fs, maintenance_options_from_env(), auto_only, report);
+    if (detach) {
+        std::_Exit(ok ? 0 : 1);
+    }
+    if (!ok) {
+        std::cerr << "maintenance failed\n";
         return 1;
     }
+    print_maintenance_report(report);
+    return 0;
+}
+
+// 写命令成功后检查维护阈值；达到阈值时默认在后台低优先级进程中维护，不阻塞当前命令。
+// MINIGIT_AUTO_MAINTENANCE=0 关闭自动维护，MINIGIT_AUTO_DETACH=0 改为在前台执行
+void run_auto_maintenance() {
+    if (env_is_zero("MINIGIT_AUTO_MAINTENANCE")) {
+        return;
+    }
     minigit::FileSystem fs(".minigit");
-    bool ok = minigit::write_pack_file(fs, "objects/pack/pack.mpk");
+    minigit::MaintenanceOptions options = maintenance_options_from_env();
+    minigit::MaintenanceStatus status;
+    minigit::check_maintenance(fs, status);
+    if (!minigit::maintenance_due(options, status)) {
+        return;
+    }
+    bool background = !env_is_zero("MINIGIT_AUTO_DETACH");
+    if (background && fork_low_priority_background() != 0) {
+        return;
+    }
+    minigit::MaintenanceReport report;
+    bool ok = minigit::run_maintenance(fs, options, true, report);
+    if (background) {
+        std::_Exit(ok ? 0 : 1);
+    }
     if (!ok) {
-        std::cerr << "no objects to pack\n";
+        std::cerr << "auto maintenance failed\n";
+    }
+}
+
+// 会写入对象、index 或 ref 的命令，成功后触发自动维护检查
+bool is_write_command(const std::string& cmd) {
+    return cmd == "add" || cmd == "commit" || cmd == "merge" || cmd == "hash-object" ||
+           cmd == "write-tree" || cmd == "fast-import";
+}
+
+// 并行检查全部对象与包文件，逐行输出发现的问题，有问题时返回非零
+int command_fsck(int argc, char** argv) {
+    minigit::FsckOptions options;
+    for (int i = 2; i < argc; ++i) {
+        bool valid = false;
+        if (!parse_size_option(argv[i], "--threads", options.threads, valid) || !valid) {
+            std::cerr << "usage: mini-git fsck [--threads=<n>]\n";
+            return 1;
+        }
+    }
+    minigit::FileSystem fs(".minigit");
+    minigit::FsckReport report;
+    bool ok = minigit::fsck_repository(fs, options, report);
+    for (std::size_t i = 0; i < report.errors.size(); ++i) {
+        std::cout << report.errors[i] << "\n";
+    }
+    std::cout << "checked " << report.loose_objects + report.packed_objects << " objects ("
+              << report.loose_objects << " loose, " << report.packed_objects << " packed in "
+              << report.packs << " packs), " << report.errors.size() << " problems\n";
+    return ok ? 0 : 1;
+}
+
+// 按包内偏移顺序输出每个打包对象的磁盘占用，最后给出每个包的合计
+int command_size_report(int argc, char** argv) {
+    (void)argv;
+    if (argc != 2) {
+        std::cerr << "usage: mini-git size-report\n";
         return 1;
     }
-    std::cout << "objects packed to objects/pack/pack.mpk\n";
+    minigit::FileSystem fs(".minigit");
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    std::vector<minigit::PackObjectSize> sizes;
+    std::ostringstream summary;
+    for (std::size_t p = 0; p < packs.size(); ++p) {
+        if (!minigit::pack_object_sizes(fs, packs[p], sizes)) {
+            std::cerr << "failed to read " << packs[p] << "\n";
+            return 1;
+        }
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < sizes.size(); ++i) {
+            std::cout << sizes[i].hash << " " << sizes[i].disk_size << "\n";
+            total += sizes[i].disk_size;
+        }
+        summary << packs[p] << ": " << sizes.size() << " objects, " << total << " bytes\n";
+    }
+    std::cout << summary.str();
     return 0;
 }
 
-// 程序入口，根据第一个参数选择执行的子命令
-int main(int argc, char** argv) {
-    spdlog::set_level(spdlog::level::info);
-    spdlog::set_level(spdlog::level::info);
+// 从标准输入读取 fast-import 流，对象直接写入新的包文件
+int command_fast_import(int argc, char** argv) {
+    (void)argv;
+    if (argc != 2) {
+        std::cerr << "usage: mini-git fast-import < stream\n";
+        return 1;
+    }
+    minigit::FileSystem fs(".minigit");
+    minigit::ObjectStore& store = repo_store();
+    minigit::FastImportStats stats;
+    int code = minigit::run_fast_import(store, fs, std::cin, std::cout, std::cerr, stats);
+    if (code != 0) {
+        return code;
+    }
+    std::cout << "imported " << stats.blobs << " blobs, " << stats.trees
+              << " trees, " << stats.commits << " commits (" << stats.duplicates
+              << " duplicates) into " << stats.packs << " pack(s); "
+              << stats.refs << " refs updated\n";
+    return 0;
+}
 
-    if (argc < 2) {
-        std::cerr << "usage: mini-git <command> [args]\n";
-        std::cerr << "commands:\n";
-        std::cerr << "  hash-object <file>\n";
-        std::cerr << "  write-tree\n";
-        std::cerr << "  add <file>\n";
-        std::cerr << "  commit -m <message>\n";
-        std::cerr << "  merge <commit|branch>\n";
-        std::cerr << "  branch [name]\n";
-        std::cerr << "  symbolic-ref HEAD <ref>\n";
-        std::cerr << "  status\n";
-        std::cerr << "  checkout [<branch>|<hash>]\n";
-        std::cerr << "  pack\n";
+namespace {
+
+// 解析 HEAD 当前指向的提交哈希，HEAD 不存在或分支无提交时返回空字符串
+std::string resolve_head_commit(const minigit::FileSystem& fs) {
+    minigit::Head head;
+    if (!minigit::read_head(fs, head)) {
+        return std::string();
+    }
+    if (!head.symbolic) {
+        return head.target;
+    }
+    std::string hash;
+    if (!minigit::read_ref(fs, head.target, hash)) {
+        return std::string();
+    }
+    return hash;
+}
+
+// 从身份字符串 "Name <email> <epoch> <tz>" 中提取 epoch 与时区
+void split_identity_date(const std::string& ident, long long& epoch, std::string& tz) {
+    epoch = 0;
+    tz.clear();
+    std::size_t gt = ident.rfind('>');
+    if (gt == std::string::npos) {
+        return;
+    }
+    std::istringstream iss(ident.substr(gt + 1));
+    iss >> epoch >> tz;
+}
+
+// 按 Git 默认格式渲染日期，例如 "Sat Oct 18 12:42:00 2026 +0800"
+std::string format_identity_date(const std::string& ident) {
+    long long epoch = 0;
+    std::string tz;
+    split_identity_date(ident, epoch, tz);
+    long offset = 0;
+    if (tz.size() == 5U && (tz[0] == '+' || tz[0] == '-')) {
+        offset = std::atol(tz.substr(1, 2).c_str()) * 3600L +
+                 std::atol(tz.substr(3, 2).c_str()) * 60L;
+        if (tz[0] == '-') {
+            offset = -offset;
+        }
+    }
+    std::time_t t = static_cast<std::time_t>(epoch + offset);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a %b %e %H:%M:%S %Y", &tm);
+    return std::string(buf) + " " + tz;
+}
+
+// 返回身份字符串中去掉时间戳后的 "姓名 <邮箱>" 部分
+std::string identity_without_date(const std::string& ident) {
+    std::size_t gt = ident.rfind('>');
+    if (gt == std::string::npos) {
+        return ident;
+    }
+    return ident.substr(0, gt + 1);
+}
+
+// 实现 log 子命令：按提交时间从新到旧输出可达提交
+int command_log(int argc, char** argv) {
+    long max_count = -1;
+    bool oneline = false;
+    std::string rev;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--oneline") {
+            oneline = true;
+        } else if (a == "-n" && i + 1 < argc) {
+            max_count = std::atol(argv[++i]);
+        } else if (a.compare(0, 2, "-n") == 0 && a.size() > 2U) {
+            max_count = std::atol(a.c_str() + 2);
+        } else if (rev.empty()) {
+            rev = a;
+        } else {
+            std::cerr << "usage: mini-git log [--oneline] [-n <count>] [<commit|branch>]\n";
+            return 1;
+        }
+    }
+
+    minigit::FileSystem fs(".minigit");
+    std::string start;
+    if (rev.empty() || rev == "HEAD") {
+        start = resolve_head_commit(fs);
+        if (start.empty()) {
+            std::cerr << "current branch has no commits\n";
+            return 1;
+        }
+    } else {
+        start = resolve_target_commit_hash(fs, rev);
+        if (start.empty()) {
+            std::cerr << "unknown revision: " << rev << "\n";
+            return 1;
+        }
+    }
+
+    minigit::ObjectStore& store = repo_store();
+    minigit::CommitCache& commits = repo_commit_cache();
+
+    // 优先队列按提交时间排序，时间相同时先入队者优先，保证输出稳定
+    typedef std::pair<std::pair<long long, long long>, std::string> QueueItem;
+    long long seq = 0;
+    std::priority_queue<QueueItem> queue;
+    std::set<std::string> seen;
+    const minigit::Commit* c = commits.lookup(store, start);
+    if (!c) {
+        std::cerr << "failed to read commit " << start << "\n";
         return 1;
     }
+    long long epoch = 0;
+    std::string tz;
+    split_identity_date(c->committer, epoch, tz);
+    queue.push(QueueItem(std::make_pair(epoch, -(seq++)), start));
+    seen.insert(start);
+
+    long shown = 0;
+    std::vector<std::string> parents;
+    while (!queue.empty() && (max_count < 0 || shown < max_count)) {
+        std::string hash = queue.top().second;
+        queue.pop();
+        c = commits.lookup(store, hash);
+        if (!c) {
+            std::cerr << "failed to read commit " << hash << "\n";
+            return 1;
+        }
 
+        if (oneline) {
+            std::string subject = c->message.substr(0, c->message.find('\n'));
+            std::cout << store.abbreviate(hash) << " " << subject << "\n";
+        } else {
+            if (shown > 0) {
+                std::cout << "\n";
+            }
+            std::cout << "commit " << hash << "\n";
+            if (c->parents.size() > 1U) {
+                std::cout << "Merge:";
+                for (std::size_t i = 0; i < c->parents.size(); ++i) {
+                    std::cout << " " << store.abbreviate(c->parents[i]);
+                }
+                std::cout << "\n";
+            }
+            std::cout << "Author: " << identity_without_date(c->author) << "\n";
+            std::cout << "Date:   " << format_identity_date(c->author) << "\n\n";
+            std::istringstream msg(c->message);
+            std::string line;
+            while (std::getline(msg, line)) {
+                std::cout << "    " << line << "\n";
+            }
+        }
+        ++shown;
+
+        // lookup 返回的指针在下一次查找后可能失效，先复制父提交列表
+        parents = c->parents;
+        for (std::size_t i = 0; i < parents.size(); ++i) {
+            if (!seen.insert(parents[i]).second) {
+                continue;
+            }
+            const minigit::Commit* pc = commits.lookup(store, parents[i]);
+            if (!pc) {
+                continue;
+            }
+            split_identity_date(pc->committer, epoch, tz);
+            queue.push(QueueItem(std::make_pair(epoch, -(seq++)), parents[i]));
+        }
+    }
+    return 0;
+}
+
+int dispatch(int argc, char** argv);
+bool is_forwardable(int argc, char** argv);
+
+// 在 daemon 进程内执行一次请求，捕获标准输出与标准错误；只执行客户端允许转发的只读命令
+int handle_daemon_request(minigit::DaemonServer& server,
+                          const std::vector<std::string>& args,
+                          std::string& out, std::string& err) {
+    if (args.size() == 2U && args[0] == "daemon" && args[1] == "--stop") {
+        server.request_stop();
+        out = "daemon stopping\n";
+        return 0;
+    }
+
+    std::vector<std::string> storage;
+    storage.push_back("mini-git");
+    storage.insert(storage.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (std::size_t i = 0; i < storage.size(); ++i) {
+        argv.push_back(&storage[i][0]);
+    }
+    argv.push_back(nullptr);
+    if (args.empty() || !is_forwardable(static_cast<int>(storage.size()), argv.data())) {
+        // 套接字可被任何同用户进程连接，不能让它借 daemon 执行写操作
+        err = "error: command is not served by the daemon\n";
+        return 1;
+    }
+
+    std::ostringstream out_buf;
+    std::ostringstream err_buf;
+    std::streambuf* old_out = std::cout.rdbuf(out_buf.rdbuf());
+    std::streambuf* old_err = std::cerr.rdbuf(err_buf.rdbuf());
+    int code = 1;
+    try {
+        code = dispatch(static_cast<int>(storage.size()), argv.data());
+    } catch (const std::exception& ex) {
+        err_buf << "error: " << ex.what() << "\n";
+        code = 1;
+    }
+    std::cout.rdbuf(old_out);
+    std::cerr.rdbuf(old_err);
+
+    out = out_buf.str();
+    err = err_buf.str();
+    return code;
+}
+
+// 把 rev-list 参数解析为提交哈希，支持 HEAD、分支名与完整哈希
+std::string resolve_rev(minigit::FileSystem& fs, const std::string& rev) {
+    if (rev == "HEAD") {
+        return resolve_head_commit(fs);
+    }
+    return resolve_target_commit_hash(fs, rev);
+}
+
+// 实现 rev-list 子命令：列出或统计从给定提交可达、且从 ^ 前缀的提交不可达的对象；
+// --use-bitmap-index 时先尝试以位图回答，位图无法覆盖时退回逐个对象遍历
+int command_rev_list(int argc, char** argv) {
+    bool count = false;
+    bool objects = false;
+    bool use_bitmap = false;
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+    minigit::FileSystem fs(".minigit");
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--count") {
+            count = true;
+        } else if (a == "--objects") {
+            objects = true;
+        } else if (a == "--use-bitmap-index") {
+            use_bitmap = true;
+        } else if (a.compare(0, 2, "--") == 0) {
+            include.clear();
+            break;
+        } else {
+            bool negated = a[0] == '^';
+            std::string hash = resolve_rev(fs, negated ? a.substr(1) : a);
+            if (hash.empty()) {
+                std::cerr << "bad revision: " << a << "\n";
+                return 1;
+            }
+            (negated ? exclude : include).push_back(hash);
+        }
+    }
+    if (include.empty()) {
+        std::cerr << "usage: mini-git rev-list [--count] [--objects] [--use-bitmap-index]"
+                     " <commit>... [^<commit>...]\n";
+        return 1;
+    }
+
+    minigit::ObjectStore& store = repo_store();
+    if (use_bitmap) {
+        minigit::PackBitmapIndex bitmaps;
+        minigit::Bitmap wanted;
+        minigit::Bitmap unwanted;
+        if (bitmaps.open_any(fs) && bitmaps.reachable(store, include, wanted) &&
+            bitmaps.reachable(store, exclude, unwanted)) {
+            wanted.and_not(unwanted);
+            if (!objects) {
+                wanted.and_with(bitmaps.type_bitmap(minigit::ObjectType::kCommit));
+            }
+            if (count) {
+                std::cout << wanted.count() << "\n";
+                return 0;
+            }
+            std::vector<std::size_t> positions;
+            wanted.positions(positions);
+            for (std::size_t i = 0; i < positions.size(); ++i) {
+                std::cout << bitmaps.hash_at(positions[i]) << "\n";
+            }
+            return 0;
+        }
+    }
+    std::vector<std::string> listed;
+    if (!minigit::list_reachable_objects(store, include, exclude, objects, listed)) {
+        std::cerr << "failed to read objects\n";
+        return 1;
+    }
+    if (count) {
+        std::cout << listed.size() << "\n";
+        return 0;
+    }
+    for (std::size_t i = 0; i < listed.size(); ++i) {
+        std::cout << listed[i] << "\n";
+    }
+    return 0;
+}
+
+// 实现 daemon 子命令：常驻进程保持对象、提交与 index 缓存，通过 Unix 域套接字提供服务
+int command_daemon(int argc, char** argv) {
+    bool detach = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--stop") {
+            std::vector<std::string> args;
+            args.push_back("daemon");
+            args.push_back("--stop");
+            minigit::DaemonResponse resp;
+            if (!minigit::daemon_request(kDaemonSocket, args, resp)) {
+                std::cerr << "daemon is not running\n";
+                return 1;
+            }
+            std::cout << resp.out;
+            return resp.exit_code;
+        } else if (a == "--detach") {
+            detach = true;
+        } else {
+            std::cerr << "usage: mini-git daemon [--detach|--stop]\n";
+            return 1;
+        }
+    }
+
+    minigit::FileSystem fs(".minigit");
+    if (!fs.exists("")) {
+        std::cerr << "not a mini-git repository\n";
+        return 1;
+    }
+
+    minigit::DaemonServer server(kDaemonSocket);
+    if (!server.listen()) {
+        std::cerr << "failed to listen on " << kDaemonSocket
+                  << " (is a daemon already running?)\n";
+        return 1;
+    }
+
+    if (detach) {
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            std::cerr << "fork failed\n";
+            return 1;
+        }
+        if (pid > 0) {
+            std::cout << "daemon started, pid " << pid << "\n";
+            std::cout.flush();
+            // 父进程不拥有监听套接字的清理责任
+            std::_Exit(0);
+        }
+        ::setsid();
+        redirect_stdio_to_devnull();
+    }
+
+    repo_store().set_cache_limit(256U * 1024U * 1024U);
+    repo_store().set_delta_base_cache_limit(128U * 1024U * 1024U);
+    repo_commit_cache().set_capacity(200000U);
+
+    spdlog::info("daemon listening on {}", kDaemonSocket);
+    server.serve([&server](const std::vector<std::string>& args,
+                           std::string& out, std::string& err) {
+        return handle_daemon_request(server, args, out, err);
+    });
+    return 0;
+}
+
+// 判断命令是否为只读查询，可安全转发给 daemon 执行
+bool is_forwardable(int argc, char** argv) {
+    std::string cmd = argv[1];
+    if (cmd == "status" || cmd == "log") {
+        return true;
+    }
+    if (cmd == "branch" && argc == 2) {
+        return true;
+    }
+    if (cmd == "cat-file" && argc == 4 && std::string(argv[2]).compare(0, 7, "--batch") != 0) {
+        return true;
+    }
+    return false;
+}
+
+// 若 daemon 正在运行则转发只读命令，返回 true 表示已由 daemon 处理
+bool try_forward_to_daemon(int argc, char** argv, int& exit_code) {
+    const char* disabled = std::getenv("MINIGIT_NO_DAEMON");
+    if (disabled && disabled[0] != '\0' && std::string(disabled) != "0") {
+        return false;
+    }
+    if (!is_forwardable(argc, argv)) {
+        return false;
+    }
+    struct stat st;
+    if (::stat(kDaemonSocket, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        return false;
+    }
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    minigit::DaemonResponse resp;
+    if (!minigit::daemon_request(kDaemonSocket, args, resp)) {
+        return false;
+    }
+    std::cout << resp.out;
+    std::cerr << resp.err;
+    exit_code = resp.exit_code;
+    return true;
+}
+
+// 根据第一个参数选择执行的子命令
+int dispatch(int argc, char** argv) {
     std::string cmd = argv[1];
     if (cmd == "hash-object") {
         return command_hash_object(argc, argv);
     }
+    if (cmd == "cat-file") {
+        return command_cat_file(argc, argv);
+    }
     if (cmd == "write-tree") {
         return command_write_tree(argc, argv);
     }
@@ -645,13 +1704,87 @@ int main(int argc, char** argv) {
     if (cmd == "status") {
         return command_status(argc, argv);
     }
+    if (cmd == "log") {
+        return command_log(argc, argv);
+    }
     if (cmd == "checkout") {
         return command_checkout(argc, argv);
     }
     if (cmd == "pack") {
         return command_pack(argc, argv);
     }
+    if (cmd == "daemon") {
+        return command_daemon(argc, argv);
+    }
+    if (cmd == "fast-import") {
+        return command_fast_import(argc, argv);
+    }
+    if (cmd == "multi-pack-index") {
+        return command_multi_pack_index(argc, argv);
+    }
+    if (cmd == "rev-list") {
+        return command_rev_list(argc, argv);
+    }
+    if (cmd == "size-report") {
+        return command_size_report(argc, argv);
+    }
+    if (cmd == "gc") {
+        return command_gc(argc, argv);
+    }
+    if (cmd == "fsck") {
+        return command_fsck(argc, argv);
+    }
+    if (cmd == "maintenance") {
+        return command_maintenance(argc, argv);
+    }
 
     std::cerr << "unknown command: " << cmd << "\n";
     return 1;
 }
+
+}  // namespace
+
+// 程序入口，daemon 运行时优先转发只读命令，否则在本进程内执行
+int main(int argc, char** argv) {
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_level(spdlog::level::info);
+
+    if (argc < 2) {
+        std::cerr << "usage: mini-git <command> [args]\n";
+        std::cerr << "commands:\n";
+        std::cerr << "  hash-object [-w] (<file>|--stdin-paths)\n";
+        std::cerr << "  cat-file (-t|-s|-p|<type>) <object>\n";
+        std::cerr << "  cat-file (--batch|--batch-check) [--buffer]\n";
+        std::cerr << "  write-tree [--bulk]\n";
+        std::cerr << "  add [--bulk] <path>...\n";
+        std::cerr << "  commit -m <message>\n";
+        std::cerr << "  merge <commit|branch>\n";
+        std::cerr << "  branch [name]\n";
+        std::cerr << "  symbolic-ref HEAD <ref>\n";
+        std::cerr << "  status\n";
+        std::cerr << "  log [--oneline] [-n <count>] [<commit|branch>]\n";
+        std::cerr << "  checkout [<branch>|<hash>]\n";
+        std::cerr << "  pack [--window=<n>] [--depth=<n>] [--threads=<n>] [--geometric=<factor>]"
+                     " [--all] [--write-bitmap] [--uncompressed-metadata]\n";
+        std::cerr << "  multi-pack-index write\n";
+        std::cerr << "  size-report\n";
+        std::cerr << "  gc [--grace=<seconds>] [--window=<n>] [--depth=<n>] [--threads=<n>]"
+                     " [--uncompressed-metadata]\n";
+        std::cerr << "  fsck [--threads=<n>]\n";
+        std::cerr << "  maintenance run [--auto] [--detach]\n";
+        std::cerr << "  rev-list [--count] [--objects] [--use-bitmap-index] <commit>... [^<commit>...]\n";
+        std::cerr << "  fast-import < stream\n";
+        std::cerr << "  daemon [--detach|--stop]\n";
+        return 1;
+    }
+
+    int forwarded_code = 0;
+    if (try_forward_to_daemon(argc, argv, forwarded_code)) {
+        return forwarded_code;
+    }
+    int code = dispatch(argc, argv);
+    if (code == 0 && is_write_command(argv[1])) {
+        run_auto_maintenance();
+    }
+    return code;
+}
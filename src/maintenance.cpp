@@ -0,0 +1,138 @@
+#include "maintenance.h"
+
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <set>
+#include <string>
+#include <sys/file.h>
+#include <unistd.h>
+#include <vector>
+
+#include "pack_index.h"
+
+// 本文件实现按阈值触发的仓库自动维护
+namespace minigit {
+
+// 抽样统计的扇出目录，与 Git 的 gc --auto 相同
+static const char kSampleDir[] = "objects/17";
+
+MaintenanceLock::MaintenanceLock() : fd_(-1) {}
+
+MaintenanceLock::~MaintenanceLock() {
+    if (fd_ >= 0) {
+        ::flock(fd_, LOCK_UN);
+        ::close(fd_);
+    }
+}
+
+// 打开（必要时创建）锁文件并尝试加上排他的 flock
+bool MaintenanceLock::try_acquire(const FileSystem& fs) {
+    if (fd_ >= 0) {
+        return true;
+    }
+    int fd = ::open(fs.make_path("maintenance.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    return true;
+}
+
+// 抽样目录中的对象数乘以扇出目录数估计松散对象总数
+void check_maintenance(const FileSystem& fs, MaintenanceStatus& status) {
+    status = MaintenanceStatus();
+    DIR* d = ::opendir(fs.make_path(kSampleDir).c_str());
+    if (d) {
+        dirent* de;
+        while ((de = ::readdir(d)) != nullptr) {
+            if (std::strlen(de->d_name) == 38) {
+                status.loose_estimate += 256U;
+            }
+        }
+        ::closedir(d);
+    }
+
+    std::vector<std::string> packs;
+    list_pack_files(fs, packs);
+    status.packs = packs.size();
+    MultiPackIndex midx;
+    std::set<std::string> covered;
+    if (midx.open(fs.make_path(std::string("objects/pack/") + kMultiPackIndexName))) {
+        for (std::size_t i = 0; i < midx.pack_count(); ++i) {
+            covered.insert(midx.pack_name(i));
+        }
+    }
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        std::string name = packs[i].substr(packs[i].find_last_of('/') + 1);
+        if (!covered.count(name) || !fs.exists(pack_sibling_path(packs[i], ".rev"))) {
+            ++status.stale_indexes;
+        }
+    }
+}
+
+bool maintenance_due(const MaintenanceOptions& options, const MaintenanceStatus& status) {
+    return (options.loose_limit != 0 && status.loose_estimate >= options.loose_limit) ||
+           (options.pack_limit != 0 && status.packs >= options.pack_limit) ||
+           status.stale_indexes != 0;
+}
+
+// 为缺少反向索引的包补写 .rev，多包索引未覆盖全部包时重新生成
+static bool refresh_indexes(const FileSystem& fs, MaintenanceReport& report) {
+    std::vector<std::string> packs;
+    list_pack_files(fs, packs);
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        std::string rev = pack_sibling_path(packs[i], ".rev");
+        if (fs.exists(rev)) {
+            continue;
+        }
+        PackIndex index;
+        PackReader reader;
+        if (!index.open(fs.make_path(pack_sibling_path(packs[i], ".idx"))) ||
+            !reader.open(fs.make_path(packs[i])) || !reader.content_id() ||
+            !write_pack_reverse_index(fs.make_path(rev), index, reader.content_id())) {
+            return false;
+        }
+        ++report.rev_written;
+    }
+    MaintenanceStatus status;
+    check_maintenance(fs, status);
+    if (status.stale_indexes == 0) {
+        return true;
+    }
+    report.midx_written = true;
+    return update_multi_pack_index(fs);
+}
+
+// 持锁后重新检查状态再选择任务，排队等待期间其他进程可能已经完成了维护
+bool run_maintenance(FileSystem& fs, const MaintenanceOptions& options, bool auto_only,
+                     MaintenanceReport& report) {
+    report = MaintenanceReport();
+    MaintenanceLock lock;
+    if (!lock.try_acquire(fs)) {
+        report.skipped = true;
+        return true;
+    }
+    MaintenanceStatus status;
+    check_maintenance(fs, status);
+    if (!auto_only || (options.pack_limit != 0 && status.packs >= options.pack_limit)) {
+        report.collected = true;
+        if (!gc_repository(fs, options.gc, report.gc)) {
+            return false;
+        }
+    } else if (options.loose_limit != 0 && status.loose_estimate >= options.loose_limit) {
+        report.repacked = true;
+        std::string pack;
+        if (!repack_incremental(fs, options.gc.pack, report.pack, pack)) {
+            return false;
+        }
+    }
+    return refresh_indexes(fs, report);
+}
+
+}  // namespace minigit
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+
+#include "filesystem.h"
+#include "gc.h"
+#include "pack.h"
+
+// 本文件声明按阈值触发的仓库自动维护
+namespace minigit {
+
+/**
+ * @brief 自动维护的阈值与参数。
+ */
+struct MaintenanceOptions {
+    /// 估计的松散对象数达到此值时做增量重打包，0 表示不按松散对象数触发。
+    std::size_t loose_limit = 6700;
+    /// 包数量达到此值时做完整的垃圾回收，0 表示不按包数量触发。
+    std::size_t pack_limit = 50;
+    /// 完整回收时的重打包参数与保留期；增量重打包也使用其中的 pack 参数。
+    GcOptions gc;
+};
+
+/**
+ * @brief 仓库当前的维护状态，见 check_maintenance。
+ */
+struct MaintenanceStatus {
+    /// 估计的松散对象数量。
+    std::size_t loose_estimate = 0;
+    /// 包文件数量。
+    std::size_t packs = 0;
+    /// 缺少反向索引或未被多包索引覆盖的包数量。
+    std::size_t stale_indexes = 0;
+};
+
+/**
+ * @brief 一次维护执行的结果。
+ */
+struct MaintenanceReport {
+    /// 另一个维护进程持有锁，本次什么也没做。
+    bool skipped = false;
+    /// 是否做了增量重打包。
+    bool repacked = false;
+    /// 是否做了完整的垃圾回收。
+    bool collected = false;
+    /// 增量重打包的统计信息。
+    PackStats pack;
+    /// 垃圾回收的统计信息。
+    GcReport gc;
+    /// 重新生成的反向索引数量。
+    std::size_t rev_written = 0;
+    /// 是否重新生成了多包索引。
+    bool midx_written = false;
+};
+
+/**
+ * @brief 仓库维护锁，持有期间其他维护、pack 与 gc 不会改写包目录。
+ *
+ * 基于 <root>/maintenance.lock 上的 flock：进程退出时内核自动释放，不会留下过期的锁。
+ */
+class MaintenanceLock {
+public:
+    MaintenanceLock();
+
+    /**
+     * @brief 释放锁（若持有）。
+     */
+    ~MaintenanceLock();
+
+    MaintenanceLock(const MaintenanceLock&) = delete;
+    MaintenanceLock& operator=(const MaintenanceLock&) = delete;
+
+    /**
+     * @brief 尝试以非阻塞方式获取锁。
+     *
+     * @param fs 仓库根目录对应的文件系统对象。
+     * @return 获取成功返回 true；锁已被其他进程持有或无法创建锁文件时返回 false。
+     */
+    bool try_acquire(const FileSystem& fs);
+
+private:
+    int fd_;
+};
+
+/**
+ * @brief 以只读取少量目录项的代价检查仓库的维护状态。
+ *
+ * 与 Git 相同，松散对象数由 objects/17 目录中的对象数乘以 256 估计；
+ * 包数量与索引状态只读取 objects/pack 目录与多包索引的包列表。
+ *
+ * @param fs     仓库根目录对应的文件系统对象。
+ * @param status 输出参数，维护状态。
+ */
+void check_maintenance(const FileSystem& fs, MaintenanceStatus& status);
+
+/**
+ * @brief 判断维护状态是否达到自动维护的阈值。
+ *
+ * @param options 阈值。
+ * @param status  check_maintenance 得到的状态。
+ * @return 松散对象数、包数量任一达到阈值或存在过期索引时返回 true。
+ */
+bool maintenance_due(const MaintenanceOptions& options, const MaintenanceStatus& status);
+
+/**
+ * @brief 在维护锁保护下执行维护任务。
+ *
+ * 自动模式（auto_only 为 true）下按阈值选择任务：包数量达到 pack_limit 时做完整的
+ * 垃圾回收（见 gc_repository），否则松散对象数达到 loose_limit 时做增量重打包
+ * （见 repack_incremental，已入包的松散对象随之删除）；手动模式总是做完整的垃圾回收。
+ * 两种模式最后都为缺少反向索引的包补写 .rev，并在多包索引未覆盖全部包时重新生成。
+ *
+ * @param fs        仓库根目录对应的文件系统对象。
+ * @param options   阈值与回收参数。
+ * @param auto_only 是否只执行达到阈值的任务。
+ * @param report    输出参数，执行结果；锁被占用时只设置 skipped。
+ * @return 成功（包括因锁被占用而跳过）返回 true，任一任务失败返回 false。
+ */
+bool run_maintenance(FileSystem& fs, const MaintenanceOptions& options, bool auto_only,
+                     MaintenanceReport& report);
+
+}  // namespace minigit
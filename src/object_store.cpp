@@ -1,25 +1,243 @@
 #include "object_store.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "blob.h"
+#include "byte_slice.h"
 #include "hash.h"
+#include "pack.h"
 #include "zlib_utils.h"
 
 // 本文件实现对象存储逻辑，将各类 Git 对象持久化到磁盘
 namespace minigit {
 
+// 返回对象类型对应的头部名称
+const char* object_type_name(ObjectType type) {
+    switch (type) {
+        case ObjectType::kCommit:
+            return "commit";
+        case ObjectType::kTree:
+            return "tree";
+        case ObjectType::kBlob:
+            return "blob";
+        default:
+            return "";
+    }
+}
+
+// 将头部中的类型名称解析为对象类型
+ObjectType parse_object_type(const char* name, std::size_t size) {
+    if (size == 4 && std::memcmp(name, "blob", 4) == 0) {
+        return ObjectType::kBlob;
+    }
+    if (size == 4 && std::memcmp(name, "tree", 4) == 0) {
+        return ObjectType::kTree;
+    }
+    if (size == 6 && std::memcmp(name, "commit", 6) == 0) {
+        return ObjectType::kCommit;
+    }
+    return ObjectType::kNone;
+}
+
+// 解析 "type size\0" 头部，不要求正文完整存在
+bool parse_object_header(const char* data, std::size_t size, ObjectType& type,
+                         std::size_t& body_size, std::size_t& header_len) {
+    const char* nul = static_cast<const char*>(std::memchr(data, '\0', size));
+    if (!nul) {
+        return false;
+    }
+    const char* space =
+        static_cast<const char*>(std::memchr(data, ' ', static_cast<std::size_t>(nul - data)));
+    if (!space) {
+        return false;
+    }
+
+    type = parse_object_type(data, static_cast<std::size_t>(space - data));
+    if (type == ObjectType::kNone) {
+        return false;
+    }
+
+    std::size_t declared = 0;
+    const char* p = space + 1;
+    if (p == nul) {
+        return false;
+    }
+    for (; p < nul; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        declared = declared * 10U + static_cast<std::size_t>(*p - '0');
+    }
+
+    body_size = declared;
+    header_len = static_cast<std::size_t>(nul - data) + 1U;
+    return true;
+}
+
+// 解析完整对象的头部，校验长度并返回指向正文的视图
+static bool parse_full_object(const char* data, std::size_t size, ObjectView& out) {
+    ObjectType type = ObjectType::kNone;
+    std::size_t declared = 0;
+    std::size_t body_offset = 0;
+    if (!parse_object_header(data, size, type, declared, body_offset)) {
+        return false;
+    }
+    if (size - body_offset != declared) {
+        return false;
+    }
+
+    out.type = type;
+    out.size = declared;
+    out.data = data + body_offset;
+    return true;
+}
+
+// 将整个文件读入可复用缓冲区，尽量沿用缓冲区已有容量
+static bool read_whole_file(const std::string& path, std::string& buffer) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    buffer.resize(static_cast<std::size_t>(st.st_size));
+    std::size_t done = 0;
+    while (done < buffer.size()) {
+        ssize_t n = ::read(fd, &buffer[done], buffer.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ::close(fd);
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return true;
+}
+
+// 读取对象类型与长度时需要读取的压缩数据前缀长度，足以解压出对象头部
+static const std::size_t kInfoPrefixBytes = 512U;
+
+// 批量读取中每段任务包含的对象数，足够小以让多个线程沿磁盘顺序交错推进
+static const std::size_t kReadManyChunk = 32U;
+
+// 批量读取中一个对象的位置，pack 为空表示松散对象
+struct PlannedRead {
+    std::string hash;
+    std::string pack;
+    std::uint64_t offset;
+};
+
+// 批量读取的共享状态：按磁盘顺序排列的读取计划、下一段的起点、回调与结果标志
+struct ReadManyState {
+    ReadManyState(const std::vector<PlannedRead>& r, const ReadManyCallback& cb)
+        : reads(r), callback(cb), next(0), stop(false), failed(false) {}
+
+    const std::vector<PlannedRead>& reads;
+    const ReadManyCallback& callback;
+    std::atomic<std::size_t> next;
+    std::atomic<bool> stop;
+    std::atomic<bool> failed;
+    std::mutex deliver;
+};
+
+// 按顺序领取任务段：先对段内每个包的连续范围发出预读，再逐个读取、解压并投递
+static void read_many_worker(const std::string& objects_path, PackSet& packs,
+                             ReadManyState& state) {
+    const std::vector<PlannedRead>& reads = state.reads;
+    std::string compressed;
+    std::string inflated;
+    std::string path;
+    ZlibInflater inflater;
+    for (std::size_t begin = state.next.fetch_add(kReadManyChunk);
+         begin < reads.size() && !state.stop; begin = state.next.fetch_add(kReadManyChunk)) {
+        std::size_t end = std::min(reads.size(), begin + kReadManyChunk);
+        for (std::size_t i = begin; i < end;) {
+            std::size_t j = i + 1;
+            if (!reads[i].pack.empty()) {
+                while (j < end && reads[j].pack == reads[i].pack) {
+                    ++j;
+                }
+                packs.prefetch(reads[i].pack, reads[i].offset, reads[j - 1].offset);
+            }
+            i = j;
+        }
+        for (std::size_t i = begin; i < end && !state.stop; ++i) {
+            const PlannedRead& r = reads[i];
+            bool ok = false;
+            if (r.pack.empty()) {
+                path.assign(objects_path);
+                path.push_back('/');
+                path.append(r.hash, 0, 2);
+                path.push_back('/');
+                path.append(r.hash, 2, std::string::npos);
+                ok = read_whole_file(path, compressed) &&
+                     inflater.inflate_into(compressed.data(), compressed.size(), inflated);
+            } else {
+                ok = packs.read_packed_at(r.pack, r.offset, inflated);
+            }
+            ObjectView view;
+            if (!ok || !parse_full_object(inflated.data(), inflated.size(), view)) {
+                state.failed = true;
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(state.deliver);
+            if (!state.stop && !state.callback(r.hash, view)) {
+                state.stop = true;
+            }
+        }
+    }
+}
+
 // 使用给定仓库根目录构造对象存储，并确保 objects 目录存在
 ObjectStore::ObjectStore(const std::string& root)
-    : fs_(root), objects_dir_("objects") {
+    : fs_(root), packs_(new PackSet(root)), objects_dir_("objects"),
+      objects_path_(fs_.make_path(objects_dir_)) {
     fs_.ensure_directory(objects_dir_);
 }
 
-// 内部辅助函数：根据对象内容计算哈希并落盘
-static std::string store_raw_object(FileSystem& fs, const std::string& objects_dir,
-                                    const std::string& content) {
-    std::string compressed = zlib_compress(content);
-    std::string hash = sha1_hex(content);
+ObjectStore::~ObjectStore() {}
+
+// 对象已存在时把其松散文件或所在包的修改时间更新为当前时间，使并发 gc 按新对象保留它；
+// 文件在检查后消失时返回 false，由调用方重新写入
+static bool freshen_object(const FileSystem& fs, PackSet& packs, const std::string& path,
+                           const std::string& hash) {
+    if (fs.exists(path)) {
+        return ::utimensat(AT_FDCWD, fs.make_path(path).c_str(), nullptr, 0) == 0;
+    }
+    std::string pack_name;
+    std::uint64_t offset = 0;
+    if (!packs.locate_object(hash, pack_name, offset)) {
+        return false;
+    }
+    return ::utimensat(AT_FDCWD, fs.make_path("objects/pack/" + pack_name).c_str(), nullptr,
+                       0) == 0;
+}
+
+// 内部辅助函数：对按顺序排列的切片计算哈希，并流式压缩写入临时文件后原子改名；
+// 批量写入期间改为追加到批量写入的包中
+static std::string store_raw_object(FileSystem& fs, PackSet& packs, PackWriter* bulk,
+                                    const std::string& objects_dir,
+                                    const ByteSlice* slices, std::size_t count) {
+    std::string hash = sha1_hex(slices, count);
 
     if (hash.size() < 3) {
         throw std::runtime_error("invalid hash");
@@ -27,58 +245,450 @@ static std::string store_raw_object(FileSystem& fs, const std::string& objects_d
 
     std::string dir = objects_dir + "/" + hash.substr(0, 2);
     std::string file = hash.substr(2);
-
-    fs.ensure_directory(dir);
     std::string path = dir + "/" + file;
 
-    if (!fs.exists(path)) {
-        if (!fs.write_file(path, compressed)) {
-            throw std::runtime_error("failed to write object file");
+    if (freshen_object(fs, packs, path, hash)) {
+        return hash;
+    }
+    if (bulk) {
+        if (!bulk->add_object(hash, slices, count)) {
+            throw std::runtime_error("failed to write object to bulk pack");
         }
+        return hash;
+    }
+
+    fs.ensure_directory(dir);
+    std::string tmp = fs.make_path(dir + "/tmp_obj_XXXXXX");
+    int fd = ::mkstemp(&tmp[0]);
+    if (fd < 0) {
+        throw std::runtime_error("failed to create temporary object file");
+    }
+    ::fchmod(fd, 0444);
+
+    bool ok = false;
+    try {
+        ok = zlib_deflate_to_fd(slices, count, fd);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok || std::rename(tmp.c_str(), fs.make_path(path).c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        throw std::runtime_error("failed to write object file");
     }
 
     return hash;
 }
 
+// 将完整对象内容作为单段切片写入
+static std::string store_raw_object(FileSystem& fs, PackSet& packs, PackWriter* bulk,
+                                    const std::string& objects_dir,
+                                    const std::string& content) {
+    ByteSlice slice = make_slice(content);
+    return store_raw_object(fs, packs, bulk, objects_dir, &slice, 1);
+}
+
 // 将原始数据包装成 blob 对象并压缩写入磁盘，返回对象哈希
 std::string ObjectStore::store_blob(const std::string& data) {
-    std::string content = build_blob_object(data);
-    return store_raw_object(fs_, objects_dir_, content);
+    return store_blob(data.data(), data.size());
+}
+
+// 以 "头部 + 调用方缓冲区" 两段切片写入 blob，不拼接完整对象内容
+std::string ObjectStore::store_blob(const char* data, std::size_t size) {
+    std::string header = build_blob_header(size);
+    ByteSlice slices[2] = {make_slice(header), make_slice(data, size)};
+    return store_raw_object(fs_, *packs_, bulk_.get(), objects_dir_, slices, 2);
 }
 
 // 根据对象哈希读取对象内容，解析头部后将正文写入 out_data
 bool ObjectStore::read_object(const std::string& hash, std::string& out_data) {
+    ReadContext ctx;
+    ObjectView view;
+    if (!read_object(hash, ctx, view)) {
+        return false;
+    }
+    out_data.assign(view.data, view.size);
+    return true;
+}
+
+// 读取并解压对象到上下文缓冲区，解析 "type size\0" 头部后返回正文视图
+bool ObjectStore::read_object(const std::string& hash, ReadContext& ctx,
+                              ObjectView& out) {
     if (hash.size() < 3) {
         return false;
     }
 
-    std::string dir = objects_dir_ + "/" + hash.substr(0, 2);
-    std::string file = hash.substr(2);
-    std::string path = dir + "/" + file;
+    if (object_cache_.capacity() > 0) {
+        const std::shared_ptr<const std::string>* hit = object_cache_.get(hash);
+        if (hit) {
+            ctx.pinned = *hit;
+            ctx.mapping.reset();
+            return parse_full_object(ctx.pinned->data(), ctx.pinned->size(), out);
+        }
+    }
+    ctx.pinned.reset();
+    ctx.mapping.reset();
 
-    std::string compressed;
-    if (!fs_.read_file(path, compressed)) {
+    // 松散对象优先，未命中时回退到包文件；包中的对象直接从映射区域解压并解析 delta
+    loose_path_into(hash, ctx.path);
+    if (read_whole_file(ctx.path, ctx.compressed)) {
+        if (!ctx.inflater.inflate_into(ctx.compressed.data(), ctx.compressed.size(),
+                                       ctx.inflated)) {
+            return false;
+        }
+    } else {
+        const char* data = nullptr;
+        std::size_t size = 0;
+        if (packs_->read_object_view(hash, ctx.inflated, data, size, ctx.mapping)) {
+            // 未压缩的包条目在映射区域中原地解析，既不复制也不进入对象缓存
+            if (data != ctx.inflated.data()) {
+                return parse_full_object(data, size, out);
+            }
+        } else if (!bulk_ || !bulk_->read_object(hash, ctx.inflated)) {
+            return false;
+        }
+    }
+    if (!parse_full_object(ctx.inflated.data(), ctx.inflated.size(), out)) {
+        return false;
+    }
+    // 单个对象超过容量八分之一时不进入缓存，避免大 blob 冲刷热点对象
+    if (object_cache_.capacity() > 0 &&
+        ctx.inflated.size() <= object_cache_.capacity() / 8U) {
+        object_cache_.put(hash, std::make_shared<const std::string>(ctx.inflated),
+                          ctx.inflated.size());
+    }
+    return true;
+}
+
+// 定位全部对象并按磁盘位置排序后分段并行读取；对象不多时直接在当前线程读取
+bool ObjectStore::read_many(const std::vector<std::string>& hashes,
+                            const ReadManyCallback& callback, std::size_t threads) {
+    std::vector<std::string> unique(hashes);
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+    bool failed = false;
+    std::vector<PlannedRead> reads;
+    reads.reserve(unique.size());
+    for (std::size_t i = 0; i < unique.size(); ++i) {
+        const std::string& hash = unique[i];
+        if (hash.size() < 3) {
+            failed = true;
+            continue;
+        }
+        if (object_cache_.capacity() > 0) {
+            const std::shared_ptr<const std::string>* hit = object_cache_.get(hash);
+            ObjectView view;
+            if (hit && parse_full_object((*hit)->data(), (*hit)->size(), view)) {
+                if (!callback(hash, view)) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        std::string pending;
+        ObjectView view;
+        if (bulk_ && bulk_->read_object(hash, pending) &&
+            parse_full_object(pending.data(), pending.size(), view)) {
+            if (!callback(hash, view)) {
+                return false;
+            }
+            continue;
+        }
+        PlannedRead r;
+        r.hash = hash;
+        r.offset = 0;
+        packs_->locate_object(hash, r.pack, r.offset);
+        reads.push_back(r);
+    }
+    // 包内对象在前，按包与偏移排序；松散对象按哈希排序，同一目录下的文件相邻
+    std::sort(reads.begin(), reads.end(), [](const PlannedRead& a, const PlannedRead& b) {
+        if (a.pack.empty() != b.pack.empty()) {
+            return !a.pack.empty();
+        }
+        if (a.pack != b.pack) {
+            return a.pack < b.pack;
+        }
+        return a.pack.empty() ? a.hash < b.hash : a.offset < b.offset;
+    });
+
+    ReadManyState state(reads, callback);
+    std::size_t chunks = (reads.size() + kReadManyChunk - 1U) / kReadManyChunk;
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threads = std::max<std::size_t>(1U, std::min(threads, chunks));
+    // 包集合不是线程安全的：当前线程使用主包集合，其余每个线程使用池中固定的一份
+    while (worker_packs_.size() < threads - 1U) {
+        worker_packs_.push_back(std::unique_ptr<PackSet>(new PackSet(fs_.root())));
+        worker_packs_.back()->set_base_cache_limit(packs_->base_cache_limit());
+    }
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t + 1U < threads; ++t) {
+        workers.push_back(std::thread(read_many_worker, std::cref(objects_path_),
+                                      std::ref(*worker_packs_[t]), std::ref(state)));
+    }
+    read_many_worker(objects_path_, *packs_, state);
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    return !failed && !state.failed && !state.stop;
+}
+
+// 只读取松散对象文件开头的少量压缩数据，解压出头部即返回类型与长度
+bool ObjectStore::read_object_info(const std::string& hash, ReadContext& ctx,
+                                   ObjectType& type, std::size_t& size) {
+    if (hash.size() < 3) {
+        return false;
+    }
+
+    if (object_cache_.capacity() > 0) {
+        const std::shared_ptr<const std::string>* hit = object_cache_.get(hash);
+        if (hit) {
+            std::size_t header_len = 0;
+            return parse_object_header((*hit)->data(), (*hit)->size(), type, size,
+                                       header_len);
+        }
+    }
+
+    const char* compressed = nullptr;
+    std::size_t compressed_size = 0;
+    PackEntryView entry;
+    loose_path_into(hash, ctx.path);
+    int fd = ::open(ctx.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ctx.compressed.resize(kInfoPrefixBytes);
+        ssize_t n = 0;
+        do {
+            n = ::read(fd, &ctx.compressed[0], ctx.compressed.size());
+        } while (n < 0 && errno == EINTR);
+        ::close(fd);
+        if (n <= 0) {
+            return false;
+        }
+        compressed = ctx.compressed.data();
+        compressed_size = static_cast<std::size_t>(n);
+    } else if (packs_->find_entry(hash, entry)) {
+        // MPK2 条目头部已记录类型与长度，完整对象无需解压
+        if (entry.type == PackEntryType::kCommit || entry.type == PackEntryType::kTree ||
+            entry.type == PackEntryType::kBlob) {
+            type = static_cast<ObjectType>(entry.type);
+            size = static_cast<std::size_t>(entry.object_size);
+            return true;
+        }
+        std::size_t header_len = 0;
+        if (entry.type == PackEntryType::kStored) {
+            return parse_object_header(entry.data, entry.size, type, size, header_len);
+        }
+        if (entry.type != PackEntryType::kLegacy) {
+            return packs_->read_object(hash, ctx.inflated) &&
+                   parse_object_header(ctx.inflated.data(), ctx.inflated.size(), type, size,
+                                       header_len);
+        }
+        // 只解压头部，包内数据长度对前缀解压没有影响
+        compressed = entry.data;
+        compressed_size = std::min(entry.size, kInfoPrefixBytes);
+    } else if (bulk_ && bulk_->read_object(hash, ctx.inflated)) {
+        std::size_t header_len = 0;
+        return parse_object_header(ctx.inflated.data(), ctx.inflated.size(), type, size,
+                                   header_len);
+    } else {
+        return false;
+    }
+
+    char header[64];
+    std::size_t produced = 0;
+    if (!zlib_inflate_prefix(compressed, compressed_size, header, sizeof(header),
+                             produced)) {
+        return false;
+    }
+    std::size_t header_len = 0;
+    if (parse_object_header(header, produced, type, size, header_len)) {
+        return true;
+    }
+    // MPK1 包内的 delta 条目没有目标对象的头部，只能重建完整对象
+    if (fd < 0 && produced >= 6 && std::memcmp(header, "delta ", 6) == 0 &&
+        packs_->read_object(hash, ctx.inflated)) {
+        return parse_object_header(ctx.inflated.data(), ctx.inflated.size(), type, size,
+                                   header_len);
+    }
+    return false;
+}
+
+// 拼接松散对象文件的完整路径 "<root>/objects/aa/bbbb..."
+std::string ObjectStore::loose_path(const std::string& hash) const {
+    std::string path;
+    loose_path_into(hash, path);
+    return path;
+}
+
+// 在调用方的缓冲区中拼接松散对象路径，复用其已有容量
+void ObjectStore::loose_path_into(const std::string& hash, std::string& out) const {
+    out.assign(objects_path_);
+    out.push_back('/');
+    out.append(hash, 0, 2);
+    out.push_back('/');
+    out.append(hash, 2, std::string::npos);
+}
+
+// 调整对象缓存容量，容量为 0 时清空缓存
+void ObjectStore::set_cache_limit(std::size_t bytes) {
+    object_cache_.set_capacity(bytes);
+    if (bytes == 0) {
+        object_cache_.clear();
+    }
+}
+
+void ObjectStore::set_delta_base_cache_limit(std::size_t bytes) {
+    packs_->set_base_cache_limit(bytes);
+    for (std::size_t i = 0; i < worker_packs_.size(); ++i) {
+        worker_packs_[i]->set_base_cache_limit(bytes);
+    }
+}
+
+std::uint64_t ObjectStore::delta_base_cache_hits() const {
+    return packs_->base_cache_hits();
+}
+
+std::uint64_t ObjectStore::delta_base_cache_misses() const {
+    return packs_->base_cache_misses();
+}
+
+// 依次检查松散对象文件与包文件
+bool ObjectStore::has_object(const std::string& hash) {
+    if (hash.size() < 3) {
         return false;
     }
+    struct stat st;
+    return ::stat(loose_path(hash).c_str(), &st) == 0 || packs_->contains(hash) ||
+           (bulk_ && bulk_->contains(hash));
+}
 
-    std::string content = zlib_decompress(compressed);
-    std::size_t pos = content.find('\0');
-    if (pos == std::string::npos) {
+// 在 objects/pack 下创建临时包，丢弃之前未结束的批量写入
+bool ObjectStore::begin_bulk_checkin() {
+    bulk_.reset(new PackWriter);
+    if (!bulk_->begin(fs_)) {
+        bulk_.reset();
         return false;
     }
+    return true;
+}
+
+// 落盘并以整包校验和命名新包；空包直接删除
+bool ObjectStore::end_bulk_checkin() {
+    if (!bulk_) {
+        return false;
+    }
+    std::unique_ptr<PackWriter> writer(std::move(bulk_));
+    if (writer->object_count() == 0) {
+        writer->abort();
+        return true;
+    }
+    std::string path;
+    return writer->finish(path);
+}
 
-    out_data = content.substr(pos + 1);
+// 缩写至少需要的十六进制位数
+static const std::size_t kMinAbbrevLength = 4U;
+
+// 先在缩写对应的扇出目录中匹配松散对象，再到包索引中二分查找
+bool ObjectStore::find_objects_by_prefix(const std::string& prefix, std::size_t limit,
+                                         std::vector<std::string>& matches) {
+    matches.clear();
+    if (prefix.size() < kMinAbbrevLength || prefix.size() > 40U) {
+        return false;
+    }
+    std::string lower = prefix;
+    for (std::size_t i = 0; i < lower.size(); ++i) {
+        char c = static_cast<char>(std::tolower(static_cast<unsigned char>(lower[i])));
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+        lower[i] = c;
+    }
+
+    std::string rest = lower.substr(2);
+    DIR* dir = ::opendir(fs_.make_path(objects_dir_ + "/" + lower.substr(0, 2)).c_str());
+    if (dir) {
+        std::size_t found = 0;
+        dirent* de;
+        while (found < limit && (de = ::readdir(dir)) != nullptr) {
+            std::string name = de->d_name;
+            if (name.size() == 38U && name.compare(0, rest.size(), rest) == 0) {
+                matches.push_back(lower.substr(0, 2) + name);
+                ++found;
+            }
+        }
+        ::closedir(dir);
+    }
+    packs_->find_prefix(lower, limit, matches);
+    if (bulk_) {
+        bulk_->find_prefix(lower, limit, matches);
+    }
+
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    if (matches.size() > limit) {
+        matches.resize(limit);
+    }
     return true;
 }
 
+// 返回两个十六进制字符串相同的前缀长度
+static std::size_t common_hex_prefix(const std::string& a, const std::string& b) {
+    std::size_t n = std::min(a.size(), b.size());
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        ++i;
+    }
+    return i;
+}
+
+// 求出其他对象与 hash 的最长共同前缀，缩写比它多一位即唯一：松散对象只扫描一次扇出目录，
+// 包内对象只比较索引中的相邻 ID，bulk check-in 中尚未落盘的对象逐个比较
+std::string ObjectStore::abbreviate(const std::string& hash, std::size_t min_length) {
+    std::size_t length = std::max(min_length, kMinAbbrevLength);
+    if (hash.size() != 40U || length >= hash.size()) {
+        return hash.substr(0, length);
+    }
+    std::size_t common = 0;
+    DIR* dir = ::opendir(fs_.make_path(objects_dir_ + "/" + hash.substr(0, 2)).c_str());
+    if (dir) {
+        std::string rest = hash.substr(2);
+        dirent* de;
+        while ((de = ::readdir(dir)) != nullptr) {
+            std::string name = de->d_name;
+            if (name.size() == 38U && name != rest) {
+                common = std::max(common, 2U + common_hex_prefix(name, rest));
+            }
+        }
+        ::closedir(dir);
+    }
+    common = std::max(common, packs_->common_prefix_length(hash));
+    if (bulk_) {
+        std::vector<std::string> pending;
+        bulk_->find_prefix(hash.substr(0, length), static_cast<std::size_t>(-1), pending);
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            if (pending[i] != hash) {
+                common = std::max(common, common_hex_prefix(pending[i], hash));
+            }
+        }
+    }
+    return hash.substr(0, std::min(hash.size(), std::max(length, common + 1U)));
+}
+
 // 将完整的 tree 对象内容压缩写入磁盘，返回对象哈希
 std::string ObjectStore::store_tree(const std::string& content) {
-    return store_raw_object(fs_, objects_dir_, content);
+    return store_raw_object(fs_, *packs_, bulk_.get(), objects_dir_, content);
 }
 
 // 将完整的 commit 对象内容压缩写入磁盘，返回对象哈希
 std::string ObjectStore::store_commit(const std::string& content) {
-    return store_raw_object(fs_, objects_dir_, content);
+    return store_raw_object(fs_, *packs_, bulk_.get(), objects_dir_, content);
 }
 
 }  // namespace minigit
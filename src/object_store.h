@@ -1,12 +1,112 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "filesystem.h"
+#include "lru_cache.h"
+#include "zlib_utils.h"
 
 // 本文件声明对象存储类，用于管理 .minigit/objects 下的 Git 对象
 namespace minigit {
 
+class PackSet;
+class PackWriter;
+
+/**
+ * @brief Git 对象类型。
+ *
+ * 取值与 Git 包文件中的类型编号保持一致，kNone 表示未知或无效类型。
+ */
+enum class ObjectType {
+    kNone = 0,
+    kCommit = 1,
+    kTree = 2,
+    kBlob = 3,
+};
+
+/**
+ * @brief 返回对象类型在对象头部中使用的名称。
+ *
+ * @param type 对象类型。
+ * @return "commit"/"tree"/"blob"，无效类型返回空字符串。
+ */
+const char* object_type_name(ObjectType type);
+
+/**
+ * @brief 根据对象头部中的类型名称解析对象类型。
+ *
+ * @param name 类型名称起始地址。
+ * @param size 类型名称长度。
+ * @return 对应的对象类型，无法识别时返回 ObjectType::kNone。
+ */
+ObjectType parse_object_type(const char* name, std::size_t size);
+
+/**
+ * @brief 解析对象开头的 "type size\\0" 头部。
+ *
+ * 只要求 data 包含完整头部，不要求正文完整，可用于只解压了前缀的场景。
+ *
+ * @param data       对象数据起始地址。
+ * @param size       可用数据长度。
+ * @param type       输出参数，对象类型。
+ * @param body_size  输出参数，头部声明的正文长度。
+ * @param header_len 输出参数，头部长度（含结尾 '\\0'）。
+ * @return 头部完整且合法时返回 true，否则返回 false。
+ */
+bool parse_object_header(const char* data, std::size_t size, ObjectType& type,
+                         std::size_t& body_size, std::size_t& header_len);
+
+/**
+ * @brief 指向已解压对象正文的只读视图。
+ *
+ * data 指向 ReadContext 持有的缓冲区，在同一个上下文被下一次读取复用之前有效；
+ * 对象以未压缩条目存放在包中时 data 直接指向包的映射区域，由上下文持有该包的共享所有权，
+ * 即使包文件随后被 gc 或重打包删除，也同样在上下文被下一次读取复用之前有效。
+ */
+struct ObjectView {
+    /// 对象类型。
+    ObjectType type;
+    /// 正文长度（字节），不含 "type size\0" 头部。
+    std::size_t size;
+    /// 正文起始地址。
+    const char* data;
+};
+
+/**
+ * @brief 可复用的对象读取上下文。
+ *
+ * 持有读取压缩数据与解压结果所需的缓冲区、松散对象路径缓冲区与 zlib 解压器。
+ * 在循环中反复使用同一个上下文时，缓冲区容量与解压器状态都会被复用，
+ * 稳定后每次读取基本不再产生堆分配。
+ * 上下文不是线程安全的，每个线程应使用独立实例。
+ */
+struct ReadContext {
+    /// 压缩数据缓冲区（内部使用）。
+    std::string compressed;
+    /// 解压后的完整对象缓冲区（内部使用），ObjectView 指向其中。
+    std::string inflated;
+    /// 命中对象缓存时持有的缓存条目（内部使用），保证视图在淘汰后仍有效。
+    std::shared_ptr<const std::string> pinned;
+    /// 视图指向包映射区域时持有的包（内部使用），保证包被移出包集合后映射仍有效。
+    std::shared_ptr<const void> mapping;
+    /// 松散对象文件路径缓冲区（内部使用）。
+    std::string path;
+    /// 松散对象使用的解压器（内部使用）。
+    ZlibInflater inflater;
+};
+
+/**
+ * @brief 批量读取时接收每个对象的回调。
+ *
+ * view 只在回调期间有效；返回 false 时停止投递剩余对象。
+ */
+typedef std::function<bool(const std::string& hash, const ObjectView& view)> ReadManyCallback;
+
 /**
  * @brief Git 对象存储抽象。
  *
@@ -24,6 +124,11 @@ public:
      */
     explicit ObjectStore(const std::string& root);
 
+    ~ObjectStore();
+
+    ObjectStore(const ObjectStore&) = delete;
+    ObjectStore& operator=(const ObjectStore&) = delete;
+
     /**
      * @brief 将原始数据存储为 blob 对象。
      *
@@ -34,6 +139,18 @@ public:
      */
     std::string store_blob(const std::string& data);
 
+    /**
+     * @brief 将调用方缓冲区中的数据存储为 blob 对象。
+     *
+     * 对象头部与 data 作为两段切片依次计算哈希并流式压缩写入文件，
+     * 全程不复制 data，峰值内存接近输入本身大小。
+     *
+     * @param data 原始 blob 数据起始地址。
+     * @param size 数据长度（字节）。
+     * @return 对象内容的 SHA-1 哈希（40 位十六进制字符串）。
+     */
+    std::string store_blob(const char* data, std::size_t size);
+
     /**
      * @brief 根据对象哈希读取对象内容。
      *
@@ -45,6 +162,54 @@ public:
      */
     bool read_object(const std::string& hash, std::string& out_data);
 
+    /**
+     * @brief 根据对象哈希读取带类型信息的对象视图。
+     *
+     * 压缩数据与解压结果均存放在 ctx 的缓冲区中，out 直接指向解压结果中的
+     * 正文部分，不会产生额外的正文副本。会校验头部中声明的长度与实际长度一致。
+     *
+     * @param hash 对象的 SHA-1 哈希（40 位十六进制字符串）。
+     * @param ctx  读取上下文，out 的有效期与其下一次复用之间的区间一致。
+     * @param out  输出参数，用于接收对象类型、长度与正文视图。
+     * @return 读取成功返回 true，对象不存在或格式错误返回 false。
+     */
+    bool read_object(const std::string& hash, ReadContext& ctx, ObjectView& out);
+
+    /**
+     * @brief 按磁盘位置顺序批量读取对象，读完一个就通过回调投递一个。
+     *
+     * 先确定每个对象位于哪个包的哪个偏移或是松散对象，再按 "包 + 偏移"、
+     * 松散对象按所在目录排序，切分成连续的小段交给 threads 个工作线程按序领取；
+     * 每段开始前对包内对应范围发出预读提示，随后在各线程中解压并解析 delta。
+     * 相比逐个随机调用 read_object，冷缓存下的磁盘寻道大幅减少。
+     * 当前线程与各工作线程的包集合由对象存储持有并在多次调用间复用，
+     * 已映射的包与解析出的 delta 基准不会在每次调用时重建。
+     * 重复的哈希只读取一次；回调由内部互斥锁串行化，调用方无需加锁，投递顺序不确定。
+     * 命中对象缓存的对象直接投递，批量读取的结果不写入对象缓存。
+     *
+     * @param hashes   要读取的对象哈希列表。
+     * @param callback 接收对象的回调，返回 false 时提前结束。
+     * @param threads  工作线程数，0 表示使用全部 CPU 核心；对象较少时在当前线程读取。
+     * @return 全部对象都读取成功并且回调没有要求停止时返回 true，否则返回 false。
+     */
+    bool read_many(const std::vector<std::string>& hashes, const ReadManyCallback& callback,
+                   std::size_t threads = 0);
+
+    /**
+     * @brief 只读取对象的类型与正文长度。
+     *
+     * 仅读取并解压对象开头的少量数据得到头部，不解压正文，
+     * 适合批量查询对象元信息（例如 cat-file --batch-check）。
+     *
+     * @param hash 对象的 SHA-1 哈希（40 位十六进制字符串）。
+     * @param ctx  读取上下文，用于复用读缓冲区。
+     * @param type 输出参数，对象类型。
+     * @param size 输出参数，正文长度（字节）。
+     * @return 对象存在且头部合法时返回 true，否则返回 false。
+     */
+    bool read_object_info(const std::string& hash, ReadContext& ctx,
+                          ObjectType& type, std::size_t& size);
+
     /**
      * @brief 将完整的 tree 对象内容写入存储。
      *
@@ -66,9 +231,106 @@ public:
      */
     std::string store_commit(const std::string& content);
 
+    /**
+     * @brief 开始批量写入：此后新写入的对象不再生成松散文件，而是流式追加到同一个新包中。
+     *
+     * 适合一次写入大量对象（例如 add --bulk 或 write-tree --bulk），省去为每个对象
+     * 创建目录、临时文件与改名的系统调用，也不会留下需要立即重打包的松散对象。
+     * 批量写入期间新对象仍可正常读取与查询。之前未结束的批量写入会被丢弃。
+     *
+     * @return 成功创建临时包返回 true，否则返回 false。
+     */
+    bool begin_bulk_checkin();
+
+    /**
+     * @brief 结束批量写入，把临时包落盘为 objects/pack 下的包文件与 .idx 索引。
+     *
+     * 包与索引只在这里同步到磁盘一次；没有写入任何对象时直接丢弃临时包。
+     * 调用方应在写入引用这些对象的 index 或 ref 之前调用。
+     *
+     * @return 成功返回 true；不在批量写入中或落盘失败时返回 false。
+     */
+    bool end_bulk_checkin();
+
+    /**
+     * @brief 设置已解压对象缓存的容量。
+     *
+     * 缓存按对象解压后的字节数计量，默认容量为 0（禁用）。
+     * 长驻进程（例如 daemon）开启后，重复读取同一对象无需再访问磁盘与解压。
+     * 对象内容不可变，因此缓存无需失效处理。
+     *
+     * @param bytes 缓存容量（字节），0 表示禁用并清空缓存。
+     */
+    void set_cache_limit(std::size_t bytes);
+
+    /**
+     * @brief 设置包内 delta 基准缓存的容量。
+     *
+     * 解析 delta 链时重建出的基准对象按字节数缓存，同一条链上的后续读取
+     * 不必从完整对象重新开始。默认 32MB，0 表示禁用。
+     *
+     * @param bytes 缓存容量（字节）。
+     */
+    void set_delta_base_cache_limit(std::size_t bytes);
+
+    /**
+     * @brief 返回 delta 基准缓存的累计命中次数。
+     */
+    std::uint64_t delta_base_cache_hits() const;
+
+    /**
+     * @brief 返回 delta 基准缓存的累计未命中次数。
+     */
+    std::uint64_t delta_base_cache_misses() const;
+
+    /**
+     * @brief 判断对象是否存在于松散对象或任一包文件中。
+     *
+     * @param hash 对象的 SHA-1 哈希（40 位十六进制字符串）。
+     * @return 存在返回 true，否则返回 false。
+     */
+    bool has_object(const std::string& hash);
+
+    /**
+     * @brief 查找以给定缩写开头的对象，用于把短哈希解析为完整哈希。
+     *
+     * 松散对象只读取缩写前两位对应的扇出目录，包内对象在 .idx 与多包索引中
+     * 二分查找，不扫描整个对象库；bulk check-in 中尚未落盘的对象也参与匹配。
+     * 调用方据匹配数判断缩写是否唯一。
+     *
+     * @param prefix  十六进制缩写，长度 4 到 40，大小写均可。
+     * @param limit   最多返回的匹配数，传 2 即足以判断是否有歧义。
+     * @param matches 输出参数，去重后按字典序排列的完整哈希。
+     * @return 缩写格式合法返回 true（即使没有匹配），否则返回 false。
+     */
+    bool find_objects_by_prefix(const std::string& prefix, std::size_t limit,
+                                std::vector<std::string>& matches);
+
+    /**
+     * @brief 返回对象在当前对象库中唯一的最短缩写，长度不少于 min_length。
+     *
+     * 求出其他对象与该哈希的最长共同前缀：松散对象只扫描一次对应的扇出目录，
+     * 包内对象只比较索引中相邻的 ID，bulk check-in 中尚未落盘的对象同样参与比较。
+     *
+     * @param hash       对象的完整哈希。
+     * @param min_length 缩写的最小长度，不小于 4。
+     * @return 唯一的缩写；无法判断时返回前 min_length 位。
+     */
+    std::string abbreviate(const std::string& hash, std::size_t min_length = 7U);
+
 private:
+    std::string loose_path(const std::string& hash) const;
+    void loose_path_into(const std::string& hash, std::string& out) const;
+
     FileSystem fs_;
+    std::unique_ptr<PackSet> packs_;
+    /// read_many 额外工作线程各自使用的包集合，按需增加，跨调用复用。
+    std::vector<std::unique_ptr<PackSet> > worker_packs_;
+    std::unique_ptr<PackWriter> bulk_;
     std::string objects_dir_;
+    /// objects 目录的完整路径，拼接松散对象路径时复用。
+    std::string objects_path_;
+    LruCache<std::string, std::shared_ptr<const std::string> > object_cache_;
 };
 
 }  // namespace minigit
@@ -1,12 +1,44 @@
 ﻿#include "pack.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
+#include <zlib.h>
+
+#include "delta.h"
+#include "hash.h"
+#include "object_store.h"
+#include "commit.h"
+#include "tree.h"
+#include "zlib_utils.h"
+
 namespace minigit {
 
+// 单个包内解析 delta 链时允许的最大链长，防止损坏的包形成环
+static const std::size_t kMaxPackDeltaDepth = 4096;
+
 static void write_u32_be(std::string& out, std::uint32_t v) {
     out.push_back(static_cast<char>((v >> 24) & 0xff));
     out.push_back(static_cast<char>((v >> 16) & 0xff));
@@ -30,8 +62,104 @@ static bool read_u32_be(const std::string& data, std::size_t& offset, std::uint3
     return true;
 }
 
-static void scan_objects_dir(FileSystem& fs, const std::string& objects_dir,
-                             std::vector<PackedEntry>& out_entries) {
+// LEB128 变长整数：每字节 7 位，低位在前，最高位表示后续还有字节
+static void write_varint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static bool read_varint(const unsigned char*& p, const unsigned char* end, std::uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char c = *p++;
+        v |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// MPK2 条目头部：首字节第 4~6 位为类型、低 4 位为长度最低 4 位，其余长度每字节 7 位
+static void write_entry_header(std::string& out, PackEntryType type, std::uint64_t size) {
+    unsigned char c = static_cast<unsigned char>((static_cast<unsigned>(type) << 4) | (size & 0x0f));
+    size >>= 4;
+    while (size != 0) {
+        out.push_back(static_cast<char>(c | 0x80));
+        c = static_cast<unsigned char>(size & 0x7f);
+        size >>= 7;
+    }
+    out.push_back(static_cast<char>(c));
+}
+
+static bool read_entry_header(const unsigned char*& p, const unsigned char* end, int& type,
+                              std::uint64_t& size) {
+    if (p >= end) {
+        return false;
+    }
+    unsigned char c = *p++;
+    type = (c >> 4) & 0x07;
+    size = c & 0x0f;
+    for (unsigned shift = 4; c & 0x80; shift += 7) {
+        if (p >= end || shift >= 64) {
+            return false;
+        }
+        c = *p++;
+        size |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+    }
+    return true;
+}
+
+// 与 Git 相同的偏移距离编码：高位在前，每个后续字节隐含加 1，使编码没有冗余
+static void write_ofs_distance(std::string& out, std::uint64_t distance) {
+    unsigned char buf[10];
+    std::size_t pos = sizeof(buf) - 1;
+    buf[pos] = static_cast<unsigned char>(distance & 0x7f);
+    while (distance >>= 7) {
+        buf[--pos] = static_cast<unsigned char>(0x80 | (--distance & 0x7f));
+    }
+    out.append(reinterpret_cast<const char*>(buf + pos), sizeof(buf) - pos);
+}
+
+static bool read_ofs_distance(const unsigned char*& p, const unsigned char* end,
+                              std::uint64_t& distance) {
+    if (p >= end) {
+        return false;
+    }
+    unsigned char c = *p++;
+    distance = c & 0x7f;
+    while (c & 0x80) {
+        if (p >= end || distance >= (static_cast<std::uint64_t>(1) << 56)) {
+            return false;
+        }
+        c = *p++;
+        distance = ((distance + 1) << 7) | (c & 0x7f);
+    }
+    return true;
+}
+
+// 条目在映射区域中的起始地址：头部长度为条目总长减去压缩数据长度
+static const char* entry_start(const PackEntryView& entry) {
+    return entry.data - (entry.next - entry.offset - entry.size);
+}
+
+// 对任意长度的缓冲区累加 CRC32，按 zlib 接口的 uInt 上限分段
+static uLong crc32_large(uLong crc, const char* data, std::size_t size) {
+    while (size > 0) {
+        uInt n = size > (1U << 30) ? (1U << 30) : static_cast<uInt>(size);
+        crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data), n);
+        data += n;
+        size -= n;
+    }
+    return crc;
+}
+
+// 列出 objects/aa/bbbb... 形式的松散对象哈希，只读取目录项
+static void scan_objects_dir(const FileSystem& fs, const std::string& objects_dir,
+                             std::vector<std::string>& out_hashes) {
     std::string root = fs.make_path(objects_dir);
     DIR* d = opendir(root.c_str());
     if (!d) {
@@ -39,105 +167,2081 @@ static void scan_objects_dir(FileSystem& fs, const std::string& objects_dir,
     }
     dirent* de;
     while ((de = readdir(d)) != nullptr) {
-        if (std::string(de->d_name) == "." || std::string(de->d_name) == "..") {
-            continue;
-        }
-        std::string subdir = root + "/" + de->d_name;
-        struct stat st;
-        if (stat(subdir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        std::string prefix = de->d_name;
+        if (prefix.size() != 2) {
             continue;
         }
-        std::string prefix = de->d_name;
+        std::string subdir = root + "/" + prefix;
         DIR* d2 = opendir(subdir.c_str());
         if (!d2) {
             continue;
         }
         dirent* de2;
         while ((de2 = readdir(d2)) != nullptr) {
-            if (std::string(de2->d_name) == "." || std::string(de2->d_name) == "..") {
-                continue;
-            }
             std::string fname = de2->d_name;
-            std::string rel = objects_dir + "/" + prefix + "/" + fname;
-            std::string compressed;
-            if (!fs.read_file(rel, compressed)) {
-                continue;
+            if (fname.size() == 38) {
+                out_hashes.push_back(prefix + fname);
             }
-            PackedEntry e;
-            e.hash = prefix + fname;
-            e.compressed = compressed;
-            out_entries.push_back(e);
         }
         closedir(d2);
     }
     closedir(d);
 }
 
+// 与 Git 相同的路径名哈希：越靠近末尾的字符权重越高，使同名或同扩展名的文件相邻
+static std::uint32_t pack_name_hash(const std::string& name) {
+    std::uint32_t hash = 0;
+    for (std::size_t i = 0; i < name.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (std::isspace(c)) {
+            continue;
+        }
+        hash = (hash >> 2) + (static_cast<std::uint32_t>(c) << 24);
+    }
+    return hash;
+}
+
+namespace {
+
+// 待打包对象的排序信息
+struct PackCandidate {
+    std::string hash;
+    ObjectType type;
+    std::size_t size;
+    std::uint32_t name_hash;
+    /// 写入包中的次序，见 assign_write_ranks。
+    std::size_t rank;
+};
+
+// 第一遍扫描时记录的提交信息，用于计算写入顺序
+struct CommitLink {
+    std::string tree;
+    std::vector<std::string> parents;
+    std::int64_t time;
+};
+
+// 第一遍扫描中每个线程独立收集的信息，扫描结束后合并
+struct ScanTables {
+    /// 对象哈希到其在 tree 条目中文件名哈希的映射。
+    std::unordered_map<std::string, std::uint32_t> names;
+    /// tree 哈希到其条目哈希（按条目顺序，不含子模块）的映射。
+    std::unordered_map<std::string, std::vector<std::string> > tree_children;
+    /// 提交哈希到其 tree、父提交与提交时间的映射。
+    std::unordered_map<std::string, CommitLink> commits;
+};
+
+// 窗口中保留的已解压对象及其块索引
+struct WindowEntry {
+    WindowEntry(const std::string& h, ObjectType t, std::string& content, std::size_t d)
+        : hash(h), type(t), depth(d) {
+        data.swap(content);
+        index.reset(new DeltaIndex(data.data(), data.size()));
+    }
+
+    std::string hash;
+    ObjectType type;
+    std::size_t depth;
+    std::string data;
+    std::unique_ptr<DeltaIndex> index;
+};
+
+// 一个对象在包中的最终形式：delta 指令的压缩数据，或原样搬运的松散对象
+struct PackedResult {
+    std::string hash;
+    /// delta 指令的压缩数据；完整对象在写入时才重新读取松散对象，此处为空。
+    std::string payload;
+    /// delta 的基准哈希，完整对象为空。
+    std::string base;
+    ObjectType type;
+    /// 完整对象为内容字节数，delta 为指令字节数。
+    std::size_t size;
+    /// 是否以未压缩的 kStored 条目写入。
+    bool stored;
+};
+
+}  // namespace
+
+// 读取并解压一个松散对象，compressed 与 inflated 复用调用方缓冲区
+static bool read_loose(const FileSystem& fs, const std::string& hash,
+                       std::string& compressed, std::string& inflated) {
+    return fs.read_file("objects/" + hash.substr(0, 2) + "/" + hash.substr(2), compressed) &&
+           zlib_inflate_into(compressed.data(), compressed.size(), inflated);
+}
+
 bool write_pack_file(FileSystem& fs, const std::string& pack_relative_path) {
-    std::vector<PackedEntry> entries;
-    scan_objects_dir(fs, "objects", entries);
-    if (entries.empty()) {
-        return false;
+    PackStats stats;
+    return write_pack_file(fs, pack_relative_path, PackOptions(), stats);
+}
+
+// 等待条件成立。使用带超时的等待：它在头文件中内联实现，不依赖较新 libstdc++
+// 才导出的 condition_variable::wait 符号，运行时链接到旧版本库时也能工作
+template <typename Predicate>
+static void wait_on(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+                    Predicate ready) {
+    while (!ready()) {
+        cv.wait_for(lock, std::chrono::milliseconds(100));
     }
-    std::string pack;
-    pack.append("MPK1", 4);
-    write_u32_be(pack, static_cast<std::uint32_t>(entries.size()));
-    for (const auto& e : entries) {
-        if (e.hash.size() != 40) {
+}
+
+// 取 committer 字段中邮箱之后的 Unix 时间戳，无法解析时为 0
+static std::int64_t committer_time(const std::string& committer) {
+    std::size_t gt = committer.rfind('>');
+    if (gt == std::string::npos) {
+        return 0;
+    }
+    return std::strtoll(committer.c_str() + gt + 1, nullptr, 10);
+}
+
+// 第一遍：读取 [next, hashes.size()) 中由原子计数器分配到的对象，记录类型与长度，
+// 并把 tree 条目的文件名哈希与子对象、提交的 tree 与父提交收集到线程本地的表中
+static void scan_candidates(const FileSystem& fs, const std::vector<std::string>& hashes,
+                            std::atomic<std::size_t>& next,
+                            std::vector<PackCandidate>& candidates, ScanTables& tables) {
+    std::string compressed;
+    std::string inflated;
+    std::vector<TreeEntry> tree_entries;
+    Commit commit;
+    for (std::size_t i = next++; i < hashes.size(); i = next++) {
+        PackCandidate& c = candidates[i];
+        c.hash = hashes[i];
+        c.type = ObjectType::kNone;
+        c.name_hash = 0;
+        ObjectView view;
+        std::size_t header_len = 0;
+        if (!read_loose(fs, hashes[i], compressed, inflated) ||
+            !parse_object_header(inflated.data(), inflated.size(), view.type, view.size,
+                                 header_len)) {
             continue;
         }
-        pack.append(e.hash);
-        write_u32_be(pack, static_cast<std::uint32_t>(e.compressed.size()));
-        pack.append(e.compressed);
+        view.data = inflated.data() + header_len;
+        if (view.type == ObjectType::kTree && parse_tree_object(view, tree_entries)) {
+            std::vector<std::string>& children = tables.tree_children[hashes[i]];
+            for (std::size_t k = 0; k < tree_entries.size(); ++k) {
+                tables.names[tree_entries[k].hash] = pack_name_hash(tree_entries[k].name);
+                if (tree_entries[k].mode != "160000") {
+                    children.push_back(tree_entries[k].hash);
+                }
+            }
+        } else if (view.type == ObjectType::kCommit && parse_commit_object(view, commit)) {
+            CommitLink& link = tables.commits[hashes[i]];
+            link.tree = commit.tree;
+            link.parents.swap(commit.parents);
+            link.time = committer_time(commit.committer);
+        }
+        c.type = view.type;
+        c.size = inflated.size();
     }
-    std::size_t pos = pack_relative_path.find_last_of('/');
-    if (pos != std::string::npos) {
-        std::string dir = pack_relative_path.substr(0, pos);
-        fs.ensure_directory(dir);
+}
+
+// 第二遍：在 [begin, end) 内以滑动窗口为每个对象寻找最小的 delta，结果写入 results 的对应位置
+static void deltify_range(const FileSystem& fs, const std::vector<PackCandidate>& candidates,
+                          std::size_t begin, std::size_t end, const PackOptions& options,
+                          std::vector<PackedResult>& results) {
+    std::string compressed;
+    std::string inflated;
+    std::deque<WindowEntry> window;
+    std::string delta;
+    std::string best;
+    for (std::size_t i = begin; i < end; ++i) {
+        const PackCandidate& c = candidates[i];
+        if (!read_loose(fs, c.hash, compressed, inflated)) {
+            continue;
+        }
+        PackedResult& r = results[i];
+        r.hash = c.hash;
+        r.type = c.type;
+        r.stored = options.uncompressed_metadata &&
+                   (c.type == ObjectType::kCommit || c.type == ObjectType::kTree);
+        if (r.stored) {
+            // 未压缩存放的对象不做 delta，也不作为其他对象的基准
+            continue;
+        }
+        const WindowEntry* base = nullptr;
+        best.clear();
+        for (std::size_t w = window.size(); w-- > 0;) {
+            const WindowEntry& e = window[w];
+            if (e.type != c.type || e.depth >= options.depth) {
+                continue;
+            }
+            // delta 至少要比原对象小一半才值得，且必须比已找到的更小
+            std::size_t max_size = best.empty() ? inflated.size() / 2 : best.size() - 1;
+            std::size_t diff = e.data.size() > inflated.size() ? e.data.size() - inflated.size()
+                                                             : inflated.size() - e.data.size();
+            if (max_size < 64 || diff >= max_size) {
+                continue;
+            }
+            if (create_delta(*e.index, inflated.data(), inflated.size(), max_size, delta)) {
+                best.swap(delta);
+                base = &e;
+            }
+        }
+
+        std::size_t depth = 0;
+        if (base) {
+            r.payload = zlib_compress(best);
+            r.base = base->hash;
+            r.size = best.size();
+            depth = base->depth + 1;
+        } else {
+            std::size_t header_len = 0;
+            ObjectType type = ObjectType::kNone;
+            parse_object_header(inflated.data(), inflated.size(), type, r.size, header_len);
+        }
+        if (options.window > 0) {
+            // 原地构造：块索引指向 data 的缓冲区，元素不能被移动
+            window.emplace_back(c.hash, c.type, inflated, depth);
+            if (window.size() > options.window) {
+                window.pop_front();
+            }
+        }
     }
-    return fs.write_file(pack_relative_path, pack);
 }
 
-bool read_pack_file(FileSystem& fs,
-                    const std::string& pack_relative_path,
-                    std::map<std::string, PackedEntry>& out_entries) {
-    std::string data;
-    if (!fs.read_file(pack_relative_path, data)) {
-        return false;
+// 解析工作线程数，0 表示每个 CPU 核心一个线程
+static std::size_t pack_threads(const PackOptions& options) {
+    if (options.threads != 0) {
+        return options.threads;
     }
-    if (data.size() < 8) {
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+// 为已按 delta 搜索顺序排列的对象计算写入顺序，使常见的读取模式在包内大致顺序进行：
+// 提交按时间由新到旧且子提交先于父提交（log 的读取顺序），随后依次模拟检出这些提交，
+// 按深度优先的条目顺序排列首次遇到的 tree 与 blob；未被遍历到的对象保持原有顺序排在最后
+static void assign_write_ranks(std::vector<PackCandidate>& candidates, const ScanTables& tables) {
+    std::unordered_map<std::string, std::size_t> position;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        position[candidates[i].hash] = i;
+        candidates[i].rank = candidates.size();
+    }
+    std::size_t next_rank = 0;
+
+    std::unordered_map<std::string, std::size_t> children;
+    std::unordered_map<std::string, CommitLink>::const_iterator it;
+    for (it = tables.commits.begin(); it != tables.commits.end(); ++it) {
+        for (std::size_t p = 0; p < it->second.parents.size(); ++p) {
+            if (tables.commits.count(it->second.parents[p]) != 0) {
+                ++children[it->second.parents[p]];
+            }
+        }
+    }
+    std::priority_queue<std::pair<std::int64_t, std::string> > ready;
+    for (it = tables.commits.begin(); it != tables.commits.end(); ++it) {
+        if (children.count(it->first) == 0) {
+            ready.push(std::make_pair(it->second.time, it->first));
+        }
+    }
+    std::vector<const CommitLink*> commit_order;
+    while (!ready.empty()) {
+        std::string hash = ready.top().second;
+        ready.pop();
+        candidates[position[hash]].rank = next_rank++;
+        const CommitLink& link = tables.commits.find(hash)->second;
+        commit_order.push_back(&link);
+        for (std::size_t p = 0; p < link.parents.size(); ++p) {
+            std::unordered_map<std::string, std::size_t>::iterator c =
+                children.find(link.parents[p]);
+            if (c != children.end() && --c->second == 0) {
+                ready.push(std::make_pair(tables.commits.find(c->first)->second.time, c->first));
+            }
+        }
+    }
+
+    std::vector<std::string> stack;
+    for (std::size_t k = 0; k < commit_order.size(); ++k) {
+        stack.push_back(commit_order[k]->tree);
+        while (!stack.empty()) {
+            std::string hash;
+            hash.swap(stack.back());
+            stack.pop_back();
+            std::unordered_map<std::string, std::size_t>::const_iterator pos = position.find(hash);
+            if (pos == position.end() || candidates[pos->second].rank != candidates.size()) {
+                continue;
+            }
+            candidates[pos->second].rank = next_rank++;
+            std::unordered_map<std::string, std::vector<std::string> >::const_iterator tree =
+                tables.tree_children.find(hash);
+            if (tree != tables.tree_children.end()) {
+                stack.insert(stack.end(), tree->second.rbegin(), tree->second.rend());
+            }
+        }
+    }
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        if (candidates[i].rank == candidates.size()) {
+            candidates[i].rank = next_rank++;
+        }
+    }
+}
+
+// 第一遍并行收集对象类型、长度、tree 中的文件名与提交关系，丢弃无法读取的对象后
+// 按类型、名称哈希、长度排序以供 delta 搜索，并计算写入顺序
+static void collect_candidates(const FileSystem& fs, const std::vector<std::string>& hashes,
+                               std::size_t threads, std::vector<PackCandidate>& candidates) {
+    candidates.assign(hashes.size(), PackCandidate());
+    std::vector<ScanTables> tables(threads);
+    {
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.push_back(std::thread(scan_candidates, std::cref(fs), std::cref(hashes),
+                                          std::ref(next), std::ref(candidates),
+                                          std::ref(tables[t])));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+    }
+    for (std::size_t t = 1; t < threads; ++t) {
+        tables[0].names.insert(tables[t].names.begin(), tables[t].names.end());
+        std::unordered_map<std::string, std::vector<std::string> >::iterator tree;
+        for (tree = tables[t].tree_children.begin(); tree != tables[t].tree_children.end();
+             ++tree) {
+            tables[0].tree_children[tree->first].swap(tree->second);
+        }
+        std::unordered_map<std::string, CommitLink>::iterator commit;
+        for (commit = tables[t].commits.begin(); commit != tables[t].commits.end(); ++commit) {
+            CommitLink& link = tables[0].commits[commit->first];
+            link.tree.swap(commit->second.tree);
+            link.parents.swap(commit->second.parents);
+            link.time = commit->second.time;
+        }
+    }
+    const std::unordered_map<std::string, std::uint32_t>& names = tables[0].names;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        if (candidates[i].type == ObjectType::kNone) {
+            continue;
+        }
+        std::unordered_map<std::string, std::uint32_t>::const_iterator it =
+            names.find(candidates[i].hash);
+        if (it != names.end()) {
+            candidates[i].name_hash = it->second;
+        }
+        if (kept != i) {
+            candidates[kept] = candidates[i];
+        }
+        ++kept;
+    }
+    candidates.resize(kept);
+    // 较大的对象排在前面，使 delta 多为删除操作，也让基准通常是较新的完整版本
+    std::sort(candidates.begin(), candidates.end(),
+              [](const PackCandidate& a, const PackCandidate& b) {
+                  if (a.type != b.type) {
+                      return a.type < b.type;
+                  }
+                  if (a.name_hash != b.name_hash) {
+                      return a.name_hash < b.name_hash;
+                  }
+                  if (a.size != b.size) {
+                      return a.size > b.size;
+                  }
+                  return a.hash < b.hash;
+              });
+    assign_write_ranks(candidates, tables[0]);
+}
+
+// 第二遍：把按 delta 搜索顺序排列的对象切分为若干段，工作线程各自在段内做滑动窗口 delta
+// 搜索并压缩，当前线程作为唯一的写入者按写入顺序追加到已开始的 writer。delta 基准总在
+// 同一段内，因此段按其中对象最早的写入顺序分派，写入者等到下一个对象所在的段完成即可
+// 写入它及尚未写入的基准；已分派但写入者尚未用到的段数受限。内存中只保留尚未写入的
+// delta 数据，完整对象在写入时重新读取松散对象的压缩数据
+static bool write_candidates(const FileSystem& fs, const std::vector<PackCandidate>& candidates,
+                             const PackOptions& options, std::size_t threads,
+                             PackWriter& writer, PackStats& stats) {
+    if (candidates.empty()) {
+        return true;
+    }
+    // 每段足够长以保留窗口效果，同时段数多于线程数以均衡负载
+    std::size_t chunk_size = std::max<std::size_t>(
+        256U, (candidates.size() + threads * 4U - 1U) / (threads * 4U));
+    std::size_t chunk_count = (candidates.size() + chunk_size - 1U) / chunk_size;
+    std::size_t max_in_flight = threads * 2U;
+
+    std::unordered_map<std::string, std::size_t> position;
+    std::vector<std::size_t> order(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        position[candidates[i].hash] = i;
+        order[candidates[i].rank] = i;
+    }
+    // dispatch 为段的分派顺序，need 为每段在其中的位置
+    std::vector<std::size_t> dispatch;
+    std::vector<std::size_t> need(chunk_count, chunk_count);
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        std::size_t c = order[k] / chunk_size;
+        if (need[c] == chunk_count) {
+            need[c] = dispatch.size();
+            dispatch.push_back(c);
+        }
+    }
+
+    std::vector<PackedResult> results(candidates.size());
+    std::vector<char> done(chunk_count, 0);
+    std::mutex mu;
+    std::condition_variable cv;
+    std::size_t next_dispatch = 0;
+    std::size_t needed = 0;
+    bool stop = false;
+
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < std::min(threads, chunk_count); ++t) {
+        workers.push_back(std::thread([&]() {
+            while (true) {
+                std::size_t c = 0;
+                {
+                    std::unique_lock<std::mutex> lock(mu);
+                    wait_on(cv, lock, [&]() {
+                        return stop || next_dispatch >= chunk_count ||
+                               next_dispatch < needed + max_in_flight;
+                    });
+                    if (stop || next_dispatch >= chunk_count) {
+                        return;
+                    }
+                    c = dispatch[next_dispatch++];
+                }
+                std::size_t begin = c * chunk_size;
+                std::size_t end = std::min(candidates.size(), begin + chunk_size);
+                deltify_range(fs, candidates, begin, end, options, results);
+                std::lock_guard<std::mutex> lock(mu);
+                done[c] = 1;
+                cv.notify_all();
+            }
+        }));
+    }
+
+    bool ok = true;
+    std::string compressed;
+    std::string inflated;
+    std::vector<std::size_t> chain;
+    for (std::size_t k = 0; ok && k < order.size(); ++k) {
+        std::size_t c = order[k] / chunk_size;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            if (need[c] >= needed) {
+                needed = need[c] + 1U;
+                cv.notify_all();
+            }
+            wait_on(cv, lock, [&]() { return done[c] != 0; });
+        }
+        // 沿 delta 链收集尚未写入的对象，再自底向上写入
+        chain.clear();
+        for (std::size_t i = order[k];;) {
+            const PackedResult& r = results[i];
+            // 松散对象读取失败时结果为空，不能让调用方误以为它已入包
+            if (r.hash.empty()) {
+                ok = false;
+                break;
+            }
+            if (writer.contains(r.hash)) {
+                break;
+            }
+            chain.push_back(i);
+            std::unordered_map<std::string, std::size_t>::const_iterator base =
+                position.find(r.base);
+            if (r.base.empty() || base == position.end()) {
+                break;
+            }
+            i = base->second;
+        }
+        for (std::size_t j = chain.size(); ok && j-- > 0;) {
+            PackedResult& r = results[chain[j]];
+            if (r.stored) {
+                ok = read_loose(fs, r.hash, compressed, inflated) &&
+                     writer.add_stored(r.hash, inflated);
+            } else if (r.base.empty()) {
+                ok = fs.read_file("objects/" + r.hash.substr(0, 2) + "/" + r.hash.substr(2),
+                                  compressed) &&
+                     writer.add_compressed(r.hash, r.type, r.size, compressed.data(),
+                                           compressed.size());
+            } else {
+                ok = writer.add_delta(r.hash, r.base, r.size, r.payload.data(),
+                                      r.payload.size());
+                ++stats.deltas;
+            }
+            ++stats.objects;
+            std::string().swap(r.payload);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stop = !ok;
+        cv.notify_all();
+    }
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    return ok;
+}
+
+bool write_pack_file(FileSystem& fs, const std::string& pack_relative_path,
+                     const PackOptions& options, PackStats& stats) {
+    stats = PackStats();
+    std::vector<std::string> hashes;
+    scan_objects_dir(fs, "objects", hashes);
+    std::size_t threads = pack_threads(options);
+    std::vector<PackCandidate> candidates;
+    collect_candidates(fs, hashes, threads, candidates);
+
+    PackWriter writer;
+    if (candidates.empty() ||
+        !writer.begin(fs, static_cast<std::uint32_t>(candidates.size()))) {
         return false;
     }
-    if (data.compare(0, 4, "MPK1") != 0) {
+    return write_candidates(fs, candidates, options, threads, writer, stats) &&
+           writer.finish_as(pack_relative_path);
+}
+
+namespace {
+
+// 参与几何重打包的已有包
+struct GeometryPack {
+    std::string rel;
+    std::size_t count;
+};
+
+}  // namespace
+
+// 列出 objects/pack 下的包及其对象数量，缺少索引的包先补建索引
+static void list_packs(const FileSystem& fs, std::vector<GeometryPack>& packs) {
+    DIR* d = opendir(fs.make_path("objects/pack").c_str());
+    if (!d) {
+        return;
+    }
+    dirent* de;
+    while ((de = readdir(d)) != nullptr) {
+        std::string name = de->d_name;
+        if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".mpk") != 0) {
+            continue;
+        }
+        GeometryPack pack;
+        pack.rel = "objects/pack/" + name;
+        std::string idx = fs.make_path(pack_sibling_path(pack.rel, ".idx"));
+        PackIndex index;
+        if (!index.open(idx) && !(index_pack_file(fs, pack.rel) && index.open(idx))) {
+            continue;
+        }
+        pack.count = index.count();
+        packs.push_back(pack);
+    }
+    closedir(d);
+}
+
+// 选出需要合并的最小若干个包，packs 按对象数升序排列。
+// 先从最大的包向下找到第一处相邻比例不足 factor 的位置，其下的包都要合并；
+// 再把合并结果（连同 pending 个新对象）与更大的包比较，不足 factor 倍时继续吸收
+static std::size_t geometric_split(const std::vector<GeometryPack>& packs, std::size_t pending,
+                                   std::size_t factor) {
+    std::size_t split = packs.size();
+    while (split > 1 && packs[split - 1].count >= factor * packs[split - 2].count) {
+        --split;
+    }
+    split = split > 1 ? split - 1 : 0;
+    std::size_t total = pending;
+    for (std::size_t i = 0; i < split; ++i) {
+        total += packs[i].count;
+    }
+    while (split < packs.size() && packs[split].count < factor * total) {
+        total += packs[split].count;
+        ++split;
+    }
+    return split;
+}
+
+// delta 的基准不会进入新包时，重建完整对象并重新压缩写入
+static bool add_rebuilt_object(PackSet& existing, const std::string& hash, PackWriter& writer,
+                               std::string& buf) {
+    if (!existing.read_object(hash, buf)) {
         return false;
     }
-    std::size_t offset = 4;
-    std::uint32_t count = 0;
-    if (!read_u32_be(data, offset, count)) {
+    ByteSlice slice = make_slice(buf);
+    return writer.add_object(hash, &slice, 1);
+}
+
+// 得到条目的对象类型：MPK2 完整条目读取头部，同一包中已知类型的基准上的 delta 沿用基准的
+// 类型，其余条目借助 existing 重建完整对象（结果留在 buf 中）后读取头部
+static bool entry_object_type(const PackEntryView& entry, const std::string& hash,
+                              PackSet& existing,
+                              const std::unordered_map<std::uint64_t, ObjectType>& known,
+                              std::string& buf, ObjectType& type) {
+    std::size_t size = 0;
+    std::size_t header_len = 0;
+    switch (entry.type) {
+    case PackEntryType::kCommit:
+    case PackEntryType::kTree:
+    case PackEntryType::kBlob:
+        type = static_cast<ObjectType>(entry.type);
+        return true;
+    case PackEntryType::kStored:
+        return parse_object_header(entry.data, entry.size, type, size, header_len);
+    case PackEntryType::kOfsDelta: {
+        std::unordered_map<std::uint64_t, ObjectType>::const_iterator it =
+            known.find(entry.base_offset);
+        if (it != known.end()) {
+            type = it->second;
+            return true;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return existing.read_object(hash, buf) &&
+           parse_object_header(buf.data(), buf.size(), type, size, header_len);
+}
+
+// 按偏移顺序把包中的条目逐字节复制到 writer，keep 非空时只复制其中的对象。每个条目先用
+// .idx 中的 CRC32 校验，损坏的数据不会被带进新包；delta 的基准总在它之前出现，基准也进入
+// 新包时按偏移引用，否则借助 existing 重建为完整对象。MPK1 条目需解压以区分 delta，转换为 MPK2 条目。
+// 开启 options.uncompressed_metadata 时，提交与 tree 重建后改写为 kStored 条目
+static bool copy_pack_entries(const FileSystem& fs, const std::string& rel, PackSet& existing,
+                              const PackOptions& options, PackWriter& writer, PackStats& stats,
+                              const std::unordered_set<std::string>* keep) {
+    PackReader reader;
+    PackIndex index;
+    if (!reader.open(fs.make_path(rel), PackReader::Access::kSequential) ||
+        !index.open(fs.make_path(pack_sibling_path(rel, ".idx")))) {
         return false;
     }
-    for (std::uint32_t i = 0; i < count; ++i) {
-        if (offset + 40 + 4 > data.size()) {
+    // 借助 .rev 按偏移顺序遍历条目，反向索引不可用时现场排序
+    std::vector<std::uint32_t> order(index.count());
+    PackReverseIndex rev;
+    if (reader.content_id() && rev.open(fs.make_path(pack_sibling_path(rel, ".rev")),
+                                        index.count(), reader.content_id())) {
+        for (std::size_t r = 0; r < order.size(); ++r) {
+            order[r] = rev.index_position(r);
+        }
+    } else {
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&index](std::uint32_t a, std::uint32_t b) {
+            return index.offset_at(a) < index.offset_at(b);
+        });
+    }
+    std::unordered_map<std::uint64_t, std::string> hash_at_offset;
+    std::unordered_map<std::uint64_t, ObjectType> type_at_offset;
+    std::string inflated;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        PackEntryView entry;
+        if (!reader.entry_at(index.offset_at(order[i]), entry)) {
             return false;
         }
-        std::string hash = data.substr(offset, 40);
-        offset += 40;
-        std::uint32_t sz = 0;
-        if (!read_u32_be(data, offset, sz)) {
+        std::string hash = index.hash_at(order[i]);
+        hash_at_offset[entry.offset] = hash;
+        if (writer.contains(hash) || (keep && keep->count(hash) == 0)) {
+            continue;
+        }
+        std::uint32_t crc = reader.entry_crc(entry);
+        if (crc != index.crc_at(order[i])) {
             return false;
         }
-        if (offset + sz > data.size()) {
+        if (options.uncompressed_metadata) {
+            ObjectType type = ObjectType::kNone;
+            if (!entry_object_type(entry, hash, existing, type_at_offset, inflated, type)) {
+                return false;
+            }
+            type_at_offset[entry.offset] = type;
+            if ((type == ObjectType::kCommit || type == ObjectType::kTree) &&
+                entry.type != PackEntryType::kStored) {
+                if (!existing.read_object(hash, inflated) || !writer.add_stored(hash, inflated)) {
+                    return false;
+                }
+                ++stats.objects;
+                continue;
+            }
+        }
+        bool ok = false;
+        bool is_delta = false;
+        if (entry.type == PackEntryType::kLegacy) {
+            if (!reader.inflate(entry, inflated)) {
+                return false;
+            }
+            std::size_t nul = inflated.find('\0');
+            is_delta = inflated.compare(0, 6, "delta ") == 0;
+            if (!is_delta) {
+                ok = writer.add_compressed(hash, entry.data, entry.size);
+            } else if (nul != std::string::npos && inflated.size() >= nul + 41 &&
+                       writer.contains(inflated.substr(nul + 1, 40))) {
+                std::string ops = inflated.substr(nul + 41);
+                std::string compressed = zlib_compress(ops);
+                ok = writer.add_delta(hash, inflated.substr(nul + 1, 40), ops.size(),
+                                      compressed.data(), compressed.size());
+            } else {
+                is_delta = false;
+                ok = add_rebuilt_object(existing, hash, writer, inflated);
+            }
+        } else {
+            std::string base_hash;
+            if (entry.type == PackEntryType::kOfsDelta) {
+                std::unordered_map<std::uint64_t, std::string>::const_iterator it =
+                    hash_at_offset.find(entry.base_offset);
+                if (it == hash_at_offset.end()) {
+                    return false;
+                }
+                base_hash = it->second;
+            } else if (entry.type == PackEntryType::kRefDelta) {
+                base_hash = raw_to_hex(entry.base_id);
+            }
+            is_delta = !base_hash.empty();
+            if (!is_delta || writer.contains(base_hash)) {
+                ok = writer.copy_entry(hash, entry, base_hash, crc);
+                ++stats.reused;
+            } else {
+                is_delta = false;
+                ok = add_rebuilt_object(existing, hash, writer, inflated);
+            }
+        }
+        if (!ok) {
             return false;
         }
-        std::string compressed = data.substr(offset, sz);
-        offset += sz;
-        PackedEntry e;
-        e.hash = hash;
-        e.compressed = compressed;
-        out_entries[hash] = e;
+        ++stats.objects;
+        if (is_delta) {
+            ++stats.deltas;
+        }
     }
     return true;
 }
 
-}  // namespace minigit
+// 删除包文件连同其索引、反向索引与位图
+static void remove_pack(const FileSystem& fs, const std::string& rel) {
+    ::unlink(fs.make_path(rel).c_str());
+    ::unlink(fs.make_path(pack_sibling_path(rel, ".idx")).c_str());
+    ::unlink(fs.make_path(pack_sibling_path(rel, ".bitmap")).c_str());
+    ::unlink(fs.make_path(pack_sibling_path(rel, ".rev")).c_str());
+}
+
+// 把 hashes 中已写入 writer 的对象追加到 out；writer 在 finish 后会清空条目，须在此之前调用
+static void collect_written(const std::vector<std::string>& hashes, const PackWriter& writer,
+                            std::vector<std::string>& out) {
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        if (writer.contains(hashes[i])) {
+            out.push_back(hashes[i]);
+        }
+    }
+}
+
+// 删除已经进入包中的松散对象，随后尝试删除变空的扇出目录
+static void prune_packed_loose(const FileSystem& fs, const std::vector<std::string>& hashes) {
+    std::set<std::string> dirs;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::string dir = "objects/" + hashes[i].substr(0, 2);
+        ::unlink(fs.make_path(dir + "/" + hashes[i].substr(2)).c_str());
+        dirs.insert(dir);
+    }
+    for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+        ::rmdir(fs.make_path(*it).c_str());
+    }
+}
+
+void list_loose_objects(const FileSystem& fs, std::vector<std::string>& out) {
+    out.clear();
+    scan_objects_dir(fs, "objects", out);
+}
+
+void list_pack_files(const FileSystem& fs, std::vector<std::string>& out) {
+    std::vector<GeometryPack> packs;
+    list_packs(fs, packs);
+    out.clear();
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        out.push_back(packs[i].rel);
+    }
+    std::sort(out.begin(), out.end());
+}
+
+// 借助反向索引按偏移顺序遍历对象，相邻两个偏移之差即为条目的磁盘占用；
+// 缺少或过期的反向索引会先重新生成
+bool pack_object_sizes(const FileSystem& fs, const std::string& pack_relative_path,
+                       std::vector<PackObjectSize>& out) {
+    out.clear();
+    PackIndex index;
+    PackReader reader;
+    if (!index.open(fs.make_path(pack_sibling_path(pack_relative_path, ".idx"))) ||
+        !reader.open(fs.make_path(pack_relative_path)) || !reader.content_id()) {
+        return false;
+    }
+    std::string rev_path = fs.make_path(pack_sibling_path(pack_relative_path, ".rev"));
+    PackReverseIndex rev;
+    if (!rev.open(rev_path, index.count(), reader.content_id()) &&
+        !(write_pack_reverse_index(rev_path, index, reader.content_id()) &&
+          rev.open(rev_path, index.count(), reader.content_id()))) {
+        return false;
+    }
+    // MPK1 没有末尾校验和，最后一个条目一直延伸到文件末尾
+    std::uint64_t end = reader.size() - (reader.version() == 1 ? 0U : 20U);
+    out.resize(rev.count());
+    for (std::size_t r = rev.count(); r-- > 0;) {
+        std::uint32_t pos = rev.index_position(r);
+        std::uint64_t offset = index.offset_at(pos);
+        if (offset > end) {
+            out.clear();
+            return false;
+        }
+        out[r].hash = index.hash_at(pos);
+        out[r].offset = offset;
+        out[r].disk_size = end - offset;
+        end = offset;
+    }
+    return true;
+}
 
+// 列出全部包文件名后增量更新多包索引
+bool update_multi_pack_index(const FileSystem& fs) {
+    std::vector<GeometryPack> packs;
+    list_packs(fs, packs);
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        names.push_back(packs[i].rel.substr(std::strlen("objects/pack/")));
+    }
+    return write_multi_pack_index(fs.make_path("objects/pack"), names);
+}
+
+// 只打包尚未入包的松散对象，并与违反几何级数的最小若干个包合并为一个新包；
+// 新包落盘后再删除被合并的旧包与已入包的松散对象
+bool repack_incremental(FileSystem& fs, const PackOptions& options, PackStats& stats,
+                        std::string& out_relative_path) {
+    stats = PackStats();
+    out_relative_path.clear();
+    std::vector<GeometryPack> packs;
+    list_packs(fs, packs);
+    std::sort(packs.begin(), packs.end(), [](const GeometryPack& a, const GeometryPack& b) {
+        return a.count != b.count ? a.count < b.count : a.rel < b.rel;
+    });
+
+    std::vector<std::string> loose;
+    scan_objects_dir(fs, "objects", loose);
+    std::vector<std::string> fresh;
+    std::vector<std::string> packed;
+    PackSet existing(fs.root());
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        (existing.contains(loose[i]) ? packed : fresh).push_back(loose[i]);
+    }
+
+    std::size_t threads = pack_threads(options);
+    std::vector<PackCandidate> candidates;
+    collect_candidates(fs, fresh, threads, candidates);
+    std::size_t factor = std::max<std::size_t>(2U, options.geometric_factor);
+    std::size_t split = options.all ? packs.size()
+                                    : geometric_split(packs, candidates.size(), factor);
+    if (candidates.empty() && split < 2) {
+        // 没有新对象且包集合已满足几何级数，只清理已入包的松散对象
+        prune_packed_loose(fs, packed);
+        return true;
+    }
+
+    std::size_t expected = candidates.size();
+    for (std::size_t i = 0; i < split; ++i) {
+        expected += packs[i].count;
+    }
+    PackWriter writer;
+    if (!writer.begin(fs, static_cast<std::uint32_t>(std::min<std::size_t>(expected, 0xffffffffU)))) {
+        return false;
+    }
+    for (std::size_t i = 0; i < split; ++i) {
+        if (!copy_pack_entries(fs, packs[i].rel, existing, options, writer, stats, nullptr)) {
+            return false;
+        }
+    }
+    if (!write_candidates(fs, candidates, options, threads, writer, stats)) {
+        return false;
+    }
+    // 未合并的旧包仍保留 packed 中的对象，新对象只删除确实写入新包的那些
+    collect_written(fresh, writer, packed);
+    if (!writer.finish(out_relative_path)) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < split; ++i) {
+        // 同名即内容完全相同的同一个包，保留原文件
+        if (packs[i].rel != out_relative_path) {
+            remove_pack(fs, packs[i].rel);
+            ++stats.merged_packs;
+        }
+    }
+    prune_packed_loose(fs, packed);
+    return update_multi_pack_index(fs);
+}
+
+// 已有包中属于 keep 的条目逐字节复制，松散对象中属于 keep 且尚未入包的重新做 delta 搜索，
+// 新包落盘后删除全部旧包与已入包的松散对象
+bool repack_objects(FileSystem& fs, const PackOptions& options,
+                    const std::unordered_set<std::string>& keep, PackStats& stats,
+                    std::string& out_relative_path) {
+    stats = PackStats();
+    out_relative_path.clear();
+    std::vector<GeometryPack> packs;
+    list_packs(fs, packs);
+    std::sort(packs.begin(), packs.end(), [](const GeometryPack& a, const GeometryPack& b) {
+        return a.count != b.count ? a.count > b.count : a.rel < b.rel;
+    });
+
+    std::vector<std::string> loose;
+    scan_objects_dir(fs, "objects", loose);
+    std::vector<std::string> fresh;
+    std::vector<std::string> packed;
+    PackSet existing(fs.root());
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        if (keep.count(loose[i]) != 0) {
+            (existing.contains(loose[i]) ? packed : fresh).push_back(loose[i]);
+        }
+    }
+    std::size_t threads = pack_threads(options);
+    std::vector<PackCandidate> candidates;
+    collect_candidates(fs, fresh, threads, candidates);
+
+    PackWriter writer;
+    if (!writer.begin(fs, static_cast<std::uint32_t>(std::min<std::size_t>(keep.size(),
+                                                                           0xffffffffU)))) {
+        return false;
+    }
+    // 较大的包先复制，使其中的 delta 尽量保持原样
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        if (!copy_pack_entries(fs, packs[i].rel, existing, options, writer, stats, &keep)) {
+            return false;
+        }
+    }
+    if (!write_candidates(fs, candidates, options, threads, writer, stats)) {
+        return false;
+    }
+    // 旧包随后全部删除，只有确实写入新包的松散对象可以删除
+    std::vector<std::string> written;
+    collect_written(packed, writer, written);
+    collect_written(fresh, writer, written);
+    if (writer.object_count() == 0) {
+        writer.abort();
+    } else if (!writer.finish(out_relative_path)) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < packs.size(); ++i) {
+        // 同名即内容完全相同的同一个包，保留原文件
+        if (packs[i].rel != out_relative_path) {
+            remove_pack(fs, packs[i].rel);
+            ++stats.merged_packs;
+        }
+    }
+    prune_packed_loose(fs, written);
+    return update_multi_pack_index(fs);
+}
+
+// 在单个包内重建 offset 处条目对应的完整对象：沿 delta 链找到完整对象后自底向上应用 delta；
+// kRefDelta 与 MPK1 delta 的基准由 find_base 按哈希给出偏移
+static bool inflate_pack_object(
+    const PackReader& reader, std::uint64_t offset,
+    const std::function<bool(const std::string&, std::uint64_t&)>& find_base,
+    std::string& out) {
+    std::vector<std::string> deltas;
+    std::string buf;
+    while (true) {
+        PackEntryView entry;
+        if (deltas.size() > kMaxPackDeltaDepth || !reader.entry_at(offset, entry) ||
+            !reader.inflate(entry, buf)) {
+            return false;
+        }
+        std::string base_hash;
+        if (entry.type == PackEntryType::kOfsDelta) {
+            deltas.push_back(std::string());
+            deltas.back().swap(buf);
+            offset = entry.base_offset;
+            continue;
+        }
+        if (entry.type == PackEntryType::kRefDelta) {
+            base_hash = raw_to_hex(entry.base_id);
+            deltas.push_back(std::string());
+            deltas.back().swap(buf);
+        } else if (entry.type == PackEntryType::kLegacy && buf.compare(0, 6, "delta ") == 0) {
+            std::size_t nul = buf.find('\0');
+            if (nul == std::string::npos || buf.size() < nul + 41) {
+                return false;
+            }
+            base_hash.assign(buf, nul + 1, 40);
+            deltas.push_back(buf.substr(nul + 41));
+        } else {
+            out.swap(buf);
+            break;
+        }
+        if (!find_base(base_hash, offset)) {
+            return false;
+        }
+    }
+    for (std::size_t i = deltas.size(); i-- > 0;) {
+        if (!apply_delta(out.data(), out.size(), deltas[i].data(), deltas[i].size(), buf)) {
+            return false;
+        }
+        out.swap(buf);
+    }
+    return true;
+}
+
+// MPK2 条目不含 ID：按 .idx 逐个取出条目，完整对象直接复制压缩数据，delta 重建后与
+// kStored 条目一起重新压缩
+static bool read_pack_file_v2(FileSystem& fs, const std::string& pack_relative_path,
+                              const PackReader& reader,
+                              std::map<std::string, PackedEntry>& out_entries) {
+    std::string idx_path = fs.make_path(pack_sibling_path(pack_relative_path, ".idx"));
+    PackIndex index;
+    if (!index.open(idx_path) &&
+        !(index_pack_file(fs, pack_relative_path) && index.open(idx_path))) {
+        return false;
+    }
+    std::function<bool(const std::string&, std::uint64_t&)> find_base =
+        [&index](const std::string& hash, std::uint64_t& offset) {
+            std::uint32_t crc = 0;
+            return index.find(hash, offset, crc);
+        };
+    std::string content;
+    for (std::size_t i = 0; i < index.count(); ++i) {
+        PackEntryView entry;
+        if (!reader.entry_at(index.offset_at(i), entry)) {
+            return false;
+        }
+        PackedEntry e;
+        e.hash = index.hash_at(i);
+        if (entry.type == PackEntryType::kOfsDelta || entry.type == PackEntryType::kRefDelta) {
+            if (!inflate_pack_object(reader, entry.offset, find_base, content)) {
+                return false;
+            }
+            e.compressed = zlib_compress(content);
+        } else if (entry.type == PackEntryType::kStored) {
+            e.compressed = zlib_compress(std::string(entry.data, entry.size));
+        } else {
+            e.compressed.assign(entry.data, entry.size);
+        }
+        out_entries[e.hash] = e;
+    }
+    return true;
+}
+
+bool read_pack_file(FileSystem& fs,
+                    const std::string& pack_relative_path,
+                    std::map<std::string, PackedEntry>& out_entries) {
+    {
+        PackReader reader;
+        if (reader.open(fs.make_path(pack_relative_path)) && reader.version() == 2) {
+            return read_pack_file_v2(fs, pack_relative_path, reader, out_entries);
+        }
+    }
+    std::string data;
+    if (!fs.read_file(pack_relative_path, data)) {
+        return false;
+    }
+    if (data.size() < 8) {
+        return false;
+    }
+    if (data.compare(0, 4, "MPK1") != 0) {
+        return false;
+    }
+    std::size_t offset = 4;
+    std::uint32_t count = 0;
+    if (!read_u32_be(data, offset, count)) {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (offset + 40 + 4 > data.size()) {
+            return false;
+        }
+        std::string hash = data.substr(offset, 40);
+        offset += 40;
+        std::uint32_t sz = 0;
+        if (!read_u32_be(data, offset, sz)) {
+            return false;
+        }
+        if (offset + sz > data.size()) {
+            return false;
+        }
+        std::string compressed = data.substr(offset, sz);
+        offset += sz;
+        PackedEntry e;
+        e.hash = hash;
+        e.compressed = compressed;
+        out_entries[hash] = e;
+    }
+    return true;
+}
+
+// 将缓冲区完整写入文件描述符，处理短写与 EINTR
+static bool write_all_fd(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// 在指定偏移处完整读取 size 字节
+static bool pread_all(int fd, char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+PackWriter::PackWriter() : fs_(nullptr), fd_(-1), offset_(0), header_count_(0) {}
+
+PackWriter::~PackWriter() {
+    abort();
+}
+
+// 创建临时包文件并写入 "MPK2" 与预期的对象数量
+bool PackWriter::begin(const FileSystem& fs, std::uint32_t expected_count) {
+    abort();
+    fs_ = &fs;
+    if (!fs.ensure_directory("objects/pack")) {
+        return false;
+    }
+    tmp_path_ = fs.make_path("objects/pack/tmp_pack_XXXXXX");
+    fd_ = ::mkstemp(&tmp_path_[0]);
+    if (fd_ < 0) {
+        tmp_path_.clear();
+        return false;
+    }
+    ::fchmod(fd_, 0444);
+    sha_ = Sha1();
+    header_count_ = expected_count;
+    std::string header("MPK2", 4);
+    write_u32_be(header, expected_count);
+    if (!append(header.data(), header.size())) {
+        abort();
+        return false;
+    }
+    return true;
+}
+
+// 写入临时文件并同步累加整包校验和
+bool PackWriter::append(const char* data, std::size_t size) {
+    if (!write_all_fd(fd_, data, size)) {
+        return false;
+    }
+    sha_.update(data, size);
+    offset_ += size;
+    return true;
+}
+
+// 压缩对象后追加到临时文件
+bool PackWriter::add_object(const std::string& hash, const ByteSlice* slices,
+                            std::size_t count) {
+    if (fd_ < 0 || hash.size() != 40) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    std::string compressed = zlib_compress(slices, count);
+    return add_compressed(hash, compressed.data(), compressed.size());
+}
+
+// 只解压松散对象头部得到类型与长度，压缩数据本身原样写入
+bool PackWriter::add_compressed(const std::string& hash, const char* data,
+                                std::size_t size) {
+    if (fd_ < 0 || hash.size() != 40) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    char header[64];
+    std::size_t produced = 0;
+    ObjectType type = ObjectType::kNone;
+    std::size_t body_size = 0;
+    std::size_t header_len = 0;
+    return zlib_inflate_prefix(data, size, header, sizeof(header), produced) &&
+           parse_object_header(header, produced, type, body_size, header_len) &&
+           add_compressed(hash, type, body_size, data, size);
+}
+
+bool PackWriter::add_compressed(const std::string& hash, ObjectType type,
+                                std::uint64_t body_size, const char* data, std::size_t size) {
+    if (fd_ < 0 || hash.size() != 40 || type == ObjectType::kNone) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    std::string head;
+    write_entry_header(head, static_cast<PackEntryType>(type), body_size);
+    write_varint(head, size);
+    return add_entry(hash, head, data, size, static_cast<PackEntryType>(type));
+}
+
+// 解析完整对象的头部得到内容长度，数据本身不压缩
+bool PackWriter::add_stored(const std::string& hash, const std::string& content) {
+    if (fd_ < 0 || hash.size() != 40) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    ObjectType type = ObjectType::kNone;
+    std::size_t body_size = 0;
+    std::size_t header_len = 0;
+    if (!parse_object_header(content.data(), content.size(), type, body_size, header_len)) {
+        return false;
+    }
+    std::string head;
+    write_entry_header(head, PackEntryType::kStored, body_size);
+    write_varint(head, content.size());
+    return add_entry(hash, head, content.data(), content.size(), PackEntryType::kStored);
+}
+
+// 基准已在本包中时记录偏移距离，否则记录基准的二进制 ID
+bool PackWriter::add_delta(const std::string& hash, const std::string& base_hash,
+                           std::uint64_t delta_size, const char* data, std::size_t size) {
+    if (fd_ < 0 || hash.size() != 40) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    std::string head;
+    std::unordered_map<std::string, Entry>::const_iterator base = entries_.find(base_hash);
+    if (base != entries_.end()) {
+        write_entry_header(head, PackEntryType::kOfsDelta, delta_size);
+        write_varint(head, size);
+        write_ofs_distance(head, offset_ - base->second.offset);
+        return add_entry(hash, head, data, size, PackEntryType::kOfsDelta);
+    }
+    unsigned char raw[20];
+    if (!hex_to_raw(base_hash, raw)) {
+        return false;
+    }
+    write_entry_header(head, PackEntryType::kRefDelta, delta_size);
+    write_varint(head, size);
+    head.append(reinterpret_cast<const char*>(raw), sizeof(raw));
+    return add_entry(hash, head, data, size, PackEntryType::kRefDelta);
+}
+
+// 按原条目的类型与长度重建头部，delta 的偏移距离按本包中基准的位置重新计算
+bool PackWriter::copy_entry(const std::string& hash, const PackEntryView& entry,
+                            const std::string& base_hash, std::uint32_t crc) {
+    if (fd_ < 0 || hash.size() != 40 || entry.type == PackEntryType::kLegacy) {
+        return false;
+    }
+    if (entries_.count(hash)) {
+        return true;
+    }
+    bool is_delta =
+        entry.type == PackEntryType::kOfsDelta || entry.type == PackEntryType::kRefDelta;
+    std::string head;
+    if (is_delta) {
+        std::unordered_map<std::string, Entry>::const_iterator base = entries_.find(base_hash);
+        if (base == entries_.end()) {
+            return false;
+        }
+        write_entry_header(head, PackEntryType::kOfsDelta, entry.object_size);
+        write_varint(head, entry.size);
+        write_ofs_distance(head, offset_ - base->second.offset);
+    } else {
+        write_entry_header(head, entry.type, entry.object_size);
+        write_varint(head, entry.size);
+    }
+    const char* start = entry_start(entry);
+    bool same = head.size() == static_cast<std::size_t>(entry.data - start) &&
+                std::memcmp(head.data(), start, head.size()) == 0;
+    return add_entry(hash, head, entry.data, entry.size,
+                     is_delta ? PackEntryType::kOfsDelta : entry.type, same ? &crc : nullptr);
+}
+
+// 追加 "条目头部 + 压缩数据" 并记录偏移与覆盖整个条目的 CRC32，已知 CRC 时不再计算
+bool PackWriter::add_entry(const std::string& hash, const std::string& head, const char* data,
+                           std::size_t size, PackEntryType type,
+                           const std::uint32_t* known_crc) {
+    Entry e;
+    e.offset = offset_;
+    e.length = head.size() + size;
+    e.header = static_cast<std::uint32_t>(head.size());
+    e.type = type;
+    if (!append(head.data(), head.size()) || !append(data, size)) {
+        return false;
+    }
+    if (known_crc) {
+        e.crc = *known_crc;
+    } else {
+        uLong crc = ::crc32(0L, Z_NULL, 0);
+        crc = ::crc32(crc, reinterpret_cast<const Bytef*>(head.data()),
+                      static_cast<uInt>(head.size()));
+        e.crc = static_cast<std::uint32_t>(crc32_large(crc, data, size));
+    }
+    entries_[hash] = e;
+    order_.push_back(hash);
+    return true;
+}
+
+bool PackWriter::contains(const std::string& hash) const {
+    return entries_.count(hash) > 0;
+}
+
+// 条目按哈希散列存放，只能逐个比较
+void PackWriter::find_prefix(const std::string& prefix, std::size_t limit,
+                             std::vector<std::string>& matches) const {
+    std::size_t found = 0;
+    std::unordered_map<std::string, Entry>::const_iterator it;
+    for (it = entries_.begin(); it != entries_.end() && found < limit; ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            matches.push_back(it->first);
+            ++found;
+        }
+    }
+}
+
+// 按记录的偏移从临时文件读回条目数据，压缩的再解压
+bool PackWriter::read_object(const std::string& hash, std::string& inflated) const {
+    std::unordered_map<std::string, Entry>::const_iterator it = entries_.find(hash);
+    if (fd_ < 0 || it == entries_.end() || it->second.type == PackEntryType::kOfsDelta ||
+        it->second.type == PackEntryType::kRefDelta) {
+        return false;
+    }
+    std::string data;
+    data.resize(static_cast<std::size_t>(it->second.length - it->second.header));
+    if (!pread_all(fd_, &data[0], data.size(), it->second.offset + it->second.header)) {
+        return false;
+    }
+    if (it->second.type == PackEntryType::kStored) {
+        inflated.swap(data);
+        return true;
+    }
+    return zlib_inflate_into(data.data(), data.size(), inflated);
+}
+
+// 以整包校验和命名包文件：内容不同的包不会同名，同名的包内容必然相同，
+// 因此目标已存在时直接丢弃临时文件，不改动正在被读取的包与索引
+bool PackWriter::finish(std::string& out_relative_path) {
+    unsigned char trailer[20];
+    if (!seal(trailer)) {
+        abort();
+        return false;
+    }
+    std::string rel = "objects/pack/pack-" + raw_to_hex(trailer) + ".mpk";
+    if (fs_->exists(rel)) {
+        abort();
+    } else if (!publish(rel, trailer)) {
+        return false;
+    }
+    out_relative_path = rel;
+    return true;
+}
+
+// 指定路径的包不覆盖已有文件：.idx 不记录包校验和，覆盖期间新索引会与旧包内容错配
+bool PackWriter::finish_as(const std::string& relative_path) {
+    unsigned char trailer[20];
+    if (!seal(trailer) || fs_->exists(relative_path)) {
+        abort();
+        return false;
+    }
+    return publish(relative_path, trailer);
+}
+
+// 对象数量与包头不符时回填数量并重新计算校验和，随后追加校验和、落盘并关闭临时文件
+bool PackWriter::seal(unsigned char trailer[20]) {
+    if (fd_ < 0 || order_.empty()) {
+        return false;
+    }
+    bool ok = true;
+    if (order_.size() != header_count_) {
+        std::string count;
+        write_u32_be(count, static_cast<std::uint32_t>(order_.size()));
+        ok = ::pwrite(fd_, count.data(), count.size(), 4) == 4;
+        sha_ = Sha1();
+        std::vector<char> buf(1U << 20);
+        for (std::uint64_t pos = 0; ok && pos < offset_;) {
+            std::size_t n = static_cast<std::size_t>(
+                std::min<std::uint64_t>(buf.size(), offset_ - pos));
+            ok = pread_all(fd_, &buf[0], n, pos);
+            sha_.update(&buf[0], n);
+            pos += n;
+        }
+    }
+    sha_.final_raw(trailer);
+    ok = ok && write_all_fd(fd_, reinterpret_cast<const char*>(trailer), 20U);
+    ok = ok && ::fsync(fd_) == 0;
+    ok = (::close(fd_) == 0) && ok;
+    fd_ = -1;
+    return ok;
+}
+
+// 写出 .idx 与 .rev 后原子改名临时包文件，并同步目录
+bool PackWriter::publish(const std::string& relative_path, const unsigned char trailer[20]) {
+    std::vector<PackIndexEntry> index;
+    index.reserve(order_.size());
+    std::unordered_map<std::string, Entry>::const_iterator it;
+    for (it = entries_.begin(); it != entries_.end(); ++it) {
+        PackIndexEntry ie;
+        ie.hash = it->first;
+        ie.offset = it->second.offset;
+        ie.crc = it->second.crc;
+        index.push_back(ie);
+    }
+    std::size_t slash = relative_path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? std::string() : relative_path.substr(0, slash);
+    // 索引与反向索引先于包文件落盘，包文件一旦可见即可查找
+    std::string idx_path = fs_->make_path(pack_sibling_path(relative_path, ".idx"));
+    PackIndex written;
+    if ((!dir.empty() && !fs_->ensure_directory(dir)) ||
+        !write_pack_index(idx_path, index) || !written.open(idx_path) ||
+        !write_pack_reverse_index(fs_->make_path(pack_sibling_path(relative_path, ".rev")),
+                                  written, trailer) ||
+        std::rename(tmp_path_.c_str(), fs_->make_path(relative_path).c_str()) != 0) {
+        abort();
+        return false;
+    }
+    int dfd = ::open(fs_->make_path(dir).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd >= 0) {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+    tmp_path_.clear();
+    entries_.clear();
+    order_.clear();
+    offset_ = 0;
+    return true;
+}
+
+// 关闭并删除临时文件，清空内存索引
+void PackWriter::abort() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (!tmp_path_.empty()) {
+        ::unlink(tmp_path_.c_str());
+        tmp_path_.clear();
+    }
+    entries_.clear();
+    order_.clear();
+    offset_ = 0;
+}
+
+std::size_t PackWriter::object_count() const {
+    return order_.size();
+}
+
+PackReader::PackReader()
+    : data_(nullptr), size_(0), count_(0), version_(0), legacy_id_ready_(false) {}
+
+PackReader::~PackReader() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+// 映射整个包文件并校验 "MPK1" 或 "MPK2" 包头
+bool PackReader::open(const std::string& path, Access access) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 8) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const char* data = static_cast<const char*>(map);
+    std::string head(data, 8);
+    std::size_t pos = 4;
+    std::uint32_t count = 0;
+    int version = head.compare(0, 4, "MPK1") == 0 ? 1
+                  : head.compare(0, 4, "MPK2") == 0 ? 2
+                                                    : 0;
+    if (version == 0 || !read_u32_be(head, pos, count)) {
+        ::munmap(map, size);
+        return false;
+    }
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = data;
+    size_ = size;
+    count_ = count;
+    version_ = version;
+    legacy_id_ready_ = false;
+    advise(access);
+    return true;
+}
+
+void PackReader::advise(Access access) {
+    if (data_) {
+        ::madvise(const_cast<char*>(data_), size_,
+                  access == Access::kSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    }
+}
+
+// 按页对齐后发出 MADV_WILLNEED，让内核在真正访问前开始读入
+void PackReader::prefetch(std::uint64_t begin, std::uint64_t end) const {
+    if (!data_ || begin >= end || begin >= size_) {
+        return;
+    }
+    end = std::min<std::uint64_t>(end, size_);
+    std::uint64_t page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+    std::uint64_t start = begin - begin % page;
+    ::madvise(const_cast<char*>(data_) + start, static_cast<std::size_t>(end - start),
+              MADV_WILLNEED);
+}
+
+std::uint32_t PackReader::count() const {
+    return count_;
+}
+
+int PackReader::version() const {
+    return version_;
+}
+
+std::uint64_t PackReader::first_offset() const {
+    return 8U;
+}
+
+// 按包格式解析条目头部并检查边界：MPK1 为 "哈希 + 长度 + 压缩数据"，
+// MPK2 为 "类型与长度 + 压缩长度 + 基准 + 压缩数据"，且不会越过末尾的校验和
+bool PackReader::entry_at(std::uint64_t offset, PackEntryView& out) const {
+    if (!data_ || offset > size_) {
+        return false;
+    }
+    out.type = PackEntryType::kLegacy;
+    out.object_size = 0;
+    out.hash = nullptr;
+    out.base_offset = 0;
+    out.base_id = nullptr;
+    if (version_ == 1) {
+        if (size_ - offset < 44U) {
+            return false;
+        }
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data_ + offset + 40);
+        std::uint64_t sz = (static_cast<std::uint32_t>(p[0]) << 24) |
+                           (static_cast<std::uint32_t>(p[1]) << 16) |
+                           (static_cast<std::uint32_t>(p[2]) << 8) |
+                           static_cast<std::uint32_t>(p[3]);
+        if (size_ - offset - 44U < sz) {
+            return false;
+        }
+        out.hash = data_ + offset;
+        out.data = data_ + offset + 44U;
+        out.size = static_cast<std::size_t>(sz);
+        out.offset = offset;
+        out.next = offset + 44U + sz;
+        return true;
+    }
+
+    if (size_ < 20U || offset >= size_ - 20U) {
+        return false;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data_ + offset);
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(data_ + size_ - 20U);
+    int type = 0;
+    std::uint64_t compressed = 0;
+    if (!read_entry_header(p, end, type, out.object_size) || !read_varint(p, end, compressed)) {
+        return false;
+    }
+    out.type = static_cast<PackEntryType>(type);
+    switch (out.type) {
+    case PackEntryType::kCommit:
+    case PackEntryType::kTree:
+    case PackEntryType::kBlob:
+    case PackEntryType::kStored:
+        break;
+    case PackEntryType::kOfsDelta: {
+        std::uint64_t distance = 0;
+        if (!read_ofs_distance(p, end, distance) || distance == 0 || distance > offset) {
+            return false;
+        }
+        out.base_offset = offset - distance;
+        break;
+    }
+    case PackEntryType::kRefDelta:
+        if (end - p < 20) {
+            return false;
+        }
+        out.base_id = p;
+        p += 20;
+        break;
+    default:
+        return false;
+    }
+    if (static_cast<std::uint64_t>(end - p) < compressed) {
+        return false;
+    }
+    out.data = reinterpret_cast<const char*>(p);
+    out.size = static_cast<std::size_t>(compressed);
+    out.offset = offset;
+    out.next = static_cast<std::uint64_t>(reinterpret_cast<const char*>(p) - data_) + compressed;
+    return true;
+}
+
+bool PackReader::inflate(const PackEntryView& entry, std::string& inflated,
+                         ZlibInflater* inflater) const {
+    if (entry.type == PackEntryType::kStored) {
+        inflated.assign(entry.data, entry.size);
+        return true;
+    }
+    if (inflater) {
+        return inflater->inflate_into(entry.data, entry.size, inflated);
+    }
+    return zlib_inflate_into(entry.data, entry.size, inflated);
+}
+
+std::uint32_t PackReader::entry_crc(const PackEntryView& entry) const {
+    return static_cast<std::uint32_t>(
+        crc32_large(::crc32(0L, Z_NULL, 0), entry_start(entry),
+                    static_cast<std::size_t>(entry.next - entry.offset)));
+}
+
+// 顺序计算除末尾 20 字节外全部内容的 SHA-1 并与末尾校验和比较
+bool PackReader::verify_checksum() const {
+    if (!checksum()) {
+        return false;
+    }
+    Sha1 sha;
+    sha.update(data_, size_ - 20U);
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    return std::memcmp(digest, data_ + size_ - 20U, 20U) == 0;
+}
+
+std::size_t PackReader::size() const {
+    return size_;
+}
+
+const unsigned char* PackReader::checksum() const {
+    if (!data_ || version_ != 2 || size_ < 8U + 20U) {
+        return nullptr;
+    }
+    return reinterpret_cast<const unsigned char*>(data_ + size_ - 20U);
+}
+
+// MPK1 的最后 20 字节只是压缩数据，改用整个文件的 SHA-1 标识内容
+const unsigned char* PackReader::content_id() const {
+    if (!data_ || version_ != 1) {
+        return checksum();
+    }
+    if (!legacy_id_ready_) {
+        Sha1 sha;
+        sha.update(data_, size_);
+        sha.final_raw(legacy_id_);
+        legacy_id_ready_ = true;
+    }
+    return legacy_id_;
+}
+
+const std::size_t PackSet::kNoPack;
+
+PackSet::PackSet(const std::string& root)
+    : fs_(root), dir_mtime_sec_(-1), dir_mtime_nsec_(-1),
+      base_cache_(kDefaultBaseCacheBytes) {}
+
+// 在各包的索引中查找对象并返回映射区域中的条目
+bool PackSet::find_entry(const std::string& hash, PackEntryView& entry) {
+    DeltaBaseKey key;
+    return locate(hash, key, entry);
+}
+
+// 先查多包索引，未命中时再逐个查找未被多包索引覆盖的包
+bool PackSet::find_in_packs(const std::string& hash, std::size_t& pack,
+                            std::uint64_t& offset) const {
+    std::uint32_t id = 0;
+    if (midx_.find(hash, id, offset) && midx_packs_[id] != kNoPack) {
+        pack = midx_packs_[id];
+        return true;
+    }
+    std::uint32_t crc = 0;
+    for (std::size_t i = 0; i < packs_.size(); ++i) {
+        if (!packs_[i]->in_midx && packs_[i]->index.find(hash, offset, crc)) {
+            pack = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 查找对象所在的包与偏移并解析条目；未命中时检查包目录是否变化并重试。
+// MPK1 条目自带哈希，顺便核对索引是否与包一致
+bool PackSet::locate(const std::string& hash, DeltaBaseKey& key, PackEntryView& entry) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::size_t pack = 0;
+        std::uint64_t offset = 0;
+        if (find_in_packs(hash, pack, offset)) {
+            if (!packs_[pack]->reader.entry_at(offset, entry) ||
+                (entry.hash && hash.compare(0, 40, entry.hash, 40) != 0)) {
+                return false;
+            }
+            key.pack = pack;
+            key.offset = offset;
+            return true;
+        }
+        if (attempt == 0 && !refresh()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// 沿 delta 链向下查找，直到遇到完整对象或缓存中已重建的基准，再自底向上逐层应用 delta；
+// 途经的每个基准都放入缓存，同一条链上的后续读取可以从最近的已缓存节点继续。
+// kOfsDelta 的基准直接按偏移读取，不需要查找索引
+bool PackSet::read_object(const std::string& hash, std::string& inflated) {
+    DeltaBaseKey key;
+    PackEntryView entry;
+    return locate(hash, key, entry) && resolve(key, entry, inflated);
+}
+
+// kStored 条目直接指向映射区域，其余条目按 read_object 的方式重建
+bool PackSet::read_object_view(const std::string& hash, std::string& inflated,
+                               const char*& data, std::size_t& size,
+                               std::shared_ptr<const void>& owner) {
+    owner.reset();
+    DeltaBaseKey key;
+    PackEntryView entry;
+    if (!locate(hash, key, entry)) {
+        return false;
+    }
+    if (entry.type == PackEntryType::kStored) {
+        data = entry.data;
+        size = entry.size;
+        owner = packs_[key.pack];
+        return true;
+    }
+    if (!resolve(key, entry, inflated)) {
+        return false;
+    }
+    data = inflated.data();
+    size = inflated.size();
+    return true;
+}
+
+// 按包名找到已加载的包（必要时重新扫描目录），从给定偏移的条目开始重建对象
+bool PackSet::read_packed_at(const std::string& pack_name, std::uint64_t offset,
+                             std::string& inflated) {
+    std::map<std::string, std::size_t>::const_iterator it = loaded_.find(pack_name);
+    if (it == loaded_.end()) {
+        refresh();
+        it = loaded_.find(pack_name);
+        if (it == loaded_.end()) {
+            return false;
+        }
+    }
+    DeltaBaseKey key;
+    key.pack = it->second;
+    key.offset = offset;
+    PackEntryView entry;
+    return packs_[key.pack]->reader.entry_at(offset, entry) && resolve(key, entry, inflated);
+}
+
+// 与 locate 相同的查找顺序，只返回包名与偏移
+bool PackSet::locate_object(const std::string& hash, std::string& pack_name,
+                            std::uint64_t& offset) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::size_t pack = 0;
+        if (find_in_packs(hash, pack, offset)) {
+            pack_name = packs_[pack]->name;
+            return true;
+        }
+        if (attempt == 0 && !refresh()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// 多包索引覆盖的包不再单独查找，与 find_in_packs 的顺序一致
+void PackSet::find_prefix(const std::string& prefix, std::size_t limit,
+                          std::vector<std::string>& matches) {
+    refresh();
+    midx_.find_prefix(prefix, limit, matches);
+    for (std::size_t i = 0; i < packs_.size(); ++i) {
+        if (!packs_[i]->in_midx) {
+            packs_[i]->index.find_prefix(prefix, limit, matches);
+        }
+    }
+}
+
+// 与 find_prefix 相同的查找范围，取各索引中相邻 ID 的最长共同前缀
+std::size_t PackSet::common_prefix_length(const std::string& hash) {
+    refresh();
+    std::size_t best = midx_.common_prefix_length(hash);
+    for (std::size_t i = 0; i < packs_.size(); ++i) {
+        if (!packs_[i]->in_midx) {
+            best = std::max(best, packs_[i]->index.common_prefix_length(hash));
+        }
+    }
+    return best;
+}
+
+// 解析最后一个条目得到其结束位置，对整段范围发出预读提示
+void PackSet::prefetch(const std::string& pack_name, std::uint64_t first, std::uint64_t last) {
+    std::map<std::string, std::size_t>::const_iterator it = loaded_.find(pack_name);
+    if (it == loaded_.end()) {
+        return;
+    }
+    const PackReader& reader = packs_[it->second]->reader;
+    PackEntryView entry;
+    if (reader.entry_at(last, entry)) {
+        reader.prefetch(first, entry.next);
+    }
+}
+
+bool PackSet::resolve(DeltaBaseKey key, PackEntryView entry, std::string& inflated) {
+    struct Link {
+        DeltaBaseKey key;
+        std::string delta;
+    };
+    std::vector<Link> chain;
+    std::shared_ptr<const std::string> base;
+    while (!base) {
+        if (chain.size() > kMaxDeltaDepth) {
+            return false;
+        }
+        if (!chain.empty() && base_cache_.capacity() > 0) {
+            const std::shared_ptr<const std::string>* hit = base_cache_.get(key);
+            if (hit) {
+                base = *hit;
+                break;
+            }
+        }
+        if (!packs_[key.pack]->reader.inflate(entry, scratch_, &inflater_)) {
+            return false;
+        }
+        bool legacy_delta =
+            entry.type == PackEntryType::kLegacy && scratch_.compare(0, 6, "delta ") == 0;
+        if (entry.type != PackEntryType::kOfsDelta && entry.type != PackEntryType::kRefDelta &&
+            !legacy_delta) {
+            if (chain.empty()) {
+                inflated.swap(scratch_);
+                return true;
+            }
+            base = std::make_shared<const std::string>(scratch_);
+            base_cache_.put(key, base, base->size());
+            break;
+        }
+        Link link;
+        link.key = key;
+        std::string base_hash;
+        if (legacy_delta) {
+            std::size_t nul = scratch_.find('\0');
+            if (nul == std::string::npos || scratch_.size() < nul + 41) {
+                return false;
+            }
+            link.delta.assign(scratch_, nul + 41, std::string::npos);
+            base_hash.assign(scratch_, nul + 1, 40);
+        } else {
+            link.delta.swap(scratch_);
+        }
+        chain.push_back(link);
+        if (entry.type == PackEntryType::kOfsDelta) {
+            key.offset = entry.base_offset;
+            if (!packs_[key.pack]->reader.entry_at(key.offset, entry)) {
+                return false;
+            }
+            continue;
+        }
+        if (entry.type == PackEntryType::kRefDelta) {
+            base_hash = raw_to_hex(entry.base_id);
+        }
+        if (!locate(base_hash, key, entry)) {
+            return false;
+        }
+    }
+
+    for (std::size_t i = chain.size(); i-- > 0;) {
+        std::string& out = i == 0 ? inflated : scratch_;
+        if (!apply_delta(base->data(), base->size(), chain[i].delta.data(),
+                         chain[i].delta.size(), out)) {
+            return false;
+        }
+        if (i > 0) {
+            base = std::make_shared<const std::string>(out);
+            base_cache_.put(chain[i].key, base, base->size());
+        }
+    }
+    return true;
+}
+
+void PackSet::set_base_cache_limit(std::size_t bytes) {
+    base_cache_.set_capacity(bytes);
+    if (bytes == 0) {
+        base_cache_.clear();
+    }
+}
+
+std::uint64_t PackSet::base_cache_hits() const {
+    return base_cache_.hits();
+}
+
+std::uint64_t PackSet::base_cache_misses() const {
+    return base_cache_.misses();
+}
+
+std::size_t PackSet::base_cache_limit() const {
+    return base_cache_.capacity();
+}
+
+bool PackSet::contains(const std::string& hash) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::size_t pack = 0;
+        std::uint64_t offset = 0;
+        if (find_in_packs(hash, pack, offset)) {
+            return true;
+        }
+        if (attempt == 0 && !refresh()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// 包目录修改时间变化时丢弃文件已被删除的包、加载新出现的包文件并重新映射多包索引，
+// 返回是否加载了新包
+bool PackSet::refresh() {
+    struct stat st;
+    if (::stat(fs_.make_path("objects/pack").c_str(), &st) != 0) {
+        return false;
+    }
+    // 时间戳精度有限，目录在最近一秒内被修改时即使时间相同也重新扫描
+    if (dir_mtime_sec_ == static_cast<std::int64_t>(st.st_mtim.tv_sec) &&
+        dir_mtime_nsec_ == static_cast<std::int64_t>(st.st_mtim.tv_nsec) &&
+        std::time(nullptr) > st.st_mtim.tv_sec + 1) {
+        return false;
+    }
+    dir_mtime_sec_ = static_cast<std::int64_t>(st.st_mtim.tv_sec);
+    dir_mtime_nsec_ = static_cast<std::int64_t>(st.st_mtim.tv_nsec);
+
+    DIR* d = opendir(fs_.make_path("objects/pack").c_str());
+    if (!d) {
+        return false;
+    }
+    std::vector<std::string> names;
+    std::set<std::string> present;
+    dirent* de;
+    while ((de = readdir(d)) != nullptr) {
+        std::string name = de->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mpk") == 0) {
+            present.insert(name);
+            if (!loaded_.count(name)) {
+                names.push_back(name);
+            }
+        }
+    }
+    closedir(d);
+
+    if (present.size() < loaded_.size() + names.size()) {
+        // 重打包删除的旧包不再参与查找，仍被视图持有的包待持有者释放后才解除映射；
+        // 包序号随之变化，基准缓存一并清空
+        std::vector<std::shared_ptr<Pack> > kept;
+        loaded_.clear();
+        for (std::size_t i = 0; i < packs_.size(); ++i) {
+            if (present.count(packs_[i]->name)) {
+                loaded_[packs_[i]->name] = kept.size();
+                kept.push_back(std::move(packs_[i]));
+            }
+        }
+        packs_.swap(kept);
+        base_cache_.clear();
+    }
+
+    bool loaded_any = false;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::string rel = "objects/pack/" + names[i];
+        std::string idx = fs_.make_path(pack_sibling_path(rel, ".idx"));
+        std::shared_ptr<Pack> pack(new Pack);
+        if (!pack->index.open(idx) &&
+            !(index_pack_file(fs_, rel) && pack->index.open(idx))) {
+            continue;
+        }
+        if (!pack->reader.open(fs_.make_path(rel))) {
+            continue;
+        }
+        pack->name = names[i];
+        loaded_[names[i]] = packs_.size();
+        packs_.push_back(std::move(pack));
+        loaded_any = true;
+    }
+
+    midx_.open(fs_.make_path(std::string("objects/pack/") + kMultiPackIndexName));
+    midx_packs_.assign(midx_.pack_count(), kNoPack);
+    for (std::size_t i = 0; i < packs_.size(); ++i) {
+        packs_[i]->in_midx = false;
+    }
+    for (std::size_t i = 0; i < midx_.pack_count(); ++i) {
+        std::map<std::string, std::size_t>::const_iterator it =
+            loaded_.find(midx_.pack_name(i));
+        if (it != loaded_.end()) {
+            midx_packs_[i] = it->second;
+            packs_[it->second]->in_midx = true;
+        }
+    }
+    return loaded_any;
+}
+
+std::string pack_sibling_path(const std::string& pack_path, const char* suffix) {
+    std::string out = pack_path;
+    if (out.size() >= 4 && out.compare(out.size() - 4, 4, ".mpk") == 0) {
+        out.erase(out.size() - 4);
+    }
+    out.append(suffix);
+    return out;
+}
+
+// 顺序遍历包文件的每个条目，记录偏移与 CRC32 后写出索引与反向索引；
+// MPK2 条目不含哈希，需重建对象后计算，delta 的基准总在它之前出现
+bool index_pack_file(const FileSystem& fs, const std::string& pack_relative_path) {
+    PackReader reader;
+    if (!reader.open(fs.make_path(pack_relative_path), PackReader::Access::kSequential)) {
+        return false;
+    }
+    std::vector<PackIndexEntry> entries;
+    entries.reserve(reader.count());
+    std::unordered_map<std::string, std::uint64_t> offsets;
+    std::function<bool(const std::string&, std::uint64_t&)> find_base =
+        [&offsets](const std::string& hash, std::uint64_t& offset) {
+            std::unordered_map<std::string, std::uint64_t>::const_iterator it =
+                offsets.find(hash);
+            if (it == offsets.end()) {
+                return false;
+            }
+            offset = it->second;
+            return true;
+        };
+    std::string content;
+    std::uint64_t offset = reader.first_offset();
+    for (std::uint32_t i = 0; i < reader.count(); ++i) {
+        PackEntryView entry;
+        if (!reader.entry_at(offset, entry)) {
+            return false;
+        }
+        PackIndexEntry e;
+        if (entry.hash) {
+            e.hash.assign(entry.hash, 40);
+        } else if (inflate_pack_object(reader, entry.offset, find_base, content)) {
+            e.hash = sha1_hex(content);
+        } else {
+            return false;
+        }
+        e.offset = entry.offset;
+        e.crc = reader.entry_crc(entry);
+        offsets[e.hash] = e.offset;
+        entries.push_back(e);
+        offset = entry.next;
+    }
+    std::string idx_path = fs.make_path(pack_sibling_path(pack_relative_path, ".idx"));
+    PackIndex index;
+    return write_pack_index(idx_path, entries) && index.open(idx_path) &&
+           write_pack_reverse_index(fs.make_path(pack_sibling_path(pack_relative_path, ".rev")),
+                                    index, reader.content_id());
+}
+
+}  // namespace minigit
@@ -1,9 +1,22 @@
 ﻿#pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "byte_slice.h"
 #include "filesystem.h"
+#include "hash.h"
+#include "lru_cache.h"
+#include "object_store.h"
+#include "pack_index.h"
+#include "zlib_utils.h"
 
 namespace minigit {
 
@@ -12,11 +25,776 @@ struct PackedEntry {
     std::string compressed;
 };
 
+/**
+ * @brief 打包时的 delta 搜索参数。
+ */
+struct PackOptions {
+    /// 为每个对象尝试的候选基准数量，0 表示不生成 delta。
+    std::size_t window = 10;
+    /// delta 链的最大长度。
+    std::size_t depth = 50;
+    /// 读取、delta 搜索与压缩使用的工作线程数，0 表示使用全部 CPU 核心。
+    std::size_t threads = 0;
+    /// 增量重打包时相邻两个包对象数的最小倍数，小于 2 时按 2 处理。
+    std::size_t geometric_factor = 2;
+    /// 增量重打包时是否把全部已有的包合并为一个。
+    bool all = false;
+    /// 是否以未压缩的 kStored 条目存放提交与 tree（不做 delta），读取时无需解压；
+    /// 重打包时旧包中的提交与 tree 也随之转换，关闭时已有的 kStored 条目原样保留。
+    bool uncompressed_metadata = false;
+};
+
+/**
+ * @brief 一次打包的统计信息。
+ */
+struct PackStats {
+    /// 写入包中的对象总数。
+    std::size_t objects = 0;
+    /// 其中以 delta 形式存储的对象数量。
+    std::size_t deltas = 0;
+    /// 增量重打包时被合并并删除的旧包数量。
+    std::size_t merged_packs = 0;
+    /// 从旧包中原样复制、未重新压缩的条目数量。
+    std::size_t reused = 0;
+};
+
+/**
+ * @brief 使用默认参数打包全部松散对象，见带 PackOptions 的重载。
+ */
 bool write_pack_file(FileSystem& fs, const std::string& pack_relative_path);
 
+/**
+ * @brief 将全部松散对象写入指定路径的包文件，并生成同名 .idx 索引。
+ *
+ * 包文件为 MPK2 格式（见 PackWriter）。对象按类型、路径名哈希（取自 tree 条目）
+ * 与长度排序，每个对象在前 options.window 个同类型对象中寻找最小的 delta，
+ * 基准位于同一个包中并以偏移引用。不使用 delta 的对象原样搬运松散对象的压缩数据。排序后的对象被切分为
+ * 多段，由 options.threads 个工作线程并行完成 delta 搜索与压缩（delta 链不跨段），
+ * 再由单一写入者按访问局部性顺序写入临时文件：先是按时间由新到旧的提交（子提交先于父提交），
+ * 再是依次检出这些提交时按深度优先顺序遇到的 tree 与 blob，delta 的基准总先于 delta 写入；
+ * 内存中只保留 delta 数据。包文件末尾附加覆盖全部内容的 SHA-1 校验和，落盘后原子改名到目标路径。
+ *
+ * @param fs                 仓库根目录对应的文件系统对象。
+ * @param pack_relative_path 以 ".mpk" 结尾的目标包文件相对路径。
+ * @param options            delta 搜索参数。
+ * @param stats              输出参数，打包统计信息。
+ * @return 存在松散对象且写入成功返回 true；目标路径已存在或写入失败返回 false。
+ */
+bool write_pack_file(FileSystem& fs, const std::string& pack_relative_path,
+                     const PackOptions& options, PackStats& stats);
+
+/**
+ * @brief 增量重打包：只打包新对象，并让包集合保持几何级数。
+ *
+ * 已存在于某个包中的松散对象不再重复打包。按对象数升序排列现有的包，
+ * 若相邻两个包的对象数之比不足 options.geometric_factor，或较小的包加上
+ * 新对象的总数不足下一个包的 1/factor，则把这些最小的包与新对象合并为一个
+ * 新包（以整包校验和命名为 objects/pack/pack-<sha1>.mpk），旧包中的条目逐字节
+ * 复制，不解压也不重新压缩：复制前用 .idx 中的 CRC32 校验条目，delta 条目只在
+ * 基准也进入新包时复用，否则重建为完整对象。较大的包保持不动，因此每次重打包的开销只与新数据
+ * 及被合并的小包有关；options.all 为 true 时合并全部已有的包。新包落盘后删除
+ * 被合并的旧包（连同其索引与位图）与已入包的松散对象。
+ *
+ * @param fs                仓库根目录对应的文件系统对象。
+ * @param options           delta 搜索参数与几何级数倍数。
+ * @param stats             输出参数，写入新包的对象数、delta 数与合并的包数。
+ * @param out_relative_path 输出参数，新包的相对路径；无需写入新包时为空字符串。
+ * @return 成功（包括无需打包）返回 true，写入失败返回 false。
+ */
+bool repack_incremental(FileSystem& fs, const PackOptions& options, PackStats& stats,
+                        std::string& out_relative_path);
+
+/**
+ * @brief 把全部包与松散对象中属于 keep 的对象重写为单个新包，其余对象不进入新包。
+ *
+ * 旧包中的条目按 repack_incremental 的方式校验后逐字节复制，松散对象做 delta 搜索后写入。
+ * 新包落盘后删除全部旧包（连同其索引与位图）以及已入包的松散对象；不在 keep 中的松散
+ * 对象保持不动，由调用方决定是否删除。keep 中的对象都不存在时不写入新包。
+ *
+ * @param fs                仓库根目录对应的文件系统对象。
+ * @param options           delta 搜索参数。
+ * @param keep              需要保留的对象哈希集合。
+ * @param stats             输出参数，写入新包的对象数、delta 数与删除的旧包数。
+ * @param out_relative_path 输出参数，新包的相对路径；未写入新包时为空字符串。
+ * @return 成功返回 true，读取或写入失败返回 false（此时不删除任何文件）。
+ */
+bool repack_objects(FileSystem& fs, const PackOptions& options,
+                    const std::unordered_set<std::string>& keep, PackStats& stats,
+                    std::string& out_relative_path);
+
+/**
+ * @brief 包内单个对象条目的磁盘占用。
+ */
+struct PackObjectSize {
+    /// 对象哈希（40 位十六进制字符串）。
+    std::string hash;
+    /// 条目在包文件中的起始偏移。
+    std::uint64_t offset;
+    /// 条目在包文件中占用的字节数（含条目头部）。
+    std::uint64_t disk_size;
+};
+
+/**
+ * @brief 按包内偏移顺序列出每个对象条目的磁盘占用。
+ *
+ * 使用与包同名的 .rev 反向索引，无需读取条目或对偏移重新排序；
+ * 反向索引缺失或与包不匹配时先重新生成。
+ *
+ * @param fs                 仓库根目录对应的文件系统对象。
+ * @param pack_relative_path 以 ".mpk" 结尾的包文件相对路径，需已有 .idx。
+ * @param out                输出参数，按偏移升序排列的条目信息。
+ * @return 成功返回 true，包或索引无法读取时返回 false。
+ */
+bool pack_object_sizes(const FileSystem& fs, const std::string& pack_relative_path,
+                       std::vector<PackObjectSize>& out);
+
+/**
+ * @brief 列出全部松散对象的哈希，只读取目录项。
+ *
+ * @param fs  仓库根目录对应的文件系统对象。
+ * @param out 输出参数，松散对象哈希（顺序不定）。
+ */
+void list_loose_objects(const FileSystem& fs, std::vector<std::string>& out);
+
+/**
+ * @brief 列出 objects/pack 下的全部包文件，缺少 .idx 的包先补建索引。
+ *
+ * @param fs  仓库根目录对应的文件系统对象。
+ * @param out 输出参数，包文件相对路径（形如 "objects/pack/pack-xxx.mpk"）。
+ */
+void list_pack_files(const FileSystem& fs, std::vector<std::string>& out);
+
+/**
+ * @brief 按 objects/pack 下当前的包增量更新多包索引。
+ *
+ * 缺少 .idx 的包先补建索引，见 write_multi_pack_index。
+ *
+ * @param fs 仓库根目录对应的文件系统对象。
+ * @return 更新成功返回 true，否则返回 false。
+ */
+bool update_multi_pack_index(const FileSystem& fs);
+
+/**
+ * @brief 读取整个包文件，得到每个对象的压缩数据。
+ *
+ * 同时支持 MPK1 与 MPK2 格式。MPK2 条目不含对象 ID，需借助同名 .idx（缺失时先补建）；
+ * 其中的 delta 条目会被重建为完整对象并重新压缩，因此输出的压缩数据解压后
+ * 总是含 "type size\0" 头部的完整对象。MPK1 的 delta 条目保持原样。
+ *
+ * @param fs                 仓库根目录对应的文件系统对象。
+ * @param pack_relative_path 以 ".mpk" 结尾的包文件相对路径。
+ * @param out_entries        输出参数，哈希到条目的映射。
+ * @return 包文件格式正确返回 true，否则返回 false。
+ */
 bool read_pack_file(FileSystem& fs,
                     const std::string& pack_relative_path,
                     std::map<std::string, PackedEntry>& out_entries);
 
+/**
+ * @brief 为已有的包文件生成同名的 .idx 索引。
+ *
+ * 顺序扫描包文件，逐个条目记录偏移并计算 CRC32，内存中只保留索引条目；
+ * 同时生成 .rev 反向索引。MPK2 条目不含对象 ID，需重建每个对象（含 delta）
+ * 并计算其哈希。
+ *
+ * @param fs                 仓库根目录对应的文件系统对象。
+ * @param pack_relative_path 以 ".mpk" 结尾的包文件相对路径。
+ * @return 包文件格式正确且索引写入成功返回 true，否则返回 false。
+ */
+bool index_pack_file(const FileSystem& fs, const std::string& pack_relative_path);
+
+/**
+ * @brief 将包文件路径的 ".mpk" 后缀替换为给定后缀。
+ *
+ * @param pack_path 包文件路径。
+ * @param suffix    新后缀，例如 ".idx"。
+ * @return 替换后的路径；原路径不以 ".mpk" 结尾时直接追加后缀。
+ */
+std::string pack_sibling_path(const std::string& pack_path, const char* suffix);
+
+/**
+ * @brief 包条目的类型，数值与 MPK2 条目头部中的类型字段一致。
+ */
+enum class PackEntryType {
+    /// MPK1 条目：头部不含类型，解压后以 "delta " 开头的是 delta，否则是完整对象。
+    kLegacy = 0,
+    kCommit = 1,
+    kTree = 2,
+    kBlob = 3,
+    /// 未压缩的完整对象，数据即对象完整内容（含 "type size\0" 头部），可在映射区域中原地解析。
+    kStored = 4,
+    /// 基准位于同一个包中，以偏移距离引用。
+    kOfsDelta = 6,
+    /// 基准以 20 字节二进制 ID 引用。
+    kRefDelta = 7,
+};
+
+struct PackEntryView;
+
+/**
+ * @brief 以流式方式向新的包文件追加对象的写入器。
+ *
+ * 对象逐个压缩后立即写入 objects/pack 下的临时文件，内存中只保留
+ * "哈希 -> 偏移" 的索引；finish 时追加整包 SHA-1 校验和、写出 .idx 索引
+ * 与 .rev 反向索引，fsync 后原子改名为正式包文件。
+ * 在 finish 之前，已写入的完整对象可以通过 read_object 读回，
+ * 便于批量导入过程中引用本次会话写入的 tree 等对象。
+ *
+ * 写出的包为 MPK2 格式："MPK2" + u32 大端对象数 + N 个条目 + 20 字节 SHA-1。
+ * 每个条目依次为：
+ *   - 类型与长度头部：首字节第 4~6 位为 PackEntryType，低 4 位为长度的最低 4 位，
+ *     最高位表示后续还有字节，每个后续字节提供长度的下 7 位；
+ *     完整对象的长度为对象内容（不含头部）的字节数，delta 为 delta 指令的字节数；
+ *   - 压缩数据长度（LEB128 变长整数）；
+ *   - kOfsDelta：基准与本条目的偏移距离（与 Git 相同的变长编码）；
+ *     kRefDelta：基准的 20 字节二进制 ID；
+ *   - zlib 压缩数据：完整对象与松散对象文件相同（含 "type size\0" 头部），
+ *     delta 为作用于基准完整内容（含头部）的 delta 指令；kStored 条目为未压缩的完整对象内容，
+ *     头部中的长度仍为对象内容（不含头部）的字节数。
+ * 条目中不再保存对象 ID，ID 只记录在 .idx 中；长度与偏移都是 64 位。
+ */
+class PackWriter {
+public:
+    PackWriter();
+
+    /**
+     * @brief 若尚未 finish，则删除临时文件。
+     */
+    ~PackWriter();
+
+    PackWriter(const PackWriter&) = delete;
+    PackWriter& operator=(const PackWriter&) = delete;
+
+    /**
+     * @brief 在仓库的 objects/pack 目录下创建临时包文件并写入包头。
+     *
+     * 预先给出对象数量时，校验和可在写入过程中增量计算；
+     * 实际数量不同时 finish 会回填包头并重新读取临时文件计算校验和。
+     *
+     * @param fs             指向仓库根目录的文件系统对象，生命周期需覆盖整个写入过程。
+     * @param expected_count 预计写入的对象数量，未知时为 0。
+     * @return 创建成功返回 true，否则返回 false。
+     */
+    bool begin(const FileSystem& fs, std::uint32_t expected_count = 0);
+
+    /**
+     * @brief 追加一个完整对象（含 "type size\0" 头部）。
+     *
+     * 哈希已在本包中存在时直接返回 true 而不重复写入。
+     *
+     * @param hash   对象哈希（40 位十六进制字符串）。
+     * @param slices 按顺序拼接即为完整对象内容的切片数组。
+     * @param count  切片数量。
+     * @return 写入成功返回 true，否则返回 false。
+     */
+    bool add_object(const std::string& hash, const ByteSlice* slices,
+                    std::size_t count);
+
+    /**
+     * @brief 追加一个已经压缩好的对象（解压后含 "type size\0" 头部）。
+     *
+     * 用于原样搬运松散对象等已有压缩数据，不会重新压缩；
+     * 只解压开头的少量数据以得到条目头部所需的类型与长度。
+     *
+     * @param hash 对象哈希（40 位十六进制字符串）。
+     * @param data 压缩数据起始地址。
+     * @param size 压缩数据长度。
+     * @return 写入成功返回 true，否则返回 false。
+     */
+    bool add_compressed(const std::string& hash, const char* data, std::size_t size);
+
+    /**
+     * @brief 追加一个已知类型与长度的压缩对象，不解压任何数据。
+     *
+     * @param hash      对象哈希（40 位十六进制字符串）。
+     * @param type      对象类型。
+     * @param body_size 对象内容（不含头部）的字节数。
+     * @param data      压缩数据起始地址，解压后含 "type size\0" 头部。
+     * @param size      压缩数据长度。
+     * @return 写入成功返回 true，否则返回 false。
+     */
+    bool add_compressed(const std::string& hash, ObjectType type, std::uint64_t body_size,
+                        const char* data, std::size_t size);
+
+    /**
+     * @brief 以未压缩的 kStored 条目追加一个完整对象，读取时可直接在映射区域中解析。
+     *
+     * @param hash    对象哈希（40 位十六进制字符串）。
+     * @param content 完整对象内容（含 "type size\0" 头部）。
+     * @return 写入成功返回 true，内容头部无效或写入失败返回 false。
+     */
+    bool add_stored(const std::string& hash, const std::string& content);
+
+    /**
+     * @brief 追加一个 delta 条目。
+     *
+     * 基准已写入本包时以偏移距离引用（kOfsDelta），否则以 ID 引用（kRefDelta）。
+     *
+     * @param hash       目标对象哈希。
+     * @param base_hash  基准对象哈希。
+     * @param delta_size delta 指令解压后的字节数。
+     * @param data       delta 指令的 zlib 压缩数据起始地址。
+     * @param size       压缩数据长度。
+     * @return 写入成功返回 true，否则返回 false。
+     */
+    bool add_delta(const std::string& hash, const std::string& base_hash,
+                   std::uint64_t delta_size, const char* data, std::size_t size);
+
+    /**
+     * @brief 原样复制另一个 MPK2 包中的条目，不解压也不重新压缩。
+     *
+     * delta 条目的基准必须已写入本包，重新按偏移距离引用。新条目头部与原条目
+     * 逐字节相同时直接沿用原条目的 CRC32，不再重新计算。
+     *
+     * @param hash      对象哈希。
+     * @param entry     原包中的条目视图，不能是 kLegacy 条目。
+     * @param base_hash delta 条目的基准哈希，完整对象忽略。
+     * @param crc       原条目的 CRC32，调用方应已校验。
+     * @return 写入成功返回 true；基准不在本包中或写入失败返回 false。
+     */
+    bool copy_entry(const std::string& hash, const PackEntryView& entry,
+                    const std::string& base_hash, std::uint32_t crc);
+
+    /**
+     * @brief 判断对象是否已写入本包。
+     *
+     * @param hash 对象哈希。
+     * @return 已写入返回 true。
+     */
+    bool contains(const std::string& hash) const;
+
+    /**
+     * @brief 逐个比较已写入的对象，查找以给定十六进制前缀开头的对象。
+     *
+     * @param prefix  小写十六进制前缀。
+     * @param limit   最多收集的匹配数。
+     * @param matches 输出参数，匹配的完整哈希追加到末尾，顺序不确定。
+     */
+    void find_prefix(const std::string& prefix, std::size_t limit,
+                     std::vector<std::string>& matches) const;
+
+    /**
+     * @brief 从临时包文件读回并解压一个已写入的完整对象。
+     *
+     * @param hash     对象哈希。
+     * @param inflated 输出参数，完整对象内容（含头部）。
+     * @return 读取成功返回 true；对象不在本包中、以 delta 形式写入或读取失败返回 false。
+     */
+    bool read_object(const std::string& hash, std::string& inflated) const;
+
+    /**
+     * @brief 完成写入，以整包 SHA-1 校验和命名为 objects/pack/pack-<sha1>.mpk。
+     *
+     * 同名的 .idx 索引先于包文件落盘，因此包文件一旦可见即可被索引查找。
+     * 内容不同的包不会同名；同名包已存在时内容必然相同，直接丢弃临时文件，
+     * 不替换正在被其他进程读取的包与索引。
+     *
+     * @param out_relative_path 输出参数，相对于仓库根目录的包文件路径。
+     * @return 成功返回 true；没有任何对象或写入失败时返回 false 并删除临时文件。
+     */
+    bool finish(std::string& out_relative_path);
+
+    /**
+     * @brief 完成写入并改名到指定的相对路径，索引写在同目录的同名 .idx。
+     *
+     * 目标路径已存在时不覆盖：.idx 不记录包的校验和，替换期间新索引可能与旧包内容错配。
+     *
+     * @param relative_path 以 ".mpk" 结尾的目标相对路径。
+     * @return 成功返回 true；没有任何对象、目标已存在或写入失败时返回 false 并删除临时文件。
+     */
+    bool finish_as(const std::string& relative_path);
+
+    /**
+     * @brief 放弃写入并删除临时文件。
+     */
+    void abort();
+
+    /**
+     * @brief 返回已写入的对象数量。
+     */
+    std::size_t object_count() const;
+
+private:
+    struct Entry {
+        std::uint64_t offset;
+        std::uint64_t length;
+        /// 条目头部的字节数，压缩数据从 offset + header 开始。
+        std::uint32_t header;
+        std::uint32_t crc;
+        PackEntryType type;
+    };
+
+    bool append(const char* data, std::size_t size);
+    bool seal(unsigned char trailer[20]);
+    bool publish(const std::string& relative_path, const unsigned char trailer[20]);
+    bool add_entry(const std::string& hash, const std::string& head, const char* data,
+                   std::size_t size, PackEntryType type,
+                   const std::uint32_t* known_crc = nullptr);
+
+    const FileSystem* fs_;
+    std::string tmp_path_;
+    int fd_;
+    std::uint64_t offset_;
+    std::uint32_t header_count_;
+    Sha1 sha_;
+    std::vector<std::string> order_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+/**
+ * @brief 包文件中单个条目的只读视图，指针指向 PackReader 的映射区域。
+ */
+struct PackEntryView {
+    /// 条目类型，MPK1 条目为 kLegacy。
+    PackEntryType type;
+    /// MPK2 条目头部记录的长度：完整对象为内容字节数，delta 为指令字节数；MPK1 为 0。
+    std::uint64_t object_size;
+    /// MPK1 条目中的 40 位十六进制对象哈希（不以 '\0' 结尾），MPK2 条目为 nullptr。
+    const char* hash;
+    /// kOfsDelta 条目的基准条目偏移。
+    std::uint64_t base_offset;
+    /// kRefDelta 条目的基准 20 字节二进制 ID，其他条目为 nullptr。
+    const unsigned char* base_id;
+    /// 对象的 zlib 压缩数据；kStored 条目为未压缩的完整对象内容。
+    const char* data;
+    /// data 的长度（字节）。
+    std::size_t size;
+    /// 条目在包文件中的起始偏移。
+    std::uint64_t offset;
+    /// 下一个条目的起始偏移。
+    std::uint64_t next;
+};
+
+/**
+ * @brief 以 mmap 方式只读访问包文件，支持 MPK1 与 MPK2 两种格式。
+ *
+ * 映射在对象生命周期内保持有效，读取条目不复制压缩数据，只在需要时解压。
+ * 默认按随机访问提示内核；顺序扫描整个包（校验、重新打包）前应切换为顺序访问，
+ * 以便内核积极预读并及时回收已读页面。
+ */
+class PackReader {
+public:
+    /// 访问模式，对应 madvise 的 MADV_RANDOM 与 MADV_SEQUENTIAL。
+    enum class Access { kRandom, kSequential };
+
+    PackReader();
+
+    /**
+     * @brief 解除映射。
+     */
+    ~PackReader();
+
+    PackReader(const PackReader&) = delete;
+    PackReader& operator=(const PackReader&) = delete;
+
+    /**
+     * @brief 映射包文件并校验包头。
+     *
+     * @param path   包文件完整路径。
+     * @param access 初始访问模式。
+     * @return 文件存在且包头合法时返回 true，否则返回 false。
+     */
+    bool open(const std::string& path, Access access = Access::kRandom);
+
+    /**
+     * @brief 调整映射区域的访问模式提示。
+     */
+    void advise(Access access);
+
+    /**
+     * @brief 提示内核预读 [begin, end) 范围内的映射页面（MADV_WILLNEED）。
+     *
+     * 用于按偏移顺序批量读取前提前发起 I/O，范围超出文件时截断。
+     *
+     * @param begin 起始偏移。
+     * @param end   结束偏移（不含）。
+     */
+    void prefetch(std::uint64_t begin, std::uint64_t end) const;
+
+    /**
+     * @brief 返回包头中记录的对象数量。
+     */
+    std::uint32_t count() const;
+
+    /**
+     * @brief 返回包格式版本：1 表示 MPK1，2 表示 MPK2。
+     */
+    int version() const;
+
+    /**
+     * @brief 返回第一个条目的偏移，用于顺序遍历。
+     */
+    std::uint64_t first_offset() const;
+
+    /**
+     * @brief 解析给定偏移处的条目。
+     *
+     * @param offset 条目起始偏移。
+     * @param out    输出参数，条目视图。
+     * @return 偏移处存在完整条目时返回 true，越界或截断时返回 false。
+     */
+    bool entry_at(std::uint64_t offset, PackEntryView& out) const;
+
+    /**
+     * @brief 解压条目的压缩数据。
+     *
+     * 完整对象得到含 "type size\0" 头部的对象内容（kStored 条目直接复制）；MPK2 的
+     * delta 条目得到 delta 指令，MPK1 的 delta 条目得到 "delta <size>\0<基准哈希><指令>"。
+     *
+     * @param entry    条目视图。
+     * @param inflated 输出参数，复用其已有容量。
+     * @param inflater 可复用的解压器，为空时临时初始化一个。
+     * @return 解压成功返回 true。
+     */
+    bool inflate(const PackEntryView& entry, std::string& inflated,
+                 ZlibInflater* inflater = nullptr) const;
+
+    /**
+     * @brief 计算条目全部字节（头部与压缩数据）的 CRC32，与 .idx 中记录的值对应。
+     *
+     * @param entry 由本对象 entry_at 得到的条目视图。
+     */
+    std::uint32_t entry_crc(const PackEntryView& entry) const;
+
+    /**
+     * @brief 校验包文件末尾的 SHA-1 校验和。
+     *
+     * 顺序读取整个映射区域，调用前宜切换为顺序访问模式。
+     *
+     * @return 校验和存在且与内容一致时返回 true。
+     */
+    bool verify_checksum() const;
+
+    /**
+     * @brief 返回包文件末尾 20 字节 SHA-1 校验和的地址，用于把索引、位图等与包绑定。
+     *
+     * @return MPK2 包文件长度足以容纳校验和时返回其地址；MPK1 没有校验和，返回 nullptr。
+     */
+    const unsigned char* checksum() const;
+
+    /**
+     * @brief 返回标识包内容的 20 字节 SHA-1，用于把反向索引与包绑定。
+     *
+     * MPK2 即末尾的校验和；MPK1 没有校验和，首次调用时计算整个文件的 SHA-1 并缓存，
+     * 因此不能在多个线程中同时首次调用。
+     *
+     * @return 包已打开时返回其地址，否则返回 nullptr。
+     */
+    const unsigned char* content_id() const;
+
+    /**
+     * @brief 返回包文件的总长度（字节）。
+     */
+    std::size_t size() const;
+
+private:
+    const char* data_;
+    std::size_t size_;
+    std::uint32_t count_;
+    int version_;
+    /// MPK1 包的整文件 SHA-1，content_id 首次调用时计算。
+    mutable unsigned char legacy_id_[20];
+    mutable bool legacy_id_ready_;
+};
+
+/**
+ * @brief 仓库中所有包文件的集合视图。
+ *
+ * 懒加载 objects/pack 下的全部 .mpk 文件，并在查找未命中且目录发生变化时
+ * 重新扫描，使长驻进程可以看到其他进程新生成的包。每个包同时映射 .idx
+ * 索引与包文件本身，压缩数据直接指向映射区域；缺少索引的旧包会在首次加载时
+ * 补建索引。存在多包索引时先在其中做一次二分查找，只有多包索引之后新增的包
+ * 才需要逐个查找各自的 .idx。
+ */
+class PackSet {
+public:
+    /**
+     * @brief 使用仓库根目录构造包集合，此时不会读取任何文件。
+     *
+     * @param root 仓库根目录路径，例如 ".minigit"。
+     */
+    explicit PackSet(const std::string& root);
+
+    /**
+     * @brief 查找对象所在的包条目。
+     *
+     * MPK2 完整对象的类型与长度可直接从条目头部得到，无需解压；
+     * 条目中的指针指向包文件映射，在 PackSet 生命周期内有效。
+     *
+     * @param hash  对象哈希。
+     * @param entry 输出参数，条目视图。
+     * @return 找到返回 true，否则返回 false。
+     */
+    bool find_entry(const std::string& hash, PackEntryView& entry);
+
+    /**
+     * @brief 读取对象的完整内容（含 "type size\0" 头部），透明地解析 delta 链。
+     *
+     * @param hash     对象哈希。
+     * @param inflated 输出参数，复用其已有容量。
+     * @return 对象存在且 delta 链完整时返回 true，否则返回 false。
+     */
+    bool read_object(const std::string& hash, std::string& inflated);
+
+    /**
+     * @brief 读取对象的完整内容，kStored 条目不复制，直接返回映射区域中的数据。
+     *
+     * 包文件被删除后 refresh 会从集合中移除该包，映射只在仍有持有者时保留；
+     * 指向映射区域的数据在 owner 释放前有效。
+     *
+     * @param hash     对象哈希。
+     * @param inflated 非 kStored 条目重建结果的输出缓冲区，复用其已有容量。
+     * @param data     输出参数，完整内容（含头部）的起始地址，指向映射区域或 inflated。
+     * @param size     输出参数，完整内容的字节数。
+     * @param owner    输出参数，data 指向映射区域时为所在包的共享所有权，否则被置空。
+     * @return 对象存在且 delta 链完整时返回 true，否则返回 false。
+     */
+    bool read_object_view(const std::string& hash, std::string& inflated, const char*& data,
+                          std::size_t& size, std::shared_ptr<const void>& owner);
+
+    /**
+     * @brief 读取指定包中给定偏移处条目对应的完整对象，透明地解析 delta 链。
+     *
+     * 与 read_object 不同，不经过索引查找，因此读到的一定是该包中的副本，
+     * 用于逐包校验对象。
+     *
+     * @param pack_name 包文件名，形如 "pack-xxx.mpk"。
+     * @param offset    条目在包文件中的起始偏移。
+     * @param inflated  输出参数，完整对象内容（含头部）。
+     * @return 包已加载且对象可以重建时返回 true，否则返回 false。
+     */
+    bool read_packed_at(const std::string& pack_name, std::uint64_t offset,
+                        std::string& inflated);
+
+    /**
+     * @brief 查找对象所在的包与条目偏移，不解析条目内容。
+     *
+     * 批量读取据此按 "包 + 偏移" 排序请求，再通过 read_packed_at 逐个读取。
+     *
+     * @param hash      对象哈希。
+     * @param pack_name 输出参数，包文件名，形如 "pack-xxx.mpk"。
+     * @param offset    输出参数，条目在包文件中的起始偏移。
+     * @return 找到返回 true，否则返回 false。
+     */
+    bool locate_object(const std::string& hash, std::string& pack_name,
+                       std::uint64_t& offset);
+
+    /**
+     * @brief 提示内核预读指定包中从 first 处条目到 last 处条目末尾的数据。
+     *
+     * @param pack_name 包文件名。
+     * @param first     第一个条目的偏移。
+     * @param last      最后一个条目的偏移，不小于 first。
+     */
+    void prefetch(const std::string& pack_name, std::uint64_t first, std::uint64_t last);
+
+    /**
+     * @brief 设置 delta 基准缓存的容量。
+     *
+     * 缓存以 "包 + 条目偏移" 为键保存解析 delta 链时重建出的基准对象，
+     * 按对象字节数计量，默认 32MB；0 表示禁用并清空缓存。
+     *
+     * @param bytes 缓存容量（字节）。
+     */
+    void set_base_cache_limit(std::size_t bytes);
+
+    /**
+     * @brief 返回 delta 基准缓存的累计命中次数。
+     */
+    std::uint64_t base_cache_hits() const;
+
+    /**
+     * @brief 返回 delta 基准缓存的累计未命中次数。
+     */
+    std::uint64_t base_cache_misses() const;
+
+    /**
+     * @brief 返回 delta 基准缓存当前的容量（字节）。
+     */
+    std::size_t base_cache_limit() const;
+
+    /**
+     * @brief 判断对象是否存在于任一包中。
+     *
+     * @param hash 对象哈希。
+     * @return 存在返回 true。
+     */
+    bool contains(const std::string& hash);
+
+    /**
+     * @brief 在多包索引与未被其覆盖的各包索引中查找以给定前缀开头的对象。
+     *
+     * 查找前检查包目录是否变化，使新生成的包也参与匹配。
+     *
+     * @param prefix  小写十六进制前缀，长度 2 到 40。
+     * @param limit   每个索引最多收集的匹配数。
+     * @param matches 输出参数，匹配的完整哈希追加到末尾，可能包含重复项。
+     */
+    void find_prefix(const std::string& prefix, std::size_t limit,
+                     std::vector<std::string>& matches);
+
+    /**
+     * @brief 返回各包中除 hash 自身外与其共同十六进制前缀最长的对象的前缀长度。
+     *
+     * 在多包索引与未被其覆盖的各包索引中只比较与 hash 相邻的 ID，
+     * 查找前检查包目录是否变化。
+     *
+     * @param hash 对象哈希（40 位十六进制字符串）。
+     * @return 共同前缀的十六进制字符数，没有首字节相同的对象时返回 0。
+     */
+    std::size_t common_prefix_length(const std::string& hash);
+
+private:
+    struct Pack {
+        /// 包文件名，形如 "pack-xxx.mpk"。
+        std::string name;
+        PackIndex index;
+        PackReader reader;
+        /// 是否已被多包索引覆盖，覆盖的包不再单独查找。
+        bool in_midx = false;
+    };
+
+    struct DeltaBaseKey {
+        std::size_t pack;
+        std::uint64_t offset;
+
+        bool operator==(const DeltaBaseKey& other) const {
+            return pack == other.pack && offset == other.offset;
+        }
+    };
+
+    struct DeltaBaseKeyHash {
+        std::size_t operator()(const DeltaBaseKey& key) const {
+            return std::hash<std::uint64_t>()(key.offset * 31U + key.pack);
+        }
+    };
+
+    /// 解析 delta 时允许的最大链长，防止损坏的包形成环。
+    static const std::size_t kMaxDeltaDepth = 4096;
+    /// delta 基准缓存的默认容量。
+    static const std::size_t kDefaultBaseCacheBytes = 32U * 1024U * 1024U;
+
+    /// midx_packs_ 中表示多包索引列出的包未能加载。
+    static const std::size_t kNoPack = static_cast<std::size_t>(-1);
+
+    bool find_in_packs(const std::string& hash, std::size_t& pack,
+                       std::uint64_t& offset) const;
+    bool locate(const std::string& hash, DeltaBaseKey& key, PackEntryView& entry);
+    bool resolve(DeltaBaseKey key, PackEntryView entry, std::string& inflated);
+    bool refresh();
+
+    FileSystem fs_;
+    std::int64_t dir_mtime_sec_;
+    std::int64_t dir_mtime_nsec_;
+    std::map<std::string, std::size_t> loaded_;
+    /// 共享所有权，使 read_object_view 返回的映射在包被移出集合后仍可由持有者使用。
+    std::vector<std::shared_ptr<Pack> > packs_;
+    MultiPackIndex midx_;
+    std::vector<std::size_t> midx_packs_;
+    LruCache<DeltaBaseKey, std::shared_ptr<const std::string>, DeltaBaseKeyHash> base_cache_;
+    std::string scratch_;
+    ZlibInflater inflater_;
+};
+
 }  // namespace minigit
 
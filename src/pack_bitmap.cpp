@@ -0,0 +1,420 @@
+#include "pack_bitmap.h"
+
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+
+#include <dirent.h>
+
+#include "commit.h"
+#include "hash.h"
+#include "pack.h"
+#include "tree.h"
+
+// 本文件实现可达性位图的生成、读取与查询
+namespace {
+
+const char kBitmapMagic[4] = {'M', 'B', 'M', '1'};
+const std::size_t kTrailerSize = 20U;
+// 类型位图的存放顺序
+const int kTypeCount = 3;
+const minigit::ObjectType kBitmapTypes[kTypeCount] = {
+    minigit::ObjectType::kCommit, minigit::ObjectType::kTree, minigit::ObjectType::kBlob};
+
+void put_u32_be(std::string& out, std::uint32_t v) {
+    out.push_back(static_cast<char>((v >> 24) & 0xff));
+    out.push_back(static_cast<char>((v >> 16) & 0xff));
+    out.push_back(static_cast<char>((v >> 8) & 0xff));
+    out.push_back(static_cast<char>(v & 0xff));
+}
+
+std::uint32_t get_u32_be(const char* data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+           (static_cast<std::uint32_t>(p[2]) << 8) | static_cast<std::uint32_t>(p[3]);
+}
+
+int type_slot(minigit::ObjectType type) {
+    for (int i = 0; i < kTypeCount; ++i) {
+        if (kBitmapTypes[i] == type) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// tree 条目中子目录的模式，兼容省略与保留前导 0 两种写法
+bool is_tree_mode(const std::string& mode) {
+    return mode == "40000" || mode == "040000";
+}
+
+// 子模块条目指向其他仓库的提交，不属于本仓库的可达对象
+bool is_gitlink_mode(const std::string& mode) {
+    return mode == "160000";
+}
+
+// 查询提交是否已有位图；有则把位图并入 out 并返回 true
+typedef std::function<bool(const std::string&, minigit::Bitmap&)> KnownBitmap;
+
+// 从 tip 出发遍历提交与 tree，把可达对象在包内的位置写入 out。
+// out 中已置位的提交与 tree 视为其可达对象已经全部在 out 中，不再深入；
+// 遇到已有位图的提交时直接并入其位图。任何可达对象不在包中时返回 false
+bool walk_into_bitmap(minigit::ObjectStore& store, const minigit::PackIndex& index,
+                      const std::string& tip, const KnownBitmap& known,
+                      minigit::Bitmap& out) {
+    minigit::ReadContext ctx;
+    minigit::Commit commit;
+    std::vector<minigit::TreeEntry> entries;
+    std::vector<std::string> commits(1, tip);
+    std::vector<std::string> trees;
+    while (!commits.empty()) {
+        std::string hash;
+        hash.swap(commits.back());
+        commits.pop_back();
+        std::size_t pos = 0;
+        if (!index.position_of(hash, pos)) {
+            return false;
+        }
+        if (out.get(pos) || known(hash, out)) {
+            continue;
+        }
+        out.set(pos);
+        if (!minigit::read_commit(store, hash, ctx, commit)) {
+            return false;
+        }
+        commits.insert(commits.end(), commit.parents.begin(), commit.parents.end());
+        trees.push_back(commit.tree);
+        while (!trees.empty()) {
+            std::string tree;
+            tree.swap(trees.back());
+            trees.pop_back();
+            if (!index.position_of(tree, pos)) {
+                return false;
+            }
+            if (out.get(pos)) {
+                continue;
+            }
+            out.set(pos);
+            if (!minigit::read_tree(store, tree, ctx, entries)) {
+                return false;
+            }
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (is_gitlink_mode(entries[i].mode)) {
+                    continue;
+                }
+                if (is_tree_mode(entries[i].mode)) {
+                    trees.push_back(entries[i].hash);
+                } else if (index.position_of(entries[i].hash, pos)) {
+                    out.set(pos);
+                } else {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// 后序遍历得到包内提交的拓扑顺序（祖先在前），不在包中的提交不再深入
+void topo_order_commits(minigit::ObjectStore& store, const minigit::PackIndex& index,
+                        const std::vector<std::string>& tips, std::vector<std::string>& order) {
+    minigit::ReadContext ctx;
+    minigit::Commit commit;
+    std::unordered_set<std::string> visited;
+    // 栈元素为 (提交, 是否已展开父提交)
+    std::vector<std::pair<std::string, bool> > stack;
+    for (std::size_t i = tips.size(); i-- > 0;) {
+        stack.push_back(std::make_pair(tips[i], false));
+    }
+    while (!stack.empty()) {
+        std::pair<std::string, bool> top = stack.back();
+        stack.pop_back();
+        if (top.second) {
+            order.push_back(top.first);
+            continue;
+        }
+        std::size_t pos = 0;
+        if (visited.count(top.first) || !index.position_of(top.first, pos) ||
+            !minigit::read_commit(store, top.first, ctx, commit)) {
+            continue;
+        }
+        visited.insert(top.first);
+        stack.push_back(std::make_pair(top.first, true));
+        for (std::size_t p = commit.parents.size(); p-- > 0;) {
+            if (!visited.count(commit.parents[p])) {
+                stack.push_back(std::make_pair(commit.parents[p], false));
+            }
+        }
+    }
+}
+
+}  // namespace
+
+namespace minigit {
+
+// 先按对象头部生成类型位图，再按拓扑顺序为选中的提交生成可达性位图，
+// 每个位图复用已生成的祖先位图
+bool write_pack_bitmap(ObjectStore& store, const FileSystem& fs,
+                       const std::string& pack_relative_path,
+                       const std::vector<std::string>& tips, std::size_t& written) {
+    written = 0;
+    PackIndex index;
+    PackReader reader;
+    if (!index.open(fs.make_path(pack_sibling_path(pack_relative_path, ".idx"))) ||
+        !reader.open(fs.make_path(pack_relative_path)) || !reader.checksum()) {
+        return false;
+    }
+
+    Bitmap types[kTypeCount];
+    ReadContext ctx;
+    for (std::size_t i = 0; i < index.count(); ++i) {
+        ObjectType type = ObjectType::kNone;
+        std::size_t size = 0;
+        if (!store.read_object_info(index.hash_at(i), ctx, type, size)) {
+            return false;
+        }
+        int slot = type_slot(type);
+        if (slot >= 0) {
+            types[slot].set(i);
+        }
+    }
+
+    std::vector<std::string> order;
+    topo_order_commits(store, index, tips, order);
+    std::unordered_set<std::string> selected(tips.begin(), tips.end());
+    for (std::size_t i = kBitmapCommitInterval - 1U; i < order.size();
+         i += kBitmapCommitInterval) {
+        selected.insert(order[i]);
+    }
+    std::unordered_map<std::string, Bitmap> built;
+    KnownBitmap known = [&built](const std::string& hash, Bitmap& out) {
+        std::unordered_map<std::string, Bitmap>::const_iterator it = built.find(hash);
+        if (it == built.end()) {
+            return false;
+        }
+        out.or_with(it->second);
+        return true;
+    };
+    std::vector<std::string> commits;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (!selected.count(order[i])) {
+            continue;
+        }
+        Bitmap reach;
+        if (walk_into_bitmap(store, index, order[i], known, reach)) {
+            built[order[i]].words().swap(reach.words());
+            commits.push_back(order[i]);
+        }
+    }
+
+    std::string out(kBitmapMagic, sizeof(kBitmapMagic));
+    out.append(reinterpret_cast<const char*>(reader.checksum()), 20U);
+    put_u32_be(out, static_cast<std::uint32_t>(index.count()));
+    for (int t = 0; t < kTypeCount; ++t) {
+        ewah_encode(types[t], out);
+    }
+    put_u32_be(out, static_cast<std::uint32_t>(commits.size()));
+    for (std::size_t i = 0; i < commits.size(); ++i) {
+        unsigned char raw[20];
+        hex_to_raw(commits[i], raw);
+        out.append(reinterpret_cast<const char*>(raw), sizeof(raw));
+        ewah_encode(built[commits[i]], out);
+    }
+    Sha1 sha;
+    sha.update(out.data(), out.size());
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    out.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+    if (!write_file_atomically(fs.make_path(pack_sibling_path(pack_relative_path, ".bitmap")),
+                               out)) {
+        return false;
+    }
+    written = commits.size();
+    return true;
+}
+
+PackBitmapIndex::PackBitmapIndex() {}
+
+// 读入位图文件，校验尾部校验和、所属包的校验和与对象数，并解码类型位图
+bool PackBitmapIndex::open(const FileSystem& fs, const std::string& pack_relative_path) {
+    index_.close();
+    data_.clear();
+    commits_.clear();
+    PackReader reader;
+    std::string data;
+    if (!index_.open(fs.make_path(pack_sibling_path(pack_relative_path, ".idx"))) ||
+        !reader.open(fs.make_path(pack_relative_path)) || !reader.checksum() ||
+        !fs.read_file(pack_sibling_path(pack_relative_path, ".bitmap"), data) ||
+        data.size() < 4U + 20U + 4U + kTrailerSize) {
+        index_.close();
+        return false;
+    }
+    std::size_t body = data.size() - kTrailerSize;
+    Sha1 sha;
+    sha.update(data.data(), body);
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    bool ok = std::memcmp(data.data(), kBitmapMagic, sizeof(kBitmapMagic)) == 0 &&
+              std::memcmp(data.data() + 4, reader.checksum(), 20U) == 0 &&
+              get_u32_be(data.data() + 24) == index_.count() &&
+              std::memcmp(digest, data.data() + body, 20U) == 0;
+    std::size_t pos = 28U;
+    for (int t = 0; ok && t < kTypeCount; ++t) {
+        std::size_t used = 0;
+        ok = ewah_decode(data.data() + pos, body - pos, types_[t], used);
+        pos += used;
+    }
+    ok = ok && body - pos >= 4U;
+    std::size_t count = ok ? get_u32_be(data.data() + pos) : 0;
+    pos += 4U;
+    for (std::size_t i = 0; ok && i < count; ++i) {
+        Bitmap skip;
+        std::size_t used = 0;
+        ok = body - pos > 20U &&
+             ewah_decode(data.data() + pos + 20U, body - pos - 20U, skip, used);
+        if (ok) {
+            commits_[raw_to_hex(reinterpret_cast<const unsigned char*>(data.data() + pos))] =
+                pos + 20U;
+            pos += 20U + used;
+        }
+    }
+    if (!ok || pos != body) {
+        index_.close();
+        commits_.clear();
+        return false;
+    }
+    data_.swap(data);
+    return true;
+}
+
+// 依次尝试目录中的每个包，返回第一个位图可用的包
+bool PackBitmapIndex::open_any(const FileSystem& fs) {
+    DIR* d = opendir(fs.make_path("objects/pack").c_str());
+    if (!d) {
+        return false;
+    }
+    std::vector<std::string> names;
+    dirent* de;
+    while ((de = readdir(d)) != nullptr) {
+        std::string name = de->d_name;
+        if (name.size() > 7 && name.compare(name.size() - 7, 7, ".bitmap") == 0) {
+            names.push_back(name.substr(0, name.size() - 7) + ".mpk");
+        }
+    }
+    closedir(d);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (open(fs, "objects/pack/" + names[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PackBitmapIndex::commit_bitmap(const std::string& hash, Bitmap& out) {
+    std::unordered_map<std::string, std::size_t>::const_iterator it = commits_.find(hash);
+    std::size_t used = 0;
+    return it != commits_.end() &&
+           ewah_decode(data_.data() + it->second, data_.size() - it->second, out, used);
+}
+
+// 有位图的起点直接取其位图，其余起点遍历到有位图的祖先为止
+bool PackBitmapIndex::reachable(ObjectStore& store, const std::vector<std::string>& tips,
+                                Bitmap& out) {
+    out.clear();
+    if (data_.empty()) {
+        return false;
+    }
+    KnownBitmap known = [this](const std::string& hash, Bitmap& into) {
+        Bitmap found;
+        if (!commit_bitmap(hash, found)) {
+            return false;
+        }
+        into.or_with(found);
+        return true;
+    };
+    for (std::size_t i = 0; i < tips.size(); ++i) {
+        if (!walk_into_bitmap(store, index_, tips[i], known, out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const Bitmap& PackBitmapIndex::type_bitmap(ObjectType type) const {
+    int slot = type_slot(type);
+    return slot < 0 ? empty_ : types_[slot];
+}
+
+std::string PackBitmapIndex::hash_at(std::size_t pos) const {
+    return index_.hash_at(pos);
+}
+
+std::size_t PackBitmapIndex::object_count() const {
+    return index_.count();
+}
+
+std::size_t PackBitmapIndex::bitmap_count() const {
+    return commits_.size();
+}
+
+// 先把 exclude 可达的对象全部标记为已见，再从 include 出发只输出未见过的对象
+bool list_reachable_objects(ObjectStore& store, const std::vector<std::string>& include,
+                            const std::vector<std::string>& exclude, bool with_objects,
+                            std::vector<std::string>& out) {
+    out.clear();
+    std::unordered_set<std::string> seen;
+    ReadContext ctx;
+    Commit commit;
+    std::vector<TreeEntry> entries;
+    for (int pass = 0; pass < 2; ++pass) {
+        const std::vector<std::string>& tips = pass == 0 ? exclude : include;
+        std::vector<std::string>* emit = pass == 0 ? nullptr : &out;
+        std::vector<std::string> commits(tips);
+        std::vector<std::string> trees;
+        while (!commits.empty()) {
+            std::string hash;
+            hash.swap(commits.back());
+            commits.pop_back();
+            if (!seen.insert(hash).second) {
+                continue;
+            }
+            if (!read_commit(store, hash, ctx, commit)) {
+                return false;
+            }
+            if (emit) {
+                emit->push_back(hash);
+            }
+            commits.insert(commits.end(), commit.parents.begin(), commit.parents.end());
+            if (with_objects) {
+                trees.push_back(commit.tree);
+            }
+        }
+        while (!trees.empty()) {
+            std::string tree;
+            tree.swap(trees.back());
+            trees.pop_back();
+            if (!seen.insert(tree).second) {
+                continue;
+            }
+            if (!read_tree(store, tree, ctx, entries)) {
+                return false;
+            }
+            if (emit) {
+                emit->push_back(tree);
+            }
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (is_gitlink_mode(entries[i].mode)) {
+                    continue;
+                }
+                if (is_tree_mode(entries[i].mode)) {
+                    trees.push_back(entries[i].hash);
+                } else if (seen.insert(entries[i].hash).second && emit) {
+                    emit->push_back(entries[i].hash);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace minigit
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ewah.h"
+#include "filesystem.h"
+#include "object_store.h"
+#include "pack_index.h"
+
+// 本文件声明包文件的可达性位图（.bitmap）及基于位图的对象枚举
+namespace minigit {
+
+/// 按拓扑顺序每隔多少个提交选取一个提交写入位图。
+const std::size_t kBitmapCommitInterval = 100;
+
+/**
+ * @brief 为一个包写出可达性位图文件（与包同名的 .bitmap）。
+ *
+ * 位图的第 i 位对应 .idx 中按 ID 排序的第 i 个对象。选中的提交包括 tips
+ * 中的每个提交，以及按拓扑顺序（祖先在前）每隔 kBitmapCommitInterval 个提交
+ * 取一个；每个选中提交的位图记录从它出发可达的全部对象，计算时遇到已有位图的
+ * 祖先直接按位或合并，不再重复遍历。可达对象不全在该包中的提交不写位图。
+ *
+ * 文件格式（整数均为大端序）：
+ *   "MBM1" + 20 字节包校验和 + u32 包内对象数
+ *   + commit、tree、blob 三个类型位图（EWAH 编码）
+ *   + u32 提交位图数量 + N 组 "20 字节提交 ID + EWAH 位图"
+ *   + 20 字节 SHA-1（覆盖之前的全部内容）。
+ *
+ * @param store   用于读取提交与 tree 的对象存储。
+ * @param fs      仓库根目录对应的文件系统对象。
+ * @param pack_relative_path 以 ".mpk" 结尾的包文件相对路径，需已有 .idx。
+ * @param tips    需要位图的提交（通常为全部 ref 指向的提交）。
+ * @param written 输出参数，实际写入的提交位图数量。
+ * @return 位图文件写入成功返回 true；包或索引无法读取、包内对象无法读取
+ *         或写入失败时返回 false。
+ */
+bool write_pack_bitmap(ObjectStore& store, const FileSystem& fs,
+                       const std::string& pack_relative_path,
+                       const std::vector<std::string>& tips, std::size_t& written);
+
+/**
+ * @brief 一个包的可达性位图，支持以位运算回答可达性查询。
+ *
+ * 打开时读入位图文件并校验校验和与所属的包，提交位图在首次使用时才解码。
+ * 查询的提交没有位图时，从它出发遍历到有位图的祖先为止，只需读取
+ * 最近若干个提交及其 tree。
+ */
+class PackBitmapIndex {
+public:
+    PackBitmapIndex();
+
+    PackBitmapIndex(const PackBitmapIndex&) = delete;
+    PackBitmapIndex& operator=(const PackBitmapIndex&) = delete;
+
+    /**
+     * @brief 打开指定包的位图文件。
+     *
+     * @param fs                 仓库根目录对应的文件系统对象。
+     * @param pack_relative_path 以 ".mpk" 结尾的包文件相对路径。
+     * @return 包、索引与位图文件都存在且相互匹配时返回 true。
+     */
+    bool open(const FileSystem& fs, const std::string& pack_relative_path);
+
+    /**
+     * @brief 打开 objects/pack 下第一个带有可用位图的包。
+     *
+     * @param fs 仓库根目录对应的文件系统对象。
+     * @return 找到可用位图返回 true，否则返回 false。
+     */
+    bool open_any(const FileSystem& fs);
+
+    /**
+     * @brief 计算从 tips 出发可达的全部对象。
+     *
+     * @param store 用于读取没有位图的提交及其 tree 的对象存储。
+     * @param tips  起点提交列表。
+     * @param out   输出参数，可达对象在包内的位置集合。
+     * @return 成功返回 true；可达对象不全在该包中或对象无法读取时返回 false，
+     *         调用方应退回到逐个对象遍历。
+     */
+    bool reachable(ObjectStore& store, const std::vector<std::string>& tips, Bitmap& out);
+
+    /**
+     * @brief 返回包内给定类型对象的位置集合。
+     *
+     * @param type 对象类型，kNone 返回空位图。
+     */
+    const Bitmap& type_bitmap(ObjectType type) const;
+
+    /**
+     * @brief 返回第 pos 位对应对象的十六进制哈希。
+     */
+    std::string hash_at(std::size_t pos) const;
+
+    /**
+     * @brief 返回包内对象数量，即位图的有效位数。
+     */
+    std::size_t object_count() const;
+
+    /**
+     * @brief 返回位图文件中提交位图的数量。
+     */
+    std::size_t bitmap_count() const;
+
+private:
+    bool commit_bitmap(const std::string& hash, Bitmap& out);
+
+    PackIndex index_;
+    std::string data_;
+    Bitmap types_[3];
+    Bitmap empty_;
+    /// 提交哈希到其 EWAH 位图在 data_ 中偏移的映射。
+    std::unordered_map<std::string, std::size_t> commits_;
+};
+
+/**
+ * @brief 不借助位图，遍历提交与 tree 列出可达对象。
+ *
+ * 输出从 include 可达、但从 exclude 不可达的对象：先列出提交（按遍历顺序），
+ * with_objects 为 true 时随后列出 tree 与 blob。用于没有位图或位图无法回答的查询。
+ *
+ * @param store        对象存储。
+ * @param include      起点提交。
+ * @param exclude      排除的提交，其可达对象都不输出。
+ * @param with_objects 是否输出 tree 与 blob。
+ * @param out          输出参数，对象哈希列表。
+ * @return 所有可达对象都能读取时返回 true，否则返回 false。
+ */
+bool list_reachable_objects(ObjectStore& store, const std::vector<std::string>& include,
+                            const std::vector<std::string>& exclude, bool with_objects,
+                            std::vector<std::string>& out);
+
+}  // namespace minigit
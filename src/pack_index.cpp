@@ -0,0 +1,748 @@
+#include "pack_index.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+
+// 本文件实现包索引的写出与基于 mmap 的查找
+namespace {
+
+const char kIndexMagic[4] = {'M', 'I', 'X', '2'};
+const char kLegacyIndexMagic[4] = {'M', 'I', 'X', '1'};
+const char kMultiIndexMagic[4] = {'M', 'M', 'X', '1'};
+const char kReverseMagic[4] = {'M', 'R', 'V', '1'};
+const std::size_t kFanoutOffset = 4U;
+const std::size_t kIdsOffset = kFanoutOffset + 256U * 4U;
+const std::size_t kTrailerSize = 20U;
+// u32 偏移项最高位置 1 时，低 31 位是大偏移表中的序号
+const std::uint32_t kLargeOffsetFlag = 0x80000000U;
+
+void put_u32_be(std::string& out, std::uint32_t v) {
+    out.push_back(static_cast<char>((v >> 24) & 0xff));
+    out.push_back(static_cast<char>((v >> 16) & 0xff));
+    out.push_back(static_cast<char>((v >> 8) & 0xff));
+    out.push_back(static_cast<char>(v & 0xff));
+}
+
+std::uint32_t get_u32_be(const unsigned char* p) {
+    return (static_cast<std::uint32_t>(p[0]) << 24) |
+           (static_cast<std::uint32_t>(p[1]) << 16) |
+           (static_cast<std::uint32_t>(p[2]) << 8) |
+           static_cast<std::uint32_t>(p[3]);
+}
+
+void put_u64_be(std::string& out, std::uint64_t v) {
+    put_u32_be(out, static_cast<std::uint32_t>(v >> 32));
+    put_u32_be(out, static_cast<std::uint32_t>(v & 0xffffffffU));
+}
+
+std::uint64_t get_u64_be(const unsigned char* p) {
+    return (static_cast<std::uint64_t>(get_u32_be(p)) << 32) | get_u32_be(p + 4);
+}
+
+int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// 在扇出表限定的区间内二分查找 20 字节 ID，找到时返回 true 并给出序号
+bool fanout_search(const unsigned char* fanout, const unsigned char* ids,
+                   const unsigned char raw[20], std::size_t& pos) {
+    std::size_t lo = raw[0] == 0 ? 0 : get_u32_be(fanout + (raw[0] - 1U) * 4U);
+    std::size_t hi = get_u32_be(fanout + raw[0] * 4U);
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2U;
+        int cmp = std::memcmp(ids + mid * 20U, raw, 20U);
+        if (cmp == 0) {
+            pos = mid;
+            return true;
+        }
+        if (cmp < 0) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+// 返回两个 20 字节 ID 的十六进制形式相同的前缀长度
+std::size_t raw_common_hex_prefix(const unsigned char* a, const unsigned char* b) {
+    for (std::size_t i = 0; i < 20U; ++i) {
+        if (a[i] != b[i]) {
+            return i * 2U + ((a[i] >> 4) == (b[i] >> 4) ? 1U : 0U);
+        }
+    }
+    return 40U;
+}
+
+// 在扇出表限定的首字节区间内二分查找 raw 的插入位置，有序表中共同前缀最长的 ID
+// 必与插入位置相邻，只需比较两侧不等于 raw 的 ID；区间为空时返回 0
+std::size_t fanout_neighbour_prefix(const unsigned char* fanout, const unsigned char* ids,
+                                    const unsigned char raw[20]) {
+    std::size_t first = raw[0] == 0 ? 0 : get_u32_be(fanout + (raw[0] - 1U) * 4U);
+    std::size_t end = get_u32_be(fanout + raw[0] * 4U);
+    std::size_t lo = first;
+    std::size_t hi = end;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2U;
+        if (std::memcmp(ids + mid * 20U, raw, 20U) < 0) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    std::size_t best = 0;
+    if (lo > first) {
+        best = raw_common_hex_prefix(ids + (lo - 1U) * 20U, raw);
+    }
+    if (lo < end && std::memcmp(ids + lo * 20U, raw, 20U) == 0) {
+        ++lo;
+    }
+    if (lo < end) {
+        best = std::max(best, raw_common_hex_prefix(ids + lo * 20U, raw));
+    }
+    return best;
+}
+
+// 判断 20 字节 ID 的十六进制形式是否以 prefix 开头
+bool raw_has_prefix(const unsigned char* id, const std::string& prefix) {
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        unsigned char byte = id[i / 2U];
+        int nibble = i % 2U == 0 ? byte >> 4 : byte & 0x0f;
+        if (nibble != hex_nibble(prefix[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 将十六进制前缀补零为 20 字节 ID 作为下界，在扇出表给出的区间内二分查找第一个
+// 不小于下界的 ID，再顺序收集仍以前缀开头的 ID
+void fanout_prefix_search(const unsigned char* fanout, const unsigned char* ids,
+                          const std::string& prefix, std::size_t limit,
+                          std::vector<std::string>& matches) {
+    unsigned char low[20] = {0};
+    if (prefix.size() < 2U || prefix.size() > 40U) {
+        return;
+    }
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        int nibble = hex_nibble(prefix[i]);
+        if (nibble < 0) {
+            return;
+        }
+        low[i / 2U] |= static_cast<unsigned char>(i % 2U == 0 ? nibble << 4 : nibble);
+    }
+    std::size_t lo = low[0] == 0 ? 0 : get_u32_be(fanout + (low[0] - 1U) * 4U);
+    std::size_t hi = get_u32_be(fanout + low[0] * 4U);
+    std::size_t end = hi;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2U;
+        if (std::memcmp(ids + mid * 20U, low, 20U) < 0) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    std::size_t found = 0;
+    for (std::size_t i = lo; i < end && found < limit && raw_has_prefix(ids + i * 20U, prefix);
+         ++i, ++found) {
+        matches.push_back(minigit::raw_to_hex(ids + i * 20U));
+    }
+}
+
+// 多包索引中的一个对象
+struct MultiIndexEntry {
+    unsigned char id[20];
+    std::uint32_t pack;
+    std::uint64_t offset;
+};
+
+bool entry_id_less(const MultiIndexEntry& a, const MultiIndexEntry& b) {
+    return std::memcmp(a.id, b.id, 20U) < 0;
+}
+
+}  // namespace
+
+namespace minigit {
+
+const char kMultiPackIndexName[] = "multi-pack-index";
+
+// 先写入同目录的只读临时文件并落盘，再原子改名到目标路径
+bool write_file_atomically(const std::string& path, const std::string& data) {
+    std::string tmp = path;
+    std::size_t slash = tmp.find_last_of('/');
+    tmp.erase(slash == std::string::npos ? 0 : slash + 1);
+    tmp.append("tmp_idx_XXXXXX");
+    int fd = ::mkstemp(&tmp[0]);
+    if (fd < 0) {
+        return false;
+    }
+    ::fchmod(fd, 0444);
+    const char* p = data.data();
+    std::size_t left = data.size();
+    bool ok = true;
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 排序条目后按 "扇出表 + ID + CRC + 偏移 + 大偏移 + 校验和" 的布局写出索引
+bool write_pack_index(const std::string& path, std::vector<PackIndexEntry>& entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const PackIndexEntry& a, const PackIndexEntry& b) {
+                  return a.hash < b.hash;
+              });
+
+    std::string out;
+    out.reserve(kIdsOffset + entries.size() * 28U + kTrailerSize);
+    out.append(kIndexMagic, sizeof(kIndexMagic));
+
+    std::uint32_t fanout[256] = {0};
+    std::string ids;
+    ids.reserve(entries.size() * 20U);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        unsigned char raw[20];
+        if (!hex_to_raw(entries[i].hash, raw)) {
+            return false;
+        }
+        if (i > 0 && entries[i].hash == entries[i - 1].hash) {
+            return false;
+        }
+        ++fanout[raw[0]];
+        ids.append(reinterpret_cast<const char*>(raw), sizeof(raw));
+    }
+    std::uint32_t total = 0;
+    for (int b = 0; b < 256; ++b) {
+        total += fanout[b];
+        put_u32_be(out, total);
+    }
+    out.append(ids);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        put_u32_be(out, entries[i].crc);
+    }
+    std::string large;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].offset < kLargeOffsetFlag) {
+            put_u32_be(out, static_cast<std::uint32_t>(entries[i].offset));
+        } else {
+            put_u32_be(out, kLargeOffsetFlag | static_cast<std::uint32_t>(large.size() / 8U));
+            put_u64_be(large, entries[i].offset);
+        }
+    }
+    out.append(large);
+    Sha1 sha;
+    sha.update(out.data(), out.size());
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    out.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+
+    return write_file_atomically(path, out);
+}
+
+PackIndex::PackIndex() : data_(nullptr), size_(0), count_(0), large_count_(0) {}
+
+PackIndex::~PackIndex() {
+    close();
+}
+
+// 映射索引文件并检查魔数、扇出表与长度是否一致，MIX2 的剩余长度即为大偏移表
+bool PackIndex::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < kIdsOffset + kTrailerSize) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+
+    bool legacy = std::memcmp(data, kLegacyIndexMagic, sizeof(kLegacyIndexMagic)) == 0;
+    bool ok = legacy || std::memcmp(data, kIndexMagic, sizeof(kIndexMagic)) == 0;
+    std::uint32_t prev = 0;
+    for (int b = 0; ok && b < 256; ++b) {
+        std::uint32_t v = get_u32_be(data + kFanoutOffset + b * 4U);
+        ok = v >= prev;
+        prev = v;
+    }
+    std::size_t count = prev;
+    std::size_t fixed = kIdsOffset + count * 28U + kTrailerSize;
+    ok = ok && size >= fixed && (legacy ? size == fixed : (size - fixed) % 8U == 0);
+    if (!ok) {
+        ::munmap(map, size);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    count_ = count;
+    large_count_ = (size - fixed) / 8U;
+    return true;
+}
+
+void PackIndex::close() {
+    if (data_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+    large_count_ = 0;
+}
+
+// 用扇出表定位首字节相同的区间后二分查找，返回对象在索引中的序号
+bool PackIndex::position_of(const std::string& hash, std::size_t& pos) const {
+    unsigned char raw[20];
+    return data_ && hex_to_raw(hash, raw) &&
+           fanout_search(data_ + kFanoutOffset, data_ + kIdsOffset, raw, pos);
+}
+
+// 用扇出表定位首字节相同的区间后二分查找
+bool PackIndex::find(const std::string& hash, std::uint64_t& offset,
+                     std::uint32_t& crc) const {
+    unsigned char raw[20];
+    if (!data_ || !hex_to_raw(hash, raw)) {
+        return false;
+    }
+    std::size_t pos = 0;
+    if (!fanout_search(data_ + kFanoutOffset, data_ + kIdsOffset, raw, pos)) {
+        return false;
+    }
+    offset = offset_at(pos);
+    crc = crc_at(pos);
+    return true;
+}
+
+void PackIndex::find_prefix(const std::string& prefix, std::size_t limit,
+                            std::vector<std::string>& matches) const {
+    if (data_) {
+        fanout_prefix_search(data_ + kFanoutOffset, data_ + kIdsOffset, prefix, limit, matches);
+    }
+}
+
+std::size_t PackIndex::common_prefix_length(const std::string& hash) const {
+    unsigned char raw[20];
+    if (!data_ || !hex_to_raw(hash, raw)) {
+        return 0;
+    }
+    return fanout_neighbour_prefix(data_ + kFanoutOffset, data_ + kIdsOffset, raw);
+}
+
+std::size_t PackIndex::count() const {
+    return count_;
+}
+
+bool PackIndex::verify_checksum() const {
+    if (!data_) {
+        return false;
+    }
+    Sha1 sha;
+    sha.update(data_, size_ - kTrailerSize);
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    return std::memcmp(digest, data_ + size_ - kTrailerSize, kTrailerSize) == 0;
+}
+
+std::string PackIndex::hash_at(std::size_t i) const {
+    return raw_to_hex(raw_hash_at(i));
+}
+
+// 最高位置 1 的偏移项指向大偏移表，序号越界时返回不可能出现的偏移
+std::uint64_t PackIndex::offset_at(std::size_t i) const {
+    std::uint32_t v = get_u32_be(data_ + kIdsOffset + count_ * 24U + i * 4U);
+    if (large_count_ == 0 || (v & kLargeOffsetFlag) == 0) {
+        return v;
+    }
+    std::size_t slot = v & ~kLargeOffsetFlag;
+    if (slot >= large_count_) {
+        return ~static_cast<std::uint64_t>(0);
+    }
+    return get_u64_be(data_ + kIdsOffset + count_ * 28U + slot * 8U);
+}
+
+std::uint32_t PackIndex::crc_at(std::size_t i) const {
+    return get_u32_be(data_ + kIdsOffset + count_ * 20U + i * 4U);
+}
+
+const unsigned char* PackIndex::raw_hash_at(std::size_t i) const {
+    return data_ + kIdsOffset + i * 20U;
+}
+
+// 按偏移对索引序号排序后写出
+bool write_pack_reverse_index(const std::string& path, const PackIndex& index,
+                              const unsigned char* pack_checksum) {
+    std::vector<std::uint32_t> order(index.count());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<std::uint32_t>(i);
+    }
+    std::sort(order.begin(), order.end(), [&index](std::uint32_t a, std::uint32_t b) {
+        return index.offset_at(a) < index.offset_at(b);
+    });
+    std::string out;
+    out.reserve(8U + order.size() * 4U + 2U * kTrailerSize);
+    out.append(kReverseMagic, sizeof(kReverseMagic));
+    put_u32_be(out, static_cast<std::uint32_t>(order.size()));
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        put_u32_be(out, order[i]);
+    }
+    out.append(reinterpret_cast<const char*>(pack_checksum), 20U);
+    Sha1 sha;
+    sha.update(out.data(), out.size());
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    out.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+    return write_file_atomically(path, out);
+}
+
+PackReverseIndex::PackReverseIndex() : data_(nullptr), size_(0), count_(0) {}
+
+PackReverseIndex::~PackReverseIndex() {
+    close();
+}
+
+// 映射反向索引，检查魔数、长度以及记录的对象数与包校验和
+bool PackReverseIndex::open(const std::string& path, std::size_t count,
+                            const unsigned char* pack_checksum) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    std::size_t expected = 8U + count * 4U + 2U * kTrailerSize;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != expected) {
+        ::close(fd);
+        return false;
+    }
+    void* map = ::mmap(nullptr, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+    if (std::memcmp(data, kReverseMagic, sizeof(kReverseMagic)) != 0 ||
+        get_u32_be(data + 4) != count ||
+        std::memcmp(data + 8U + count * 4U, pack_checksum, 20U) != 0) {
+        ::munmap(map, expected);
+        return false;
+    }
+    data_ = data;
+    size_ = expected;
+    count_ = count;
+    return true;
+}
+
+void PackReverseIndex::close() {
+    if (data_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+}
+
+std::size_t PackReverseIndex::count() const {
+    return count_;
+}
+
+std::uint32_t PackReverseIndex::index_position(std::size_t rank) const {
+    return get_u32_be(data_ + 8U + rank * 4U);
+}
+
+// 沿用旧多包索引中仍然存在的包的条目，只读取新增包的 .idx，两组有序条目归并后写出
+bool write_multi_pack_index(const std::string& pack_dir,
+                            const std::vector<std::string>& pack_names) {
+    std::string path = pack_dir + "/" + kMultiPackIndexName;
+    std::vector<std::string> names(pack_names);
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    if (names.empty()) {
+        ::unlink(path.c_str());
+        return true;
+    }
+
+    // 旧索引中每个对象只记录了一处位置，删除包后其他包里的副本无从得知，
+    // 因此只有在旧索引的包全部仍然存在时才沿用旧条目，否则重新读取全部 .idx
+    std::vector<MultiIndexEntry> kept;
+    std::vector<bool> covered(names.size(), false);
+    {
+        MultiPackIndex old;
+        std::vector<std::uint32_t> remap;
+        bool reusable = old.open(path);
+        for (std::size_t i = 0; reusable && i < old.pack_count(); ++i) {
+            std::vector<std::string>::const_iterator it =
+                std::lower_bound(names.begin(), names.end(), old.pack_name(i));
+            reusable = it != names.end() && *it == old.pack_name(i);
+            if (reusable) {
+                remap.push_back(static_cast<std::uint32_t>(it - names.begin()));
+                covered[remap.back()] = true;
+            }
+        }
+        if (!reusable) {
+            covered.assign(names.size(), false);
+        } else {
+            kept.reserve(old.count());
+            for (std::size_t i = 0; i < old.count(); ++i) {
+                std::uint32_t pack = old.pack_at(i);
+                if (pack >= remap.size()) {
+                    continue;
+                }
+                MultiIndexEntry e;
+                std::memcpy(e.id, old.raw_hash_at(i), 20U);
+                e.pack = static_cast<std::uint32_t>(remap[pack]);
+                e.offset = old.offset_at(i);
+                kept.push_back(e);
+            }
+        }
+    }
+
+    std::vector<MultiIndexEntry> added;
+    for (std::size_t p = 0; p < names.size(); ++p) {
+        if (covered[p]) {
+            continue;
+        }
+        std::string idx_name = names[p];
+        if (idx_name.size() > 4 && idx_name.compare(idx_name.size() - 4, 4, ".mpk") == 0) {
+            idx_name.erase(idx_name.size() - 4);
+        }
+        PackIndex index;
+        if (!index.open(pack_dir + "/" + idx_name + ".idx")) {
+            return false;
+        }
+        for (std::size_t i = 0; i < index.count(); ++i) {
+            MultiIndexEntry e;
+            std::memcpy(e.id, index.raw_hash_at(i), 20U);
+            e.pack = static_cast<std::uint32_t>(p);
+            e.offset = index.offset_at(i);
+            added.push_back(e);
+        }
+    }
+    std::stable_sort(added.begin(), added.end(), entry_id_less);
+
+    // 归并时同一 ID 只保留第一次出现的条目，旧索引中的位置优先
+    std::vector<MultiIndexEntry> merged;
+    merged.reserve(kept.size() + added.size());
+    std::size_t a = 0;
+    std::size_t b = 0;
+    while (a < kept.size() || b < added.size()) {
+        const MultiIndexEntry& next =
+            b >= added.size() || (a < kept.size() && !entry_id_less(added[b], kept[a]))
+                ? kept[a++]
+                : added[b++];
+        if (merged.empty() || std::memcmp(merged.back().id, next.id, 20U) != 0) {
+            merged.push_back(next);
+        }
+    }
+
+    std::string block;
+    for (std::size_t p = 0; p < names.size(); ++p) {
+        block.append(names[p]);
+        block.push_back('\0');
+    }
+    std::string out;
+    out.reserve(12U + block.size() + 256U * 4U + merged.size() * 32U + kTrailerSize);
+    out.append(kMultiIndexMagic, sizeof(kMultiIndexMagic));
+    put_u32_be(out, static_cast<std::uint32_t>(names.size()));
+    put_u32_be(out, static_cast<std::uint32_t>(block.size()));
+    out.append(block);
+    std::uint32_t fanout[256] = {0};
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+        ++fanout[merged[i].id[0]];
+    }
+    std::uint32_t total = 0;
+    for (int v = 0; v < 256; ++v) {
+        total += fanout[v];
+        put_u32_be(out, total);
+    }
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+        out.append(reinterpret_cast<const char*>(merged[i].id), 20U);
+    }
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+        put_u32_be(out, merged[i].pack);
+    }
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+        put_u64_be(out, merged[i].offset);
+    }
+    Sha1 sha;
+    sha.update(out.data(), out.size());
+    unsigned char digest[20];
+    sha.final_raw(digest);
+    out.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+    return write_file_atomically(path, out);
+}
+
+MultiPackIndex::MultiPackIndex() : data_(nullptr), size_(0), count_(0), fanout_offset_(0) {}
+
+MultiPackIndex::~MultiPackIndex() {
+    close();
+}
+
+// 映射多包索引并检查魔数、包名表、扇出表与长度是否一致
+bool MultiPackIndex::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<std::size_t>(st.st_size) < 12U + 256U * 4U + kTrailerSize) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+
+    bool ok = std::memcmp(data, kMultiIndexMagic, sizeof(kMultiIndexMagic)) == 0;
+    std::size_t pack_count = get_u32_be(data + 4);
+    std::size_t block_size = get_u32_be(data + 8);
+    std::size_t fanout = 12U + block_size;
+    ok = ok && block_size <= size - 12U - 256U * 4U - kTrailerSize;
+    std::vector<std::string> packs;
+    if (ok) {
+        const char* p = reinterpret_cast<const char*>(data) + 12;
+        const char* end = p + block_size;
+        while (p < end) {
+            const char* nul = static_cast<const char*>(std::memchr(p, '\0', end - p));
+            if (!nul) {
+                ok = false;
+                break;
+            }
+            packs.push_back(std::string(p, nul));
+            p = nul + 1;
+        }
+        ok = ok && packs.size() == pack_count;
+    }
+    std::uint32_t prev = 0;
+    for (int v = 0; ok && v < 256; ++v) {
+        std::uint32_t cur = get_u32_be(data + fanout + v * 4U);
+        ok = cur >= prev;
+        prev = cur;
+    }
+    std::size_t count = prev;
+    ok = ok && size == fanout + 256U * 4U + count * 32U + kTrailerSize;
+    if (!ok) {
+        ::munmap(map, size);
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+    count_ = count;
+    fanout_offset_ = fanout;
+    packs_.swap(packs);
+    return true;
+}
+
+void MultiPackIndex::close() {
+    if (data_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+    fanout_offset_ = 0;
+    packs_.clear();
+}
+
+bool MultiPackIndex::is_open() const {
+    return data_ != nullptr;
+}
+
+// 与单包索引相同，用扇出表缩小范围后二分查找
+bool MultiPackIndex::find(const std::string& hash, std::uint32_t& pack,
+                          std::uint64_t& offset) const {
+    unsigned char raw[20];
+    std::size_t pos = 0;
+    if (!data_ || !hex_to_raw(hash, raw) ||
+        !fanout_search(data_ + fanout_offset_, raw_hash_at(0), raw, pos) ||
+        pack_at(pos) >= packs_.size()) {
+        return false;
+    }
+    pack = pack_at(pos);
+    offset = offset_at(pos);
+    return true;
+}
+
+void MultiPackIndex::find_prefix(const std::string& prefix, std::size_t limit,
+                                 std::vector<std::string>& matches) const {
+    if (data_) {
+        fanout_prefix_search(data_ + fanout_offset_, raw_hash_at(0), prefix, limit, matches);
+    }
+}
+
+std::size_t MultiPackIndex::common_prefix_length(const std::string& hash) const {
+    unsigned char raw[20];
+    if (!data_ || !hex_to_raw(hash, raw)) {
+        return 0;
+    }
+    return fanout_neighbour_prefix(data_ + fanout_offset_, raw_hash_at(0), raw);
+}
+
+std::size_t MultiPackIndex::count() const {
+    return count_;
+}
+
+std::size_t MultiPackIndex::pack_count() const {
+    return packs_.size();
+}
+
+const std::string& MultiPackIndex::pack_name(std::size_t i) const {
+    return packs_[i];
+}
+
+const unsigned char* MultiPackIndex::raw_hash_at(std::size_t i) const {
+    return data_ + fanout_offset_ + 256U * 4U + i * 20U;
+}
+
+std::uint32_t MultiPackIndex::pack_at(std::size_t i) const {
+    return get_u32_be(data_ + fanout_offset_ + 256U * 4U + count_ * 20U + i * 4U);
+}
+
+std::uint64_t MultiPackIndex::offset_at(std::size_t i) const {
+    return get_u64_be(data_ + fanout_offset_ + 256U * 4U + count_ * 24U + i * 8U);
+}
+
+}  // namespace minigit
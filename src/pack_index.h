@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 本文件声明包文件的索引（.idx）格式及其读写
+namespace minigit {
+
+/**
+ * @brief 写入索引时使用的单个对象条目。
+ */
+struct PackIndexEntry {
+    /// 对象哈希（40 位十六进制字符串）。
+    std::string hash;
+    /// 条目在包文件中的起始偏移。
+    std::uint64_t offset;
+    /// 条目在包文件中全部字节的 CRC32。
+    std::uint32_t crc;
+};
+
+/**
+ * @brief 原子地写出包目录下的辅助文件（索引、位图等）。
+ *
+ * 先写入同目录的只读临时文件并 fsync，再改名到目标路径，
+ * 读者要么看到旧文件，要么看到完整的新文件。
+ *
+ * @param path 目标文件完整路径。
+ * @param data 文件内容。
+ * @return 写入并改名成功返回 true，否则删除临时文件并返回 false。
+ */
+bool write_file_atomically(const std::string& path, const std::string& data);
+
+/**
+ * @brief 写出包文件的索引。
+ *
+ * 索引格式（整数均为大端序）：
+ *   "MIX2" + 256 项 u32 扇出表（第 i 项为首字节 <= i 的对象数）
+ *   + N 个按字节序排列的 20 字节二进制对象 ID
+ *   + N 个 u32 CRC32 + N 个 u32 条目偏移
+ *   + M 个 u64 大偏移 + 20 字节 SHA-1（覆盖之前的全部内容）。
+ * 不小于 2^31 的偏移存入大偏移表，u32 偏移项最高位置 1、低 31 位为表中的序号，
+ * 因此包文件不受 4GB 限制。旧的 "MIX1" 索引没有大偏移表，仍可读取。
+ * 先写入同目录临时文件再原子改名，entries 会被就地排序。
+ *
+ * @param path    索引文件完整路径。
+ * @param entries 包内全部对象的条目。
+ * @return 写入成功返回 true；存在非法或重复的哈希、或写入失败时返回 false。
+ */
+bool write_pack_index(const std::string& path, std::vector<PackIndexEntry>& entries);
+
+/**
+ * @brief 只读映射的包索引。
+ *
+ * 打开时将整个 .idx 文件 mmap 进内存，查找时先用扇出表把范围缩小到
+ * 首字节相同的对象，再在其中二分查找，不需要读取或解析包文件本身。
+ */
+class PackIndex {
+public:
+    PackIndex();
+
+    /**
+     * @brief 解除映射。
+     */
+    ~PackIndex();
+
+    PackIndex(const PackIndex&) = delete;
+    PackIndex& operator=(const PackIndex&) = delete;
+
+    /**
+     * @brief 映射并校验索引文件的结构。
+     *
+     * 只检查魔数、扇出表单调性与文件长度，不计算尾部校验和。
+     *
+     * @param path 索引文件完整路径。
+     * @return 打开成功返回 true，否则返回 false。
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 解除映射，之后 count 返回 0。
+     */
+    void close();
+
+    /**
+     * @brief 查找对象在包文件中的位置。
+     *
+     * @param hash   对象哈希（40 位十六进制字符串）。
+     * @param offset 输出参数，条目在包文件中的起始偏移。
+     * @param crc    输出参数，条目的 CRC32。
+     * @return 找到返回 true，否则返回 false。
+     */
+    bool find(const std::string& hash, std::uint64_t& offset, std::uint32_t& crc) const;
+
+    /**
+     * @brief 查找对象在索引中的序号（按 ID 排序的位置）。
+     *
+     * @param hash 对象哈希（40 位十六进制字符串）。
+     * @param pos  输出参数，对象序号，可用于 hash_at 等按序号访问的接口。
+     * @return 找到返回 true，否则返回 false。
+     */
+    bool position_of(const std::string& hash, std::size_t& pos) const;
+
+    /**
+     * @brief 查找以给定十六进制前缀开头的对象。
+     *
+     * 借助扇出表与二分查找定位第一个不小于前缀的 ID，再向后顺序收集。
+     *
+     * @param prefix  小写十六进制前缀，长度 2 到 40。
+     * @param limit   最多收集的匹配数。
+     * @param matches 输出参数，匹配的完整哈希按字典序追加到末尾。
+     */
+    void find_prefix(const std::string& prefix, std::size_t limit,
+                     std::vector<std::string>& matches) const;
+
+    /**
+     * @brief 返回索引中除 hash 自身外与其共同十六进制前缀最长的对象的前缀长度。
+     *
+     * 二分查找 hash 在有序 ID 表中的位置后只比较相邻的 ID；
+     * 只比较首字节相同的 ID，没有这样的 ID 时返回 0。
+     *
+     * @param hash 对象哈希（40 位十六进制字符串），不要求存在于索引中。
+     * @return 共同前缀的十六进制字符数。
+     */
+    std::size_t common_prefix_length(const std::string& hash) const;
+
+    /**
+     * @brief 返回索引中的对象数量。
+     */
+    std::size_t count() const;
+
+    /**
+     * @brief 计算索引内容的 SHA-1 并与文件末尾的校验和比较。
+     *
+     * @return 索引已打开且校验和一致时返回 true。
+     */
+    bool verify_checksum() const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）的十六进制哈希。
+     */
+    std::string hash_at(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）在包文件中的偏移。
+     */
+    std::uint64_t offset_at(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）的 CRC32。
+     */
+    std::uint32_t crc_at(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）的 20 字节二进制 ID，指向映射区域。
+     */
+    const unsigned char* raw_hash_at(std::size_t i) const;
+
+private:
+    const unsigned char* data_;
+    std::size_t size_;
+    std::size_t count_;
+    /// 大偏移表中的 u64 偏移个数，MIX1 索引恒为 0。
+    std::size_t large_count_;
+};
+
+/**
+ * @brief 为包索引写出反向索引（.rev），记录按包内偏移排序的对象顺序。
+ *
+ * 格式（整数均为大端序）：
+ *   "MRV1" + u32 对象数 + N 个 u32 索引序号（第 r 项为偏移第 r 小的对象在 .idx 中的序号）
+ *   + 20 字节所属包的校验和 + 20 字节 SHA-1（覆盖之前的全部内容）。
+ * 反向索引只需在生成包时排序一次，之后按偏移顺序访问对象或计算条目的
+ * 磁盘占用都可以直接查表。先写入临时文件再原子改名。
+ *
+ * @param path          反向索引文件完整路径。
+ * @param index         已打开的包索引。
+ * @param pack_checksum 所属包的内容标识，见 PackReader::content_id。
+ * @return 写入成功返回 true，否则返回 false。
+ */
+bool write_pack_reverse_index(const std::string& path, const PackIndex& index,
+                              const unsigned char* pack_checksum);
+
+/**
+ * @brief 只读映射的包反向索引。
+ */
+class PackReverseIndex {
+public:
+    PackReverseIndex();
+
+    /**
+     * @brief 解除映射。
+     */
+    ~PackReverseIndex();
+
+    PackReverseIndex(const PackReverseIndex&) = delete;
+    PackReverseIndex& operator=(const PackReverseIndex&) = delete;
+
+    /**
+     * @brief 映射反向索引并检查其与包和包索引是否匹配。
+     *
+     * @param path          反向索引文件完整路径。
+     * @param count         包索引中的对象数量。
+     * @param pack_checksum 所属包的内容标识，见 PackReader::content_id。
+     * @return 结构合法且对象数与校验和一致时返回 true。
+     */
+    bool open(const std::string& path, std::size_t count, const unsigned char* pack_checksum);
+
+    /**
+     * @brief 解除映射，之后 count 返回 0。
+     */
+    void close();
+
+    /**
+     * @brief 返回对象数量。
+     */
+    std::size_t count() const;
+
+    /**
+     * @brief 返回偏移第 rank 小的对象在 .idx 中的序号。
+     */
+    std::uint32_t index_position(std::size_t rank) const;
+
+private:
+    const unsigned char* data_;
+    std::size_t size_;
+    std::size_t count_;
+};
+
+/// 多包索引在 objects/pack 目录下的文件名。
+extern const char kMultiPackIndexName[];
+
+/**
+ * @brief 写出覆盖多个包的多包索引（multi-pack-index）。
+ *
+ * 格式（整数均为大端序）：
+ *   "MMX1" + u32 包数量 + u32 包名区长度 + 以 '\0' 结尾、按名称排序的包文件名
+ *   + 256 项 u32 扇出表 + N 个按字节序排列的 20 字节对象 ID
+ *   + N 个 u32 包编号 + N 个 u64 条目偏移
+ *   + 20 字节 SHA-1（覆盖之前的全部内容）。
+ * 同一对象出现在多个包中时只记录一处。只新增包时增量更新：沿用旧索引中的
+ * 条目，只读取新增包的 .idx；旧索引中的包有被删除的则重新读取全部 .idx。
+ * 先写入临时文件再原子改名。
+ *
+ * @param pack_dir   objects/pack 目录的完整路径。
+ * @param pack_names 目录中全部包文件名（形如 "pack-xxx.mpk"），每个包都需已有 .idx。
+ * @return 写入成功返回 true；没有任何包时删除旧的多包索引并返回 true；
+ *         新增包的索引无法读取或写入失败时返回 false。
+ */
+bool write_multi_pack_index(const std::string& pack_dir,
+                            const std::vector<std::string>& pack_names);
+
+/**
+ * @brief 只读映射的多包索引。
+ *
+ * 所有包的对象合并在一张有序表中，查找对象只需一次扇出表定位加二分查找，
+ * 与包的数量无关。
+ */
+class MultiPackIndex {
+public:
+    MultiPackIndex();
+
+    /**
+     * @brief 解除映射。
+     */
+    ~MultiPackIndex();
+
+    MultiPackIndex(const MultiPackIndex&) = delete;
+    MultiPackIndex& operator=(const MultiPackIndex&) = delete;
+
+    /**
+     * @brief 映射并校验多包索引的结构，不计算尾部校验和。
+     *
+     * @param path 多包索引文件完整路径。
+     * @return 打开成功返回 true，否则返回 false。
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 解除映射，之后 count 与 pack_count 返回 0。
+     */
+    void close();
+
+    /**
+     * @brief 判断是否已打开。
+     */
+    bool is_open() const;
+
+    /**
+     * @brief 查找对象所在的包与偏移。
+     *
+     * @param hash   对象哈希（40 位十六进制字符串）。
+     * @param pack   输出参数，包编号，可用 pack_name 取得文件名。
+     * @param offset 输出参数，条目在包文件中的起始偏移。
+     * @return 找到返回 true，否则返回 false。
+     */
+    bool find(const std::string& hash, std::uint32_t& pack, std::uint64_t& offset) const;
+
+    /**
+     * @brief 查找以给定十六进制前缀开头的对象，语义同 PackIndex::find_prefix。
+     */
+    void find_prefix(const std::string& prefix, std::size_t limit,
+                     std::vector<std::string>& matches) const;
+
+    /**
+     * @brief 语义同 PackIndex::common_prefix_length。
+     */
+    std::size_t common_prefix_length(const std::string& hash) const;
+
+    /**
+     * @brief 返回索引中的对象数量。
+     */
+    std::size_t count() const;
+
+    /**
+     * @brief 返回索引覆盖的包数量。
+     */
+    std::size_t pack_count() const;
+
+    /**
+     * @brief 返回编号为 i 的包文件名（不含目录）。
+     */
+    const std::string& pack_name(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）的 20 字节二进制 ID，指向映射区域。
+     */
+    const unsigned char* raw_hash_at(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）所在的包编号。
+     */
+    std::uint32_t pack_at(std::size_t i) const;
+
+    /**
+     * @brief 返回第 i 个对象（按 ID 排序）在其包文件中的偏移。
+     */
+    std::uint64_t offset_at(std::size_t i) const;
+
+private:
+    const unsigned char* data_;
+    std::size_t size_;
+    std::size_t count_;
+    std::size_t fanout_offset_;
+    std::vector<std::string> packs_;
+};
+
+}  // namespace minigit
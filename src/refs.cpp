@@ -1,6 +1,10 @@
 #include "refs.h"
 
 #include <cstddef>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 // 本文件实现 refs 与 HEAD 管理的具体逻辑
 namespace {
@@ -20,6 +24,39 @@ std::string rstrip_newline(const std::string& s) {
     return s.substr(0, end);
 }
 
+// 深度优先遍历 ref 目录，dir 为相对于仓库根目录的路径
+void collect_refs(const minigit::FileSystem& fs, const std::string& dir,
+                  std::map<std::string, std::string>& out) {
+    DIR* d = ::opendir(fs.make_path(dir).c_str());
+    if (!d) {
+        return;
+    }
+    std::vector<std::string> names;
+    struct dirent* entry = nullptr;
+    while ((entry = ::readdir(d)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            names.push_back(name);
+        }
+    }
+    ::closedir(d);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::string rel = dir + "/" + names[i];
+        struct stat st;
+        if (::stat(fs.make_path(rel).c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            collect_refs(fs, rel, out);
+            continue;
+        }
+        std::string hash;
+        if (minigit::read_ref(fs, rel, hash)) {
+            out[rel] = hash;
+        }
+    }
+}
+
 }  // namespace
 
 namespace minigit {
@@ -89,5 +126,9 @@ bool read_ref(const FileSystem& fs,
     return true;
 }
 
-}  // namespace minigit
+void list_refs(const FileSystem& fs, std::map<std::string, std::string>& out) {
+    out.clear();
+    collect_refs(fs, "refs", out);
+}
 
+}  // namespace minigit
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 
 #include "filesystem.h"
@@ -85,5 +86,15 @@ bool read_ref(const FileSystem& fs,
               const std::string& refname,
               std::string& hash);
 
+/**
+ * @brief 递归列出 refs 目录下的全部 ref。
+ *
+ * 内容为空或无法读取的 ref 文件会被跳过。
+ *
+ * @param fs  仓库根目录对应的文件系统对象。
+ * @param out 输出参数，ref 路径（例如 "refs/heads/master"）到提交哈希的映射。
+ */
+void list_refs(const FileSystem& fs, std::map<std::string, std::string>& out);
+
 }  // namespace minigit
 
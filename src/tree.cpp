@@ -4,6 +4,7 @@
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <dirent.h>
 #include <stdexcept>
 #include <string>
@@ -14,6 +15,8 @@
 #include <set>
 #include <vector>
 
+#include "hash.h"
+
 // 本文件实现 tree 对象的构造、解析以及目录快照写入逻辑
 namespace {
 
@@ -42,50 +45,48 @@ std::string join_paths(const std::string& a, const std::string& b) {
     return a + "/" + b;
 }
 
-// 将 40 位十六进制哈希转换为 20 字节二进制形式
-std::string hex_to_raw20(const std::string& hex) {
-    if (hex.size() != 40U) {
-        throw std::runtime_error("invalid sha1 hex length");
-    }
+// 扫描条目正文，依次复用 entries 中已有元素，最后截断多余元素
+bool parse_tree_entries(const char* data, std::size_t size,
+                        std::vector<minigit::TreeEntry>& entries) {
+    std::size_t count = 0;
+    const char* p = data;
+    const char* end = data + size;
 
-    auto hex_to_nibble = [](char c) -> uint8_t {
-        if (c >= '0' && c <= '9') {
-            return static_cast<uint8_t>(c - '0');
+    while (p < end) {
+        // 解析 mode
+        const char* space =
+            static_cast<const char*>(std::memchr(p, ' ', static_cast<std::size_t>(end - p)));
+        if (!space) {
+            return false;
         }
-        if (c >= 'a' && c <= 'f') {
-            return static_cast<uint8_t>(c - 'a' + 10);
+
+        // 解析 name
+        const char* name_end = static_cast<const char*>(
+            std::memchr(space + 1, '\0', static_cast<std::size_t>(end - space - 1)));
+        if (!name_end) {
+            return false;
         }
-        if (c >= 'A' && c <= 'F') {
-            return static_cast<uint8_t>(c - 'A' + 10);
+
+        // 解析 20 字节哈希
+        const char* hash_start = name_end + 1;
+        if (end - hash_start < 20) {
+            return false;
         }
-        throw std::runtime_error("invalid hex character");
-    };
 
-    std::string out;
-    out.resize(20U);
-    for (std::size_t i = 0; i < 20U; ++i) {
-        uint8_t high = hex_to_nibble(hex[i * 2U]);
-        uint8_t low = hex_to_nibble(hex[i * 2U + 1U]);
-        out[i] = static_cast<char>((high << 4U) | low);
-    }
-    return out;
-}
+        if (count == entries.size()) {
+            entries.push_back(minigit::TreeEntry());
+        }
+        minigit::TreeEntry& entry = entries[count++];
+        entry.mode.assign(p, space);
+        entry.name.assign(space + 1, name_end);
+        minigit::raw_to_hex_into(reinterpret_cast<const unsigned char*>(hash_start),
+                                 entry.hash);
 
-// 将 20 字节二进制哈希转换为 40 位十六进制字符串
-std::string raw20_to_hex(const std::string& raw) {
-    if (raw.size() != 20U) {
-        throw std::runtime_error("invalid sha1 raw length");
+        p = hash_start + 20;
     }
 
-    static const char* kHex = "0123456789abcdef";
-    std::string out;
-    out.resize(40U);
-    for (std::size_t i = 0; i < 20U; ++i) {
-        uint8_t v = static_cast<uint8_t>(raw[i]);
-        out[i * 2U] = kHex[(v >> 4U) & 0x0FU];
-        out[i * 2U + 1U] = kHex[v & 0x0FU];
-    }
-    return out;
+    entries.resize(count);
+    return true;
 }
 
 // 递归遍历目录并构建 tree，对每个目录返回对应的 tree 哈希
@@ -150,6 +151,7 @@ std::string write_tree_recursive(minigit::ObjectStore& store,
             }
 
             std::string data;
+            data.reserve(static_cast<std::size_t>(st.st_size));
             char buffer[4096];
             while (true) {
                 std::size_t n = std::fread(buffer, 1, sizeof(buffer), fp);
@@ -206,7 +208,11 @@ std::string build_tree_object(const std::vector<TreeEntry>& entries) {
         body.push_back(' ');
         body.append(e.name);
         body.push_back('\0');
-        body.append(hex_to_raw20(e.hash));
+        unsigned char raw[20];
+        if (!hex_to_raw(e.hash, raw)) {
+            throw std::runtime_error("invalid sha1 hex");
+        }
+        body.append(reinterpret_cast<const char*>(raw), 20U);
     }
 
     std::string header = "tree " + std::to_string(body.size());
@@ -228,48 +234,30 @@ bool parse_tree_object(const std::string& content,
     // 兼容两种输入：带头部的完整对象 或 仅条目正文
     std::size_t pos = content.find('\0');
     if (pos != std::string::npos) {
-        std::string header = content.substr(0, pos);
-        if (header.compare(0, 5, "tree ") == 0) {
+        if (content.compare(0, 5, "tree ") == 0) {
             idx = pos + 1;
-        } else {
-            idx = 0;
         }
     }
 
-    while (idx < content.size()) {
-        // 解析 mode
-        std::size_t space_pos = content.find(' ', idx);
-        if (space_pos == std::string::npos) {
-            return false;
-        }
-        std::string mode = content.substr(idx, space_pos - idx);
-
-        // 解析 name
-        std::size_t name_end = content.find('\0', space_pos + 1);
-        if (name_end == std::string::npos) {
-            return false;
-        }
-        std::string name =
-            content.substr(space_pos + 1, name_end - (space_pos + 1));
-
-        // 解析 20 字节哈希
-        std::size_t hash_start = name_end + 1;
-        if (hash_start + 20U > content.size()) {
-            return false;
-        }
-        std::string raw_hash = content.substr(hash_start, 20U);
-        std::string hex_hash = raw20_to_hex(raw_hash);
-
-        TreeEntry entry;
-        entry.mode = mode;
-        entry.name = name;
-        entry.hash = hex_hash;
-        entries.push_back(entry);
+    return parse_tree_entries(content.data() + idx, content.size() - idx, entries);
+}
 
-        idx = hash_start + 20U;
+// 校验视图类型后直接在视图缓冲区上解析条目
+bool parse_tree_object(const ObjectView& view, std::vector<TreeEntry>& entries) {
+    if (view.type != ObjectType::kTree) {
+        return false;
     }
+    return parse_tree_entries(view.data, view.size, entries);
+}
 
-    return true;
+// 通过读取上下文读取 tree 对象并解析条目
+bool read_tree(ObjectStore& store, const std::string& hash, ReadContext& ctx,
+               std::vector<TreeEntry>& entries) {
+    ObjectView view;
+    if (!store.read_object(hash, ctx, view)) {
+        return false;
+    }
+    return parse_tree_object(view, entries);
 }
 
 std::string write_tree(ObjectStore& store, const std::string& root_dir) {
@@ -405,39 +393,48 @@ static std::string join_paths2(const std::string& a, const std::string& b) {
     return a + "/" + b;
 }
 
+// 按层展开 tree：同一层的全部子 tree 通过一次批量读取按磁盘顺序取回
 bool flatten_tree_to_index(ObjectStore& store,
                            const std::string& tree_hash,
                            std::vector<IndexEntry>& entries) {
     entries.clear();
-    struct Frame {
-        std::string dir;
-        std::string hash;
-    };
-    std::vector<Frame> stack;
-    stack.push_back(Frame{"", tree_hash});
-    while (!stack.empty()) {
-        Frame f = stack.back();
-        stack.pop_back();
-        std::string content;
-        if (!store.read_object(f.hash, content)) {
-            return false;
-        }
-        std::vector<TreeEntry> tes;
-        if (!parse_tree_object(content, tes)) {
-            return false;
+    // 相同内容的子 tree 可能出现在多个目录下，因此一个哈希可对应多个目录
+    std::multimap<std::string, std::string> level;
+    level.insert(std::make_pair(tree_hash, std::string()));
+    std::vector<TreeEntry> tes;
+    while (!level.empty()) {
+        std::vector<std::string> hashes;
+        for (const auto& item : level) {
+            hashes.push_back(item.first);
         }
-        for (const auto& e : tes) {
-            if (e.mode == "40000") {
-                stack.push_back(Frame{join_paths2(f.dir, e.name), e.hash});
-            } else if (e.mode == "100644") {
-                IndexEntry ie;
-                ie.mode = e.mode;
-                ie.path = join_paths2(f.dir, e.name);
-                ie.hash = e.hash;
-                entries.push_back(ie);
+        std::multimap<std::string, std::string> next;
+        bool ok = store.read_many(hashes, [&](const std::string& hash, const ObjectView& view) {
+            if (!parse_tree_object(view, tes)) {
+                return false;
             }
+            auto range = level.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                for (const auto& e : tes) {
+                    if (e.mode == "40000") {
+                        next.insert(std::make_pair(e.hash, join_paths2(it->second, e.name)));
+                    } else if (e.mode == "100644") {
+                        IndexEntry ie;
+                        ie.mode = e.mode;
+                        ie.path = join_paths2(it->second, e.name);
+                        ie.hash = e.hash;
+                        entries.push_back(ie);
+                    }
+                }
+            }
+            return true;
+        });
+        if (!ok) {
+            return false;
         }
+        level.swap(next);
     }
+    std::sort(entries.begin(), entries.end(),
+              [](const IndexEntry& a, const IndexEntry& b) { return a.path < b.path; });
     return true;
 }
 
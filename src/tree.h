@@ -50,6 +50,30 @@ std::string build_tree_object(const std::vector<TreeEntry>& entries);
 bool parse_tree_object(const std::string& content,
                        std::vector<TreeEntry>& entries);
 
+/**
+ * @brief 在对象视图上原地解析 tree 条目。
+ *
+ * 会校验视图类型必须为 tree。解析时直接扫描视图所指缓冲区，不复制正文；
+ * 若 entries 中已有元素，会复用其字符串容量，适合在遍历中反复调用。
+ *
+ * @param view    ObjectStore::read_object 返回的对象视图。
+ * @param entries 输出参数，用于接收解析得到的条目列表。
+ * @return 类型正确且解析成功返回 true，否则返回 false。
+ */
+bool parse_tree_object(const ObjectView& view, std::vector<TreeEntry>& entries);
+
+/**
+ * @brief 读取并解析指定哈希的 tree 对象。
+ *
+ * @param store   对象存储实例。
+ * @param hash    tree 对象哈希。
+ * @param ctx     可复用的读取上下文。
+ * @param entries 输出参数，用于接收解析得到的条目列表。
+ * @return 对象存在、类型为 tree 且解析成功时返回 true。
+ */
+bool read_tree(ObjectStore& store, const std::string& hash, ReadContext& ctx,
+               std::vector<TreeEntry>& entries);
+
 /**
  * @brief 从指定工作目录构建目录快照并写入对象存储。
  *
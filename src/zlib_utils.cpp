@@ -1,10 +1,39 @@
 #include "zlib_utils.h"
 
+#include <cerrno>
+#include <functional>
 #include <stdexcept>
 #include <vector>
 
+#include <unistd.h>
 #include <zlib.h>
 
+namespace {
+
+// 压缩流输出缓冲区大小
+const std::size_t kDeflateChunk = 64U * 1024U;
+
+// 单次喂给 zlib 的最大输入长度，避免超出 uInt 表示范围
+const std::size_t kMaxFeed = 1U << 30;
+
+// 将缓冲区完整写入文件描述符，处理短写与 EINTR
+bool write_all(int fd, const unsigned char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
 // 本文件实现基于 zlib 的压缩与解压工具函数
 namespace minigit {
 
@@ -16,9 +45,10 @@ std::string zlib_compress(const std::string& input) {
 
     uLong source_len = static_cast<uLong>(input.size());
     uLong dest_len = compressBound(source_len);
-    std::vector<unsigned char> buffer(dest_len);
+    std::string out;
+    out.resize(dest_len);
 
-    int ret = compress2(buffer.data(), &dest_len,
+    int ret = compress2(reinterpret_cast<Bytef*>(&out[0]), &dest_len,
                         reinterpret_cast<const Bytef*>(input.data()),
                         source_len, Z_BEST_COMPRESSION);
 
@@ -26,7 +56,8 @@ std::string zlib_compress(const std::string& input) {
         throw std::runtime_error("zlib_compress failed");
     }
 
-    return std::string(reinterpret_cast<char*>(buffer.data()), dest_len);
+    out.resize(dest_len);
+    return out;
 }
 
 // 使用 zlib 对输入数据进行解压，自动扩容缓冲区直至解压成功
@@ -56,4 +87,179 @@ std::string zlib_decompress(const std::string& input) {
     return std::string(reinterpret_cast<char*>(buffer.data()), dest_len);
 }
 
+// 逐段喂入切片进行流式压缩，每当输出缓冲区填满即交给 sink 处理
+static bool deflate_slices(const ByteSlice* slices, std::size_t count,
+                           const std::function<bool(const unsigned char*, std::size_t)>& sink) {
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    zs.next_in = Z_NULL;
+    zs.avail_in = 0;
+    if (deflateInit(&zs, Z_BEST_COMPRESSION) != Z_OK) {
+        throw std::runtime_error("zlib deflateInit failed");
+    }
+
+    unsigned char out[kDeflateChunk];
+    std::size_t slice_index = 0;
+    std::size_t slice_offset = 0;
+    int ret = Z_OK;
+
+    while (ret != Z_STREAM_END) {
+        // 输入耗尽时补充下一段切片，单次喂入量受 uInt 上限约束
+        if (zs.avail_in == 0) {
+            while (slice_index < count &&
+                   slice_offset == slices[slice_index].size) {
+                ++slice_index;
+                slice_offset = 0;
+            }
+            if (slice_index < count) {
+                std::size_t remain = slices[slice_index].size - slice_offset;
+                if (remain > kMaxFeed) {
+                    remain = kMaxFeed;
+                }
+                zs.next_in = reinterpret_cast<Bytef*>(
+                    const_cast<char*>(slices[slice_index].data + slice_offset));
+                zs.avail_in = static_cast<uInt>(remain);
+                slice_offset += remain;
+            }
+        }
+
+        bool finishing = (zs.avail_in == 0 && slice_index >= count);
+        zs.next_out = out;
+        zs.avail_out = static_cast<uInt>(kDeflateChunk);
+        ret = deflate(&zs, finishing ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) {
+            deflateEnd(&zs);
+            throw std::runtime_error("zlib deflate failed");
+        }
+
+        std::size_t produced = kDeflateChunk - zs.avail_out;
+        if (produced > 0 && !sink(out, produced)) {
+            deflateEnd(&zs);
+            return false;
+        }
+    }
+
+    deflateEnd(&zs);
+    return true;
+}
+
+// 流式压缩切片并直接写入文件描述符
+bool zlib_deflate_to_fd(const ByteSlice* slices, std::size_t count, int fd) {
+    return deflate_slices(slices, count,
+                          [fd](const unsigned char* data, std::size_t size) {
+                              return write_all(fd, data, size);
+                          });
+}
+
+// 流式压缩切片并追加到内存字符串
+std::string zlib_compress(const ByteSlice* slices, std::size_t count) {
+    std::string out;
+    deflate_slices(slices, count, [&out](const unsigned char* data, std::size_t size) {
+        out.append(reinterpret_cast<const char*>(data), size);
+        return true;
+    });
+    return out;
+}
+
+ZlibInflater::ZlibInflater() : stream_(nullptr) {}
+
+ZlibInflater::~ZlibInflater() {
+    if (stream_) {
+        inflateEnd(stream_);
+        delete stream_;
+    }
+}
+
+// 首次使用时初始化流，之后只重置；输出区间按输入估计，写满时才倍增
+bool ZlibInflater::inflate_into(const char* input, std::size_t input_size, std::string& out) {
+    if (!stream_) {
+        z_stream* zs = new z_stream;
+        zs->zalloc = Z_NULL;
+        zs->zfree = Z_NULL;
+        zs->opaque = Z_NULL;
+        zs->next_in = Z_NULL;
+        zs->avail_in = 0;
+        if (inflateInit(zs) != Z_OK) {
+            delete zs;
+            return false;
+        }
+        stream_ = zs;
+    } else if (inflateReset(stream_) != Z_OK) {
+        return false;
+    }
+    z_stream& zs = *stream_;
+
+    std::size_t want = input_size * 4U;
+    if (want < 64U) {
+        want = 64U;
+    }
+    out.resize(want);
+
+    std::size_t in_done = 0;
+    std::size_t produced = 0;
+    int ret = Z_OK;
+    zs.avail_in = 0;
+    while (ret != Z_STREAM_END) {
+        if (zs.avail_in == 0 && in_done < input_size) {
+            std::size_t feed = input_size - in_done;
+            if (feed > kMaxFeed) {
+                feed = kMaxFeed;
+            }
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input + in_done));
+            zs.avail_in = static_cast<uInt>(feed);
+            in_done += feed;
+        }
+        if (produced == out.size()) {
+            out.resize(out.size() * 2U);
+        }
+        std::size_t room = out.size() - produced;
+        if (room > kMaxFeed) {
+            room = kMaxFeed;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&out[produced]);
+        zs.avail_out = static_cast<uInt>(room);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        produced += room - zs.avail_out;
+        if (ret == Z_BUF_ERROR && zs.avail_in == 0 && in_done >= input_size) {
+            // 输入已耗尽但流尚未结束：数据被截断
+            break;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            break;
+        }
+    }
+
+    out.resize(produced);
+    return ret == Z_STREAM_END;
+}
+
+// 一次性解压，使用临时的解压器
+bool zlib_inflate_into(const char* input, std::size_t input_size,
+                       std::string& out) {
+    ZlibInflater inflater;
+    return inflater.inflate_into(input, input_size, out);
+}
+
+// 单次 inflate 调用解压前缀，输出缓冲区填满或输入耗尽即停止
+bool zlib_inflate_prefix(const char* input, std::size_t input_size, char* out,
+                         std::size_t out_cap, std::size_t& produced) {
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+    zs.avail_in = static_cast<uInt>(input_size > kMaxFeed ? kMaxFeed : input_size);
+    if (inflateInit(&zs) != Z_OK) {
+        return false;
+    }
+    zs.next_out = reinterpret_cast<Bytef*>(out);
+    zs.avail_out = static_cast<uInt>(out_cap);
+    int ret = inflate(&zs, Z_SYNC_FLUSH);
+    produced = out_cap - zs.avail_out;
+    inflateEnd(&zs);
+    return ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR;
+}
+
 }  // namespace minigit
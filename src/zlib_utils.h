@@ -1,14 +1,44 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
+#include "byte_slice.h"
+
+struct z_stream_s;
+
 // 本文件声明基于 zlib 的压缩与解压工具函数
 namespace minigit {
 
+/**
+ * @brief 可复用的 zlib 解压器。
+ *
+ * 首次解压时初始化 z_stream，之后每次只调用 inflateReset，省去反复
+ * inflateInit/inflateEnd 分配与释放内部状态（约 7KB 的窗口）。
+ * 解压器不是线程安全的，每个线程或读取上下文应持有独立实例。
+ */
+class ZlibInflater {
+public:
+    ZlibInflater();
+    ~ZlibInflater();
+
+    ZlibInflater(const ZlibInflater&) = delete;
+    ZlibInflater& operator=(const ZlibInflater&) = delete;
+
+    /**
+     * @brief 将 zlib 流解压到调用方提供的可复用缓冲区，语义同 zlib_inflate_into。
+     */
+    bool inflate_into(const char* input, std::size_t input_size, std::string& out);
+
+private:
+    z_stream_s* stream_;
+};
+
 /**
  * @brief 使用 zlib 对输入数据进行压缩。
  *
- * 内部使用 zlib 的 compress2 接口，根据输入大小自动计算输出缓冲区。
+ * 直接在结果字符串中按 compressBound 预留空间并原地压缩，最后收缩到实际长度，
+ * 不再经过中间缓冲区复制。
  *
  * @param input 原始未压缩数据。
  * @return 压缩后的二进制数据；若输入为空则返回空字符串。
@@ -27,4 +57,64 @@ std::string zlib_compress(const std::string& input);
  */
 std::string zlib_decompress(const std::string& input);
 
+/**
+ * @brief 将多段切片作为一个连续的 zlib 流压缩到内存。
+ *
+ * 结果与先拼接切片再调用 zlib_compress 相同（空输入也会产生完整的 zlib 流），
+ * 但不会产生拼接副本，适合对象头部与正文分离的场景。
+ *
+ * @param slices 输入切片数组，逻辑上按顺序拼接。
+ * @param count  切片数量。
+ * @return 压缩后的二进制数据。
+ * @throws std::runtime_error 当 zlib 压缩流出错时抛出异常。
+ */
+std::string zlib_compress(const ByteSlice* slices, std::size_t count);
+
+/**
+ * @brief 将多段切片作为一个连续的 zlib 流压缩并直接写入文件描述符。
+ *
+ * 各切片按顺序喂给 deflate，输出经固定大小的缓冲区分块写出，
+ * 因此内存占用与输入大小无关，也不会拼接输入切片。
+ *
+ * @param slices 输入切片数组，逻辑上按顺序拼接。
+ * @param count  切片数量。
+ * @param fd     已打开的可写文件描述符。
+ * @return 全部写入成功返回 true，写文件失败返回 false。
+ * @throws std::runtime_error 当 zlib 压缩流出错时抛出异常。
+ */
+bool zlib_deflate_to_fd(const ByteSlice* slices, std::size_t count, int fd);
+
+/**
+ * @brief 将 zlib 流解压到调用方提供的可复用缓冲区。
+ *
+ * 解压结果覆盖 out 原有内容，并尽量复用其已有容量；
+ * 在循环中重复使用同一个 out 时，稳定状态下不会产生新的堆分配。
+ * 输出区间按压缩数据长度估计，只在写满时倍增，填零的开销与本次对象大小成正比，
+ * 与缓冲区历史上的最大容量无关。每次调用都会初始化一次 z_stream，
+ * 热路径应改用持有 ZlibInflater 的读取上下文。
+ *
+ * @param input      压缩数据起始地址。
+ * @param input_size 压缩数据长度（字节）。
+ * @param out        输出缓冲区，返回时其 size 等于解压后长度。
+ * @return 解压成功返回 true，数据损坏或被截断时返回 false。
+ */
+bool zlib_inflate_into(const char* input, std::size_t input_size,
+                       std::string& out);
+
+/**
+ * @brief 只解压 zlib 流开头的一段数据。
+ *
+ * 在输出缓冲区填满、输入耗尽或流结束时停止，不要求输入是完整的流，
+ * 用于只需要读取对象头部的场景。
+ *
+ * @param input      压缩数据起始地址（可以只是流的前缀）。
+ * @param input_size 可用压缩数据长度。
+ * @param out        输出缓冲区。
+ * @param out_cap    输出缓冲区容量。
+ * @param produced   输出参数，实际解压得到的字节数。
+ * @return 未遇到数据错误返回 true，否则返回 false。
+ */
+bool zlib_inflate_prefix(const char* input, std::size_t input_size, char* out,
+                         std::size_t out_cap, std::size_t& produced);
+
 }  // namespace minigit
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "batch.h"
+#include "object_store.h"
+
+// 本文件包含针对 cat-file / hash-object 批量协议的单元测试
+
+// 验证 --batch 与 --batch-check 的输出格式以及缺失对象的应答
+TEST(BatchTest, CatFileBatchAndBatchCheck) {
+    char tmpl[] = "/tmp/minigit_batchXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    minigit::ObjectStore store(dir);
+    std::string h = store.store_blob("hello batch");
+    std::string missing = "0123456789012345678901234567890123456789";
+
+    std::istringstream in(h + "\n" + missing + "\nnot-a-hash\n");
+    std::ostringstream out;
+    minigit::CatFileBatchOptions options;
+    options.with_contents = true;
+    options.buffer = true;
+    EXPECT_EQ(minigit::run_cat_file_batch(store, in, out, options), 0);
+    EXPECT_EQ(out.str(), h + " blob 11\nhello batch\n" + missing +
+                             " missing\nnot-a-hash missing\n");
+
+    std::istringstream in2(h + "\n");
+    std::ostringstream out2;
+    options.with_contents = false;
+    EXPECT_EQ(minigit::run_cat_file_batch(store, in2, out2, options), 0);
+    EXPECT_EQ(out2.str(), h + " blob 11\n");
+}
+
+// 验证 --stdin-paths 对每个路径写入 blob 并报告无法读取的路径
+TEST(BatchTest, HashObjectStdinPaths) {
+    char tmpl[] = "/tmp/minigit_batch_pathsXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root(dir);
+    minigit::ObjectStore store(root + "/.minigit");
+
+    std::string file = root + "/a.txt";
+    std::FILE* fp = std::fopen(file.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    std::fputs("hello world", fp);
+    std::fclose(fp);
+
+    std::istringstream in(file + "\n" + root + "/missing.txt\n");
+    std::ostringstream out;
+    std::ostringstream err;
+    EXPECT_EQ(minigit::run_hash_object_stdin_paths(store, in, out, err), 1);
+    EXPECT_EQ(out.str(), "95d09f2b10159347eece71399a7e2e907ea3df4f\n");
+    EXPECT_FALSE(err.str().empty());
+
+    std::string data;
+    ASSERT_TRUE(store.read_object("95d09f2b10159347eece71399a7e2e907ea3df4f", data));
+    EXPECT_EQ(data, "hello world");
+}
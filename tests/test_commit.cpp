@@ -69,3 +69,29 @@ TEST(CommitTest, StoreAndReadCommit) {
     EXPECT_EQ(parsed.message, c.message);
 }
 
+
+// 通过对象视图读取 commit，并验证对非 commit 视图的类型校验
+TEST(CommitTest, ReadCommitThroughViewChecksType) {
+    char repo_tmpl[] = "/tmp/minigit_commit_viewXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+
+    minigit::ObjectStore store(repo_dir_c);
+    minigit::Commit c;
+    c.tree = "1111111111111111111111111111111111111111";
+    c.parents.push_back("2222222222222222222222222222222222222222");
+    c.author = "Alice <alice@example.com> 123456789 +0000";
+    c.committer = c.author;
+    c.message = "view";
+    std::string commit_hash = minigit::write_commit(store, c);
+    std::string blob_hash = store.store_blob("not a commit");
+
+    minigit::ReadContext ctx;
+    minigit::Commit parsed;
+    ASSERT_TRUE(minigit::read_commit(store, commit_hash, ctx, parsed));
+    EXPECT_EQ(parsed.tree, c.tree);
+    ASSERT_EQ(parsed.parents.size(), 1U);
+    EXPECT_EQ(parsed.message, "view");
+
+    EXPECT_FALSE(minigit::read_commit(store, blob_hash, ctx, parsed));
+}
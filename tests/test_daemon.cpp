@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "daemon.h"
+
+// 本文件包含针对 daemon 套接字协议的集成测试
+
+// 在后台线程运行服务端，验证请求参数与应答内容完整往返
+TEST(DaemonTest, RequestRoundtripAndStop) {
+    char tmpl[] = "/tmp/minigit_daemonXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string socket_path = std::string(dir) + "/daemon.sock";
+
+    minigit::DaemonServer server(socket_path);
+    ASSERT_TRUE(server.listen());
+
+    // 同一路径上的第二个实例应检测到已有服务而失败
+    minigit::DaemonServer second(socket_path);
+    EXPECT_FALSE(second.listen());
+
+    std::thread worker([&server]() {
+        server.serve([&server](const std::vector<std::string>& args,
+                               std::string& out, std::string& err) {
+            if (!args.empty() && args[0] == "stop") {
+                server.request_stop();
+                return 0;
+            }
+            for (std::size_t i = 0; i < args.size(); ++i) {
+                out += args[i];
+                out.push_back('|');
+            }
+            err = "err";
+            return 7;
+        });
+    });
+
+    std::vector<std::string> args;
+    args.push_back("status");
+    args.push_back(std::string("a\0b", 3));
+    minigit::DaemonResponse resp;
+    ASSERT_TRUE(minigit::daemon_request(socket_path, args, resp));
+    EXPECT_EQ(resp.exit_code, 7);
+    EXPECT_EQ(resp.out, std::string("status|a\0b|", 11));
+    EXPECT_EQ(resp.err, "err");
+
+    std::vector<std::string> stop_args(1, "stop");
+    ASSERT_TRUE(minigit::daemon_request(socket_path, stop_args, resp));
+    worker.join();
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "delta.h"
+#include "filesystem.h"
+#include "object_store.h"
+#include "pack.h"
+
+// 本文件包含针对 delta 编码以及包内 delta 解析的单元测试
+
+// 验证 delta 能在目标与基准只有局部差异时显著变小，且应用后还原目标
+TEST(DeltaTest, CreateAndApplyRoundtrip) {
+    std::string base;
+    for (int i = 0; i < 400; ++i) {
+        base += "line " + std::to_string(i) + " of the original file\n";
+    }
+    std::string target = base;
+    target.replace(5000, 10, "CHANGED");
+    target.insert(0, "header\n");
+    target += "appended tail\n";
+
+    minigit::DeltaIndex index(base.data(), base.size());
+    std::string delta;
+    ASSERT_TRUE(minigit::create_delta(index, target.data(), target.size(), 0, delta));
+    EXPECT_LT(delta.size(), 200U);
+
+    std::string out;
+    ASSERT_TRUE(minigit::apply_delta(base.data(), base.size(), delta.data(), delta.size(), out));
+    EXPECT_EQ(out, target);
+
+    EXPECT_FALSE(minigit::create_delta(index, target.data(), target.size(), 8, delta));
+    EXPECT_FALSE(minigit::apply_delta(base.data(), base.size() - 1, delta.data(),
+                                      delta.size(), out));
+}
+
+// 头部声明的结果长度远超 delta 所能产生的数据时，应当失败而不是按声明长度分配内存
+TEST(DeltaTest, RejectsImplausibleResultSize) {
+    std::string base = "base";
+    std::string delta;
+    delta.push_back(static_cast<char>(base.size()));
+    // 结果长度声明为 2^49：七个只带续位的字节后跟 0x01
+    delta.append(7, static_cast<char>(0x80));
+    delta.push_back(static_cast<char>(0x01));
+    delta.push_back(static_cast<char>(0x90));
+    delta.push_back(static_cast<char>(base.size()));
+
+    std::string out;
+    EXPECT_FALSE(minigit::apply_delta(base.data(), base.size(), delta.data(), delta.size(), out));
+    EXPECT_LT(out.capacity(), 1024U);
+}
+
+// 验证打包时相似的 blob 以 delta 形式存储，并可通过对象存储透明读取
+TEST(DeltaTest, PackStoresSimilarBlobsAsDeltas) {
+    char tmpl[] = "/tmp/minigit_deltaXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+
+    std::string content;
+    for (int i = 0; i < 200; ++i) {
+        content += "int value_" + std::to_string(i) + " = " + std::to_string(i * 7) + ";\n";
+    }
+    std::vector<std::string> versions;
+    std::vector<std::string> hashes;
+    {
+        minigit::ObjectStore store(root);
+        for (int v = 0; v < 5; ++v) {
+            content += "// revision " + std::to_string(v) + "\n";
+            versions.push_back(content);
+            hashes.push_back(store.store_blob(content));
+        }
+    }
+
+    minigit::PackOptions options;
+    options.depth = 2;
+    minigit::PackStats stats;
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-delta.mpk", options, stats));
+    EXPECT_EQ(stats.objects, 5U);
+    EXPECT_EQ(stats.deltas, 4U);
+
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::string loose = fs.make_path("objects/" + hashes[i].substr(0, 2) + "/" +
+                                         hashes[i].substr(2));
+        ASSERT_EQ(::unlink(loose.c_str()), 0);
+    }
+    minigit::ObjectStore store(root);
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::string body;
+        ASSERT_TRUE(store.read_object(hashes[i], body));
+        EXPECT_EQ(body, versions[i]);
+        minigit::ReadContext ctx;
+        minigit::ObjectType type = minigit::ObjectType::kNone;
+        std::size_t size = 0;
+        ASSERT_TRUE(store.read_object_info(hashes[i], ctx, type, size));
+        EXPECT_EQ(type, minigit::ObjectType::kBlob);
+        EXPECT_EQ(size, versions[i].size());
+    }
+}
+
+// 验证 delta 基准缓存：链上的基准只重建一次，随后的读取命中缓存
+TEST(DeltaTest, BaseCacheReusesReconstructedBases) {
+    char tmpl[] = "/tmp/minigit_delta_cacheXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+
+    std::string content;
+    for (int i = 0; i < 300; ++i) {
+        content += "row " + std::to_string(i) + "\n";
+    }
+    std::vector<std::string> hashes;
+    {
+        minigit::ObjectStore store(root);
+        for (int v = 0; v < 4; ++v) {
+            content += "rev " + std::to_string(v) + "\n";
+            hashes.push_back(store.store_blob(content));
+        }
+    }
+    minigit::PackOptions options;
+    options.window = 1;
+    minigit::PackStats stats;
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-cache.mpk", options, stats));
+    ASSERT_EQ(stats.deltas, 3U);
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::string loose = fs.make_path("objects/" + hashes[i].substr(0, 2) + "/" +
+                                         hashes[i].substr(2));
+        ASSERT_EQ(::unlink(loose.c_str()), 0);
+    }
+
+    minigit::ObjectStore store(root);
+    std::string body;
+    // 窗口为 1 时形成 rev3 <- rev2 <- rev1 <- rev0 的链，最小的 rev0 位于链尾
+    ASSERT_TRUE(store.read_object(hashes[0], body));
+    EXPECT_EQ(store.delta_base_cache_hits(), 0U);
+    ASSERT_TRUE(store.read_object(hashes[1], body));
+    EXPECT_EQ(store.delta_base_cache_hits(), 1U);
+
+    store.set_delta_base_cache_limit(0);
+    ASSERT_TRUE(store.read_object(hashes[2], body));
+    EXPECT_EQ(store.delta_base_cache_hits(), 1U);
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "commit.h"
+#include "fast_import.h"
+#include "filesystem.h"
+#include "index.h"
+#include "object_store.h"
+#include "refs.h"
+#include "tree.h"
+
+// 本文件包含针对 fast-import 流式导入的单元测试
+
+// 验证两次提交的导入结果：对象写入包文件、可读回，且 ref 指向最新提交
+TEST(FastImportTest, ImportsCommitsIntoPack) {
+    char tmpl[] = "/tmp/minigit_fast_importXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    minigit::FileSystem fs(dir);
+    minigit::ObjectStore store(dir);
+
+    std::string stream =
+        "blob\nmark :1\ndata 5\nhello\n"
+        "commit refs/heads/master\nmark :2\n"
+        "author A <a@x> 1700000000 +0000\n"
+        "committer A <a@x> 1700000000 +0000\n"
+        "data 6\nfirst\n"
+        "M 100644 :1 a.txt\nM 644 inline dir/b.txt\ndata <<EOF\nbee\nEOF\n\n"
+        "commit refs/heads/master\n"
+        "committer A <a@x> 1700000001 +0000\n"
+        "data 7\nsecond\n"
+        "D a.txt\nR dir/b.txt dir/c.txt\n\n"
+        "progress done importing\n"
+        "done\n";
+    std::istringstream in(stream);
+    std::ostringstream out;
+    std::ostringstream err;
+    minigit::FastImportStats stats;
+    ASSERT_EQ(minigit::run_fast_import(store, fs, in, out, err, stats), 0) << err.str();
+    EXPECT_EQ(out.str(), "progress done importing\n");
+    EXPECT_EQ(stats.commits, 2U);
+    EXPECT_EQ(stats.blobs, 2U);
+    EXPECT_EQ(stats.packs, 1U);
+    EXPECT_EQ(stats.refs, 1U);
+
+    std::string tip;
+    ASSERT_TRUE(minigit::read_ref(fs, "refs/heads/master", tip));
+    std::string loose = fs.make_path("objects/" + tip.substr(0, 2) + "/" + tip.substr(2));
+    EXPECT_NE(::access(loose.c_str(), F_OK), 0);
+
+    minigit::ReadContext ctx;
+    minigit::Commit c;
+    ASSERT_TRUE(minigit::read_commit(store, tip, ctx, c));
+    EXPECT_EQ(c.message, "second\n");
+    ASSERT_EQ(c.parents.size(), 1U);
+
+    std::vector<minigit::IndexEntry> files;
+    ASSERT_TRUE(minigit::flatten_tree_to_index(store, c.tree, files));
+    ASSERT_EQ(files.size(), 1U);
+    EXPECT_EQ(files[0].path, "dir/c.txt");
+    std::string body;
+    ASSERT_TRUE(store.read_object(files[0].hash, body));
+    EXPECT_EQ(body, "bee\n");
+}
+
+// 验证出错时不更新 ref 且报告行号
+TEST(FastImportTest, ErrorLeavesRefsUntouched) {
+    char tmpl[] = "/tmp/minigit_fast_import_errXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    minigit::FileSystem fs(dir);
+    minigit::ObjectStore store(dir);
+
+    std::istringstream in(
+        "commit refs/heads/master\n"
+        "committer A <a@x> 1700000000 +0000\n"
+        "data 2\nm\n"
+        "M 100644 :9 a.txt\n");
+    std::ostringstream out;
+    std::ostringstream err;
+    minigit::FastImportStats stats;
+    EXPECT_EQ(minigit::run_fast_import(store, fs, in, out, err, stats), 1);
+    EXPECT_NE(err.str().find("line 5"), std::string::npos);
+    std::string tip;
+    EXPECT_FALSE(minigit::read_ref(fs, "refs/heads/master", tip));
+}
+
+// 验证只接受已实现的特性，声明 feature done 后缺少 done 视为流被截断
+TEST(FastImportTest, RejectsUnsupportedFeatures) {
+    char tmpl[] = "/tmp/minigit_fast_import_featXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    minigit::FileSystem fs(dir);
+    minigit::ObjectStore store(dir);
+    const std::string body =
+        "commit refs/heads/master\n"
+        "committer A <a@x> 1700000000 +0000\n"
+        "data 2\nm\n"
+        "M 644 inline a.txt\ndata 2\na\n\n";
+
+    struct Case {
+        const char* stream_head;
+        const char* stream_tail;
+        int code;
+        const char* message;
+    };
+    const Case cases[] = {
+        {"feature done\nfeature date-format=raw\noption other-tool quiet\n", "done\n", 0, ""},
+        {"feature done\n", "", 1, "stream ended without done"},
+        {"feature export-marks=marks.txt\n", "", 1, "unsupported feature: export-marks"},
+        {"feature date-format=rfc2822\n", "", 1, "unsupported feature: date-format"},
+        {"option git quiet\n", "", 1, "unsupported option: git quiet"},
+    };
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        std::istringstream in(cases[i].stream_head + body + cases[i].stream_tail);
+        std::ostringstream out;
+        std::ostringstream err;
+        minigit::FastImportStats stats;
+        EXPECT_EQ(minigit::run_fast_import(store, fs, in, out, err, stats), cases[i].code)
+            << cases[i].stream_head << err.str();
+        EXPECT_NE(err.str().find(cases[i].message), std::string::npos) << err.str();
+    }
+}
+
+// 验证可执行位随文件写入 tree，并在重命名与后续提交重新加载 tree 后保留
+TEST(FastImportTest, KeepsExecutableMode) {
+    char tmpl[] = "/tmp/minigit_fast_import_modeXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    minigit::FileSystem fs(dir);
+    minigit::ObjectStore store(dir);
+
+    std::istringstream in(
+        "commit refs/heads/master\n"
+        "committer A <a@x> 1700000000 +0000\n"
+        "data 2\nm\n"
+        "M 755 inline run.sh\ndata 3\nrun\n"
+        "M 100644 inline bin/tool\ndata 5\ntool\n\n"
+        "checkpoint\n"
+        "commit refs/heads/master\n"
+        "committer A <a@x> 1700000001 +0000\n"
+        "data 2\nn\n"
+        "M 100755 inline bin/tool\ndata 5\ntool\n"
+        "R run.sh scripts/run.sh\n\n");
+    std::ostringstream out;
+    std::ostringstream err;
+    minigit::FastImportStats stats;
+    ASSERT_EQ(minigit::run_fast_import(store, fs, in, out, err, stats), 0) << err.str();
+
+    std::string tip;
+    ASSERT_TRUE(minigit::read_ref(fs, "refs/heads/master", tip));
+    minigit::ReadContext ctx;
+    minigit::Commit c;
+    ASSERT_TRUE(minigit::read_commit(store, tip, ctx, c));
+    std::string body;
+    ASSERT_TRUE(store.read_object(c.tree, body));
+    minigit::ObjectView view = {minigit::ObjectType::kTree, body.size(), body.data()};
+    std::vector<minigit::TreeEntry> root;
+    ASSERT_TRUE(minigit::parse_tree_object(view, root));
+    ASSERT_EQ(root.size(), 2U);
+    for (std::size_t i = 0; i < root.size(); ++i) {
+        std::string sub_body;
+        ASSERT_TRUE(store.read_object(root[i].hash, sub_body));
+        minigit::ObjectView sub = {minigit::ObjectType::kTree, sub_body.size(), sub_body.data()};
+        std::vector<minigit::TreeEntry> entries;
+        ASSERT_TRUE(minigit::parse_tree_object(sub, entries));
+        ASSERT_EQ(entries.size(), 1U);
+        EXPECT_EQ(entries[0].mode, "100755") << root[i].name << "/" << entries[0].name;
+    }
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "commit.h"
+#include "filesystem.h"
+#include "fsck.h"
+#include "object_store.h"
+#include "pack.h"
+#include "refs.h"
+#include "tree.h"
+#include "zlib_utils.h"
+
+// 本文件包含针对仓库完整性检查的单元测试
+
+// 写出 count 个线性提交，每个提交修改一个文件（内容带 tag 前缀），返回提交哈希列表
+static std::vector<std::string> write_history(minigit::ObjectStore& store,
+                                              const std::string& tag, int count,
+                                              std::vector<std::string>& blobs) {
+    std::vector<std::string> commits;
+    for (int i = 0; i < count; ++i) {
+        std::vector<minigit::TreeEntry> entries(1);
+        entries[0].mode = "100644";
+        entries[0].name = "file";
+        entries[0].hash = store.store_blob(tag + " version " + std::to_string(i) + "\n");
+        blobs.push_back(entries[0].hash);
+        minigit::Commit commit;
+        commit.tree = store.store_tree(minigit::build_tree_object(entries));
+        if (!commits.empty()) {
+            commit.parents.push_back(commits.back());
+        }
+        commit.author = "A <a@example.com> 0 +0000";
+        commit.committer = commit.author;
+        commit.message = "c" + std::to_string(i) + "\n";
+        commits.push_back(minigit::write_commit(store, commit));
+    }
+    return commits;
+}
+
+// 以旧版 MPK1 格式追加一个条目：40 位十六进制哈希 + 4 字节大端长度 + 压缩数据
+static void append_mpk1_entry(std::string& pack, const std::string& hash,
+                              const std::string& content) {
+    std::string compressed = minigit::zlib_compress(content);
+    pack.append(hash);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        pack.push_back(static_cast<char>((compressed.size() >> shift) & 0xff));
+    }
+    pack.append(compressed);
+}
+
+// 验证完好的仓库通过检查，缺失对象、内容被篡改与包损坏都能被发现
+TEST(FsckTest, DetectsMissingCorruptAndDamagedObjects) {
+    char tmpl[] = "/tmp/minigit_fsckXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::vector<std::string> blobs;
+    std::vector<std::string> commits = write_history(store, "old", 20, blobs);
+    ASSERT_TRUE(minigit::update_ref(fs, "refs/heads/master", commits.back()));
+    minigit::PackOptions pack_options;
+    minigit::PackStats stats;
+    std::string pack;
+    ASSERT_TRUE(minigit::repack_incremental(fs, pack_options, stats, pack));
+    std::vector<std::string> more = write_history(store, "new", 3, blobs);
+
+    minigit::FsckOptions options;
+    options.threads = 4;
+    minigit::FsckReport report;
+    EXPECT_TRUE(minigit::fsck_repository(fs, options, report));
+    EXPECT_TRUE(report.errors.empty());
+    EXPECT_EQ(report.packs, 1U);
+    EXPECT_EQ(report.packed_objects, 60U);
+    EXPECT_EQ(report.loose_objects, 9U);
+
+    // 删除被引用的松散 blob，并用另一个对象的内容冒充一个松散对象
+    std::string missing = blobs.back();
+    ASSERT_EQ(::unlink(fs.make_path("objects/" + missing.substr(0, 2) + "/" +
+                                    missing.substr(2)).c_str()), 0);
+    std::string forged = more[0];
+    std::string forged_path = "objects/" + forged.substr(0, 2) + "/" + forged.substr(2);
+    std::string other;
+    ASSERT_TRUE(fs.read_file("objects/" + more[1].substr(0, 2) + "/" + more[1].substr(2), other));
+    ::chmod(fs.make_path(forged_path).c_str(), 0644);
+    ASSERT_TRUE(fs.write_file(forged_path, other));
+
+    EXPECT_FALSE(minigit::fsck_repository(fs, options, report));
+    bool broken = false;
+    bool mismatch = false;
+    for (std::size_t i = 0; i < report.errors.size(); ++i) {
+        broken = broken || report.errors[i].find("broken link to " + missing) != std::string::npos;
+        mismatch = mismatch || report.errors[i] == forged + ": hash mismatch (loose)";
+    }
+    EXPECT_TRUE(broken);
+    EXPECT_TRUE(mismatch);
+
+    // 包文件中间的一个字节被翻转：条目 CRC 与整包校验和都不再匹配
+    std::string data;
+    ASSERT_TRUE(fs.read_file(pack, data));
+    data[data.size() / 2] = static_cast<char>(data[data.size() / 2] ^ 0x20);
+    ::chmod(fs.make_path(pack).c_str(), 0644);
+    ASSERT_TRUE(fs.write_file(pack, data));
+    EXPECT_FALSE(minigit::fsck_repository(fs, options, report));
+    bool crc = false;
+    bool checksum = false;
+    for (std::size_t i = 0; i < report.errors.size(); ++i) {
+        crc = crc || report.errors[i].find("crc mismatch") != std::string::npos;
+        checksum = checksum || report.errors[i] == pack + ": pack checksum mismatch";
+    }
+    EXPECT_TRUE(crc);
+    EXPECT_TRUE(checksum);
+}
+
+// 旧版 MPK1 包没有末尾校验和，不应报告校验和不匹配
+TEST(FsckTest, AcceptsLegacyMpk1PackWithoutTrailer) {
+    char tmpl[] = "/tmp/minigit_fsck_mpk1XXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::vector<std::string> blobs;
+    std::vector<std::string> commits = write_history(store, "legacy", 2, blobs);
+    ASSERT_TRUE(minigit::update_ref(fs, "refs/heads/master", commits.back()));
+
+    // 与旧版 pack 命令一样，把全部松散对象写入一个不带校验和的 MPK1 包
+    std::vector<std::string> loose;
+    minigit::list_loose_objects(fs, loose);
+    std::string pack("MPK1", 4);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        pack.push_back(static_cast<char>((loose.size() >> shift) & 0xff));
+    }
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        std::string rel = "objects/" + loose[i].substr(0, 2) + "/" + loose[i].substr(2);
+        std::string compressed;
+        ASSERT_TRUE(fs.read_file(rel, compressed));
+        append_mpk1_entry(pack, loose[i], minigit::zlib_decompress(compressed));
+        ASSERT_EQ(::unlink(fs.make_path(rel).c_str()), 0);
+    }
+    ASSERT_TRUE(fs.ensure_directory("objects/pack"));
+    ASSERT_TRUE(fs.write_file("objects/pack/pack.mpk", pack));
+    ASSERT_TRUE(minigit::index_pack_file(fs, "objects/pack/pack.mpk"));
+
+    minigit::FsckOptions options;
+    minigit::FsckReport report;
+    EXPECT_TRUE(minigit::fsck_repository(fs, options, report));
+    EXPECT_TRUE(report.errors.empty()) << report.errors[0];
+    EXPECT_EQ(report.packs, 1U);
+    EXPECT_EQ(report.packed_objects, loose.size());
+    EXPECT_EQ(report.loose_objects, 0U);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "commit.h"
+#include "filesystem.h"
+#include "fsck.h"
+#include "gc.h"
+#include "object_store.h"
+#include "pack.h"
+#include "refs.h"
+#include "tree.h"
+
+// 本文件包含针对垃圾回收的单元测试
+
+// 在 parent 之上写出 count 个线性提交，每个提交包含一个内容带 tag 前缀的文件
+static std::string write_branch(minigit::ObjectStore& store, const std::string& tag,
+                                std::string parent, int count) {
+    for (int i = 0; i < count; ++i) {
+        std::vector<minigit::TreeEntry> entries(1);
+        entries[0].mode = "100644";
+        entries[0].name = "file";
+        entries[0].hash = store.store_blob(tag + " version " + std::to_string(i) + "\n");
+        minigit::Commit commit;
+        commit.tree = store.store_tree(minigit::build_tree_object(entries));
+        if (!parent.empty()) {
+            commit.parents.push_back(parent);
+        }
+        commit.author = "A <a@example.com> 0 +0000";
+        commit.committer = commit.author;
+        commit.message = tag + std::to_string(i) + "\n";
+        parent = minigit::write_commit(store, commit);
+    }
+    return parent;
+}
+
+// 把文件的修改时间改为 days 天之前
+static void age_file(const std::string& path, int days) {
+    struct utimbuf times;
+    times.actime = std::time(nullptr) - days * 24 * 3600;
+    times.modtime = times.actime;
+    ASSERT_EQ(::utime(path.c_str(), &times), 0);
+}
+
+// 验证 gc 把可达对象合并为单个包，保留期内的不可达对象被保留，过期后才被删除
+TEST(GcTest, RepacksReachableAndPrunesExpiredUnreachable) {
+    char tmpl[] = "/tmp/minigit_gcXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    std::string master;
+    std::string stale_blob;
+    std::string fresh_blob;
+    {
+        minigit::ObjectStore store(root);
+        master = write_branch(store, "main", std::string(), 5);
+        std::string topic = write_branch(store, "topic", master, 2);
+        ASSERT_TRUE(minigit::update_ref(fs, "refs/heads/master", master));
+        ASSERT_TRUE(minigit::update_ref(fs, "refs/heads/topic", topic));
+        minigit::PackStats stats;
+        std::string pack;
+        ASSERT_TRUE(minigit::repack_incremental(fs, minigit::PackOptions(), stats, pack));
+        master = write_branch(store, "more", master, 1);
+        ASSERT_TRUE(minigit::update_ref(fs, "refs/heads/master", master));
+        stale_blob = store.store_blob("stale\n");
+        fresh_blob = store.store_blob("fresh\n");
+    }
+    age_file(fs.make_path("objects/" + stale_blob.substr(0, 2) + "/" + stale_blob.substr(2)), 30);
+    ASSERT_EQ(::unlink(fs.make_path("refs/heads/topic").c_str()), 0);
+
+    minigit::GcOptions options;
+    minigit::GcReport report;
+    ASSERT_TRUE(minigit::gc_repository(fs, options, report));
+    EXPECT_EQ(report.reachable, 18U);
+    EXPECT_EQ(report.pack.objects, 18U);
+    EXPECT_EQ(report.pack.merged_packs, 1U);
+    // 被删除分支的 6 个对象来自刚写入的包，仍在保留期内，改存为松散对象
+    EXPECT_EQ(report.loosened, 6U);
+    EXPECT_EQ(report.pruned, 1U);
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    EXPECT_EQ(packs.size(), 1U);
+    std::vector<std::string> loose;
+    minigit::list_loose_objects(fs, loose);
+    EXPECT_EQ(loose.size(), 7U);
+    EXPECT_FALSE(fs.exists("objects/" + stale_blob.substr(0, 2) + "/" + stale_blob.substr(2)));
+    EXPECT_TRUE(fs.exists("objects/" + fresh_blob.substr(0, 2) + "/" + fresh_blob.substr(2)));
+    minigit::FsckReport fsck;
+    EXPECT_TRUE(minigit::fsck_repository(fs, minigit::FsckOptions(), fsck));
+
+    // 保留期为 0 时全部不可达对象都被删除，可达对象不受影响
+    options.grace_seconds = 0;
+    for (std::size_t i = 0; i < loose.size(); ++i) {
+        age_file(fs.make_path("objects/" + loose[i].substr(0, 2) + "/" + loose[i].substr(2)), 1);
+    }
+    ASSERT_TRUE(minigit::gc_repository(fs, options, report));
+    EXPECT_EQ(report.loosened, 0U);
+    EXPECT_EQ(report.pruned, 7U);
+    EXPECT_EQ(report.pack.merged_packs, 0U);
+    minigit::list_loose_objects(fs, loose);
+    EXPECT_TRUE(loose.empty());
+    minigit::ObjectStore store(root);
+    std::string content;
+    EXPECT_TRUE(store.read_object(master, content));
+    EXPECT_TRUE(minigit::fsck_repository(fs, minigit::FsckOptions(), fsck));
+}
+
+// 验证重复写入已存在的对象会刷新松散文件或所在包的修改时间，gc 不会把它当作过期对象删除
+TEST(GcTest, RewritingExistingObjectKeepsItFromExpiring) {
+    char tmpl[] = "/tmp/minigit_gcXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    std::string packed_blob;
+    std::string loose_blob;
+    {
+        minigit::ObjectStore store(root);
+        packed_blob = store.store_blob("packed\n");
+        minigit::PackStats stats;
+        std::string pack;
+        ASSERT_TRUE(minigit::repack_incremental(fs, minigit::PackOptions(), stats, pack));
+        loose_blob = store.store_blob("loose\n");
+    }
+    std::string loose_path =
+        fs.make_path("objects/" + loose_blob.substr(0, 2) + "/" + loose_blob.substr(2));
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    ASSERT_EQ(packs.size(), 1U);
+    age_file(loose_path, 30);
+    age_file(fs.make_path(packs[0]), 30);
+    {
+        minigit::ObjectStore store(root);
+        EXPECT_EQ(store.store_blob("loose\n"), loose_blob);
+        EXPECT_EQ(store.store_blob("packed\n"), packed_blob);
+    }
+    struct stat st;
+    ASSERT_EQ(::stat(loose_path.c_str(), &st), 0);
+    EXPECT_GT(st.st_mtime, std::time(nullptr) - 3600);
+    ASSERT_EQ(::stat(fs.make_path(packs[0]).c_str(), &st), 0);
+    EXPECT_GT(st.st_mtime, std::time(nullptr) - 3600);
+
+    // 两个对象都不可达，但修改时间已刷新，仍在保留期内
+    minigit::GcReport report;
+    ASSERT_TRUE(minigit::gc_repository(fs, minigit::GcOptions(), report));
+    EXPECT_EQ(report.pruned, 0U);
+    EXPECT_EQ(report.loosened, 1U);
+    minigit::ObjectStore store(root);
+    std::string content;
+    EXPECT_TRUE(store.read_object(loose_blob, content));
+    EXPECT_TRUE(store.read_object(packed_blob, content));
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <string>
+
 #include "hash.h"
 
 // 本文件包含针对 SHA-1 哈希实现的单元测试
@@ -15,3 +18,39 @@ TEST(HashTest, HelloWorld) {
     EXPECT_EQ(minigit::sha1_hex("hello world"),
               "2aae6c35c94fcfb415dbe95f408b9ce91ee846ed");
 }
+
+// 验证分段增量计算与一次性计算的哈希结果一致
+TEST(HashTest, IncrementalSlicesMatchOneShot) {
+    std::string data(1000, 'x');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>('a' + (i % 26));
+    }
+
+    minigit::ByteSlice slices[3] = {
+        minigit::make_slice(data.data(), 7),
+        minigit::make_slice(data.data() + 7, 120),
+        minigit::make_slice(data.data() + 127, data.size() - 127),
+    };
+    EXPECT_EQ(minigit::sha1_hex(slices, 3), minigit::sha1_hex(data));
+}
+
+// 验证十六进制与二进制哈希互相转换可还原，且拒绝长度或字符不合法的输入
+TEST(HashTest, HexAndRawRoundTrip) {
+    const std::string hex = "2aae6c35c94fcfb415dbe95f408b9ce91ee846ed";
+    unsigned char raw[20];
+    ASSERT_TRUE(minigit::hex_to_raw(hex, raw));
+    EXPECT_EQ(raw[0], 0x2aU);
+    EXPECT_EQ(raw[19], 0xedU);
+    EXPECT_EQ(minigit::raw_to_hex(raw), hex);
+
+    unsigned char upper[20];
+    ASSERT_TRUE(minigit::hex_to_raw("2AAE6C35C94FCFB415DBE95F408B9CE91EE846ED", upper));
+    EXPECT_EQ(std::memcmp(raw, upper, 20U), 0);
+
+    std::string out = "reused";
+    minigit::raw_to_hex_into(raw, out);
+    EXPECT_EQ(out, hex);
+
+    EXPECT_FALSE(minigit::hex_to_raw(hex.substr(1), raw));
+    EXPECT_FALSE(minigit::hex_to_raw("g" + hex.substr(1), raw));
+}
@@ -72,3 +72,35 @@ TEST(IndexTest, UpsertEntryUpdatesOrAppends) {
     ASSERT_EQ(entries.size(), 2U);
 }
 
+
+// 验证 IndexCache 在文件未变化时复用条目，文件改写后重新加载
+TEST(IndexTest, CacheReloadsOnlyWhenFileChanges) {
+    char repo_tmpl[] = "/tmp/minigit_index_cacheXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    minigit::FileSystem fs(repo_dir_c);
+
+    minigit::IndexCache cache;
+    ASSERT_TRUE(cache.load(fs));
+    EXPECT_TRUE(cache.entries().empty());
+
+    std::vector<minigit::IndexEntry> entries;
+    minigit::IndexEntry e;
+    e.mode = "100644";
+    e.path = "a.txt";
+    e.hash = "1111111111111111111111111111111111111111";
+    entries.push_back(e);
+    ASSERT_TRUE(minigit::write_index(fs, entries));
+
+    ASSERT_TRUE(cache.load(fs));
+    ASSERT_EQ(cache.entries().size(), 1U);
+    ASSERT_TRUE(cache.load(fs));
+    ASSERT_EQ(cache.entries().size(), 1U);
+
+    e.path = "b.txt";
+    entries.push_back(e);
+    ASSERT_TRUE(minigit::write_index(fs, entries));
+    ASSERT_TRUE(cache.load(fs));
+    ASSERT_EQ(cache.entries().size(), 2U);
+    EXPECT_EQ(cache.entries()[1].path, "b.txt");
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "filesystem.h"
+#include "maintenance.h"
+#include "object_store.h"
+#include "pack.h"
+#include "pack_index.h"
+
+// 本文件包含针对自动维护的单元测试
+
+// 写入 blob 直到抽样目录 objects/17 中至少有 count 个对象，返回写入的对象总数
+static std::size_t fill_sample_dir(minigit::ObjectStore& store, std::size_t count) {
+    std::size_t written = 0;
+    std::size_t sampled = 0;
+    for (int i = 0; sampled < count; ++i) {
+        std::string hash = store.store_blob("loose object " + std::to_string(i) + "\n");
+        ++written;
+        if (hash.compare(0, 2, "17") == 0) {
+            ++sampled;
+        }
+    }
+    return written;
+}
+
+// 验证自动维护只在达到阈值时重打包、补写过期索引，并且不与持锁的进程并发执行
+TEST(MaintenanceTest, RepacksAtThresholdAndRefreshesIndexes) {
+    char tmpl[] = "/tmp/minigit_maintXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::size_t written = fill_sample_dir(store, 2);
+
+    minigit::MaintenanceOptions options;
+    options.loose_limit = 1024;
+    minigit::MaintenanceStatus status;
+    minigit::check_maintenance(fs, status);
+    EXPECT_EQ(status.loose_estimate, 512U);
+    EXPECT_EQ(status.packs, 0U);
+    EXPECT_FALSE(minigit::maintenance_due(options, status));
+
+    fill_sample_dir(store, 4);
+    minigit::check_maintenance(fs, status);
+    EXPECT_TRUE(minigit::maintenance_due(options, status));
+
+    // 另一个进程持有维护锁时跳过
+    {
+        minigit::MaintenanceLock held;
+        ASSERT_TRUE(held.try_acquire(fs));
+        minigit::MaintenanceReport report;
+        ASSERT_TRUE(minigit::run_maintenance(fs, options, true, report));
+        EXPECT_TRUE(report.skipped);
+    }
+
+    minigit::MaintenanceReport report;
+    ASSERT_TRUE(minigit::run_maintenance(fs, options, true, report));
+    EXPECT_FALSE(report.skipped);
+    EXPECT_TRUE(report.repacked);
+    EXPECT_FALSE(report.collected);
+    EXPECT_GT(report.pack.objects, written);
+    minigit::check_maintenance(fs, status);
+    EXPECT_EQ(status.loose_estimate, 0U);
+    EXPECT_EQ(status.packs, 1U);
+    EXPECT_EQ(status.stale_indexes, 0U);
+    EXPECT_FALSE(minigit::maintenance_due(options, status));
+
+    // 缺少反向索引与多包索引的包被视为过期，下一次维护只补写索引
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    ASSERT_EQ(packs.size(), 1U);
+    ASSERT_EQ(::unlink(fs.make_path(minigit::pack_sibling_path(packs[0], ".rev")).c_str()), 0);
+    ASSERT_EQ(::unlink(fs.make_path(std::string("objects/pack/") +
+                                    minigit::kMultiPackIndexName).c_str()), 0);
+    minigit::check_maintenance(fs, status);
+    EXPECT_EQ(status.stale_indexes, 1U);
+    EXPECT_TRUE(minigit::maintenance_due(options, status));
+    ASSERT_TRUE(minigit::run_maintenance(fs, options, true, report));
+    EXPECT_FALSE(report.repacked);
+    EXPECT_EQ(report.rev_written, 1U);
+    EXPECT_TRUE(report.midx_written);
+    minigit::check_maintenance(fs, status);
+    EXPECT_EQ(status.stale_indexes, 0U);
+}
@@ -1,11 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
+#include <map>
 #include <string>
+#include <vector>
 
 #include <unistd.h>
 
+#include "filesystem.h"
 #include "object_store.h"
+#include "pack.h"
 
 // 本文件包含针对对象存储 ObjectStore 的集成测试
 
@@ -26,3 +32,231 @@ TEST(ObjectStoreTest, StoreAndReadBlob) {
     EXPECT_TRUE(ok);
     EXPECT_EQ(out, data);
 }
+
+// 使用同一个读取上下文读取不同类型对象，验证类型、长度与正文视图
+TEST(ObjectStoreTest, ReadTypedViewWithReusableContext) {
+    char tmpl[] = "/tmp/minigit_testXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+
+    minigit::ObjectStore store(dir);
+    std::string blob_hash = store.store_blob("typed view");
+    std::string tree_content = "tree 0";
+    tree_content.push_back('\0');
+    std::string tree_hash = store.store_tree(tree_content);
+
+    minigit::ReadContext ctx;
+    minigit::ObjectView view;
+    ASSERT_TRUE(store.read_object(blob_hash, ctx, view));
+    EXPECT_EQ(view.type, minigit::ObjectType::kBlob);
+    EXPECT_EQ(std::string(view.data, view.size), "typed view");
+
+    ASSERT_TRUE(store.read_object(tree_hash, ctx, view));
+    EXPECT_EQ(view.type, minigit::ObjectType::kTree);
+    EXPECT_EQ(view.size, 0U);
+
+    EXPECT_FALSE(store.read_object("0000000000000000000000000000000000000000",
+                                   ctx, view));
+}
+
+// 批量读取包内与松散对象：每个对象只投递一次且内容正确，缺失对象与回调中止都返回 false
+TEST(ObjectStoreTest, ReadManyDeliversPackedAndLooseObjects) {
+    char tmpl[] = "/tmp/minigit_testXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+
+    std::string root(dir);
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 150; ++i) {
+        std::string data = "packed object " + std::to_string(i) + "\n";
+        expected[store.store_blob(data)] = data;
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-test.mpk"));
+    for (std::map<std::string, std::string>::const_iterator it = expected.begin();
+         it != expected.end(); ++it) {
+        ASSERT_EQ(::unlink(fs.make_path("objects/" + it->first.substr(0, 2) + "/" +
+                                        it->first.substr(2)).c_str()), 0);
+    }
+    for (int i = 0; i < 100; ++i) {
+        std::string data = "loose object " + std::to_string(i) + "\n";
+        expected[store.store_blob(data)] = data;
+    }
+
+    std::vector<std::string> hashes;
+    for (std::map<std::string, std::string>::const_iterator it = expected.begin();
+         it != expected.end(); ++it) {
+        hashes.push_back(it->first);
+        hashes.push_back(it->first);
+    }
+    std::map<std::string, std::string> delivered;
+    int calls = 0;
+    ASSERT_TRUE(store.read_many(
+        hashes,
+        [&](const std::string& hash, const minigit::ObjectView& view) {
+            ++calls;
+            EXPECT_EQ(view.type, minigit::ObjectType::kBlob);
+            delivered[hash].assign(view.data, view.size);
+            return true;
+        },
+        4));
+    EXPECT_EQ(calls, 250);
+    EXPECT_EQ(delivered, expected);
+
+    hashes.push_back("0000000000000000000000000000000000000000");
+    EXPECT_FALSE(store.read_many(
+        hashes, [](const std::string&, const minigit::ObjectView&) { return true; }, 2));
+    calls = 0;
+    EXPECT_FALSE(store.read_many(
+        hashes, [&calls](const std::string&, const minigit::ObjectView&) { return ++calls < 10; },
+        1));
+    EXPECT_EQ(calls, 10);
+
+    // 工作线程的包集合跨调用复用，之后新增的包也要能读到
+    std::map<std::string, std::string> later;
+    for (int i = 0; i < 100; ++i) {
+        std::string data = "later object " + std::to_string(i) + "\n";
+        later[store.store_blob(data)] = data;
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-later.mpk"));
+    hashes.clear();
+    for (std::map<std::string, std::string>::const_iterator it = later.begin();
+         it != later.end(); ++it) {
+        ASSERT_EQ(::unlink(fs.make_path("objects/" + it->first.substr(0, 2) + "/" +
+                                        it->first.substr(2)).c_str()), 0);
+        hashes.push_back(it->first);
+    }
+    delivered.clear();
+    ASSERT_TRUE(store.read_many(
+        hashes,
+        [&](const std::string& hash, const minigit::ObjectView& view) {
+            delivered[hash].assign(view.data, view.size);
+            return true;
+        },
+        4));
+    EXPECT_EQ(delivered, later);
+}
+
+// 缩写在松散对象与包内对象中查找的结果应与逐个比较的结果一致，最短缩写应唯一
+TEST(ObjectStoreTest, ResolvesAbbreviatedHashes) {
+    char tmpl[] = "/tmp/minigit_testXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+
+    std::string root(dir);
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::vector<std::string> all;
+    for (int i = 0; i < 400; ++i) {
+        all.push_back(store.store_blob("abbrev packed " + std::to_string(i)));
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-abbrev.mpk"));
+    ASSERT_TRUE(minigit::update_multi_pack_index(fs));
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        ASSERT_EQ(::unlink(fs.make_path("objects/" + all[i].substr(0, 2) + "/" +
+                                        all[i].substr(2)).c_str()), 0);
+    }
+    for (int i = 0; i < 400; ++i) {
+        all.push_back(store.store_blob("abbrev loose " + std::to_string(i)));
+    }
+
+    std::size_t ambiguous = 0;
+    std::vector<std::string> matches;
+    // 缩写必须唯一，且去掉最后一位后必须有歧义
+    auto check_all = [&]() {
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            std::string prefix = all[i].substr(0, 4);
+            std::vector<std::string> expected;
+            for (std::size_t k = 0; k < all.size(); ++k) {
+                if (all[k].compare(0, 4, prefix) == 0) {
+                    expected.push_back(all[k]);
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            ASSERT_TRUE(store.find_objects_by_prefix(prefix, 100, matches));
+            EXPECT_EQ(matches, expected);
+            ambiguous += expected.size() > 1U ? 1U : 0U;
+
+            std::string abbrev = store.abbreviate(all[i], 4);
+            ASSERT_TRUE(store.find_objects_by_prefix(abbrev, 2, matches));
+            ASSERT_EQ(matches.size(), 1U);
+            EXPECT_EQ(matches[0], all[i]);
+            if (abbrev.size() > 4U) {
+                ASSERT_TRUE(store.find_objects_by_prefix(abbrev.substr(0, abbrev.size() - 1U),
+                                                         2, matches));
+                EXPECT_EQ(matches.size(), 2U);
+            }
+        }
+    };
+    check_all();
+    // 800 个对象在 65536 种 4 位前缀中几乎必然发生碰撞，确保歧义路径被覆盖
+    EXPECT_GT(ambiguous, 0U);
+
+    // bulk check-in 中尚未落盘的对象同样参与匹配与缩写
+    ASSERT_TRUE(store.begin_bulk_checkin());
+    for (int i = 0; i < 400; ++i) {
+        all.push_back(store.store_blob("abbrev bulk " + std::to_string(i)));
+    }
+    check_all();
+    // 落盘后的包不在多包索引中，按单个包索引查找
+    ASSERT_TRUE(store.end_bulk_checkin());
+    check_all();
+
+    std::string upper = all[0].substr(0, 8);
+    for (std::size_t i = 0; i < upper.size(); ++i) {
+        upper[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(upper[i])));
+    }
+    ASSERT_TRUE(store.find_objects_by_prefix(upper, 2, matches));
+    ASSERT_EQ(matches.size(), 1U);
+    EXPECT_EQ(matches[0], all[0]);
+    EXPECT_FALSE(store.find_objects_by_prefix(all[0].substr(0, 3), 2, matches));
+    EXPECT_FALSE(store.find_objects_by_prefix("xyz12", 2, matches));
+}
+
+// 批量写入期间新对象进入同一个临时包且可读，结束后落盘为一个包，不产生松散对象
+TEST(ObjectStoreTest, BulkCheckinWritesObjectsIntoOnePack) {
+    char tmpl[] = "/tmp/minigit_testXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+
+    std::string root(dir);
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::string existing = store.store_blob("already loose");
+
+    ASSERT_TRUE(store.begin_bulk_checkin());
+    std::vector<std::string> hashes;
+    for (int i = 0; i < 200; ++i) {
+        hashes.push_back(store.store_blob("bulk object " + std::to_string(i)));
+    }
+    EXPECT_EQ(store.store_blob("bulk object 0"), hashes[0]);
+    EXPECT_EQ(store.store_blob("already loose"), existing);
+    std::string out;
+    ASSERT_TRUE(store.read_object(hashes[7], out));
+    EXPECT_EQ(out, "bulk object 7");
+    EXPECT_TRUE(store.has_object(hashes[199]));
+    std::vector<std::string> loose;
+    minigit::list_loose_objects(fs, loose);
+    EXPECT_EQ(loose.size(), 1U);
+    ASSERT_TRUE(store.end_bulk_checkin());
+    EXPECT_FALSE(store.end_bulk_checkin());
+
+    std::vector<std::string> packs;
+    minigit::list_pack_files(fs, packs);
+    ASSERT_EQ(packs.size(), 1U);
+    minigit::list_loose_objects(fs, loose);
+    EXPECT_EQ(loose.size(), 1U);
+    minigit::ObjectStore reopened(root);
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        ASSERT_TRUE(reopened.read_object(hashes[i], out));
+        EXPECT_EQ(out, "bulk object " + std::to_string(i));
+    }
+
+    // 没有写入新对象的批量写入不留下包
+    ASSERT_TRUE(store.begin_bulk_checkin());
+    store.store_blob("bulk object 3");
+    ASSERT_TRUE(store.end_bulk_checkin());
+    minigit::list_pack_files(fs, packs);
+    EXPECT_EQ(packs.size(), 1U);
+}
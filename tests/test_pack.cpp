@@ -1,7 +1,17 @@
 ﻿#include "gtest/gtest.h"
 
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <set>
+#include <unordered_set>
+
+#include "commit.h"
+#include "delta.h"
+#include "hash.h"
 #include "object_store.h"
 #include "pack.h"
+#include "tree.h"
 #include "zlib_utils.h"
 
 TEST(PackfileTest, WriteAndReadPackfile) {
@@ -38,3 +48,520 @@ TEST(PackfileTest, WriteAndReadPackfile) {
     check_hash(h2);
 }
 
+TEST(PackfileTest, ReaderIteratesAndInflatesEntries) {
+    char repo_tmpl[] = "/tmp/minigit_pack_readerXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string repo_dir(repo_dir_c);
+
+    minigit::ObjectStore store(repo_dir + "/.minigit");
+    minigit::FileSystem fs(repo_dir + "/.minigit");
+    std::string h1 = store.store_blob("alpha");
+    std::string h2 = store.store_blob("beta");
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/test.mpk"));
+
+    minigit::PackReader reader;
+    ASSERT_TRUE(reader.open(fs.make_path("objects/pack/test.mpk"),
+                            minigit::PackReader::Access::kSequential));
+    ASSERT_EQ(reader.count(), 2U);
+    EXPECT_TRUE(reader.verify_checksum());
+
+    EXPECT_EQ(reader.version(), 2);
+
+    // MPK2 条目不含 ID，按偏移从 .idx 中取得哈希
+    minigit::PackIndex index;
+    ASSERT_TRUE(index.open(fs.make_path("objects/pack/test.idx")));
+    std::map<std::uint64_t, std::string> names;
+    for (std::size_t i = 0; i < index.count(); ++i) {
+        names[index.offset_at(i)] = index.hash_at(i);
+    }
+    std::map<std::string, std::string> objects;
+    std::uint64_t offset = reader.first_offset();
+    for (std::uint32_t i = 0; i < reader.count(); ++i) {
+        minigit::PackEntryView entry;
+        ASSERT_TRUE(reader.entry_at(offset, entry));
+        EXPECT_EQ(entry.hash, nullptr);
+        EXPECT_EQ(entry.type, minigit::PackEntryType::kBlob);
+        std::string inflated;
+        ASSERT_TRUE(reader.inflate(entry, inflated));
+        EXPECT_EQ(entry.object_size + 7U, inflated.size());
+        objects[names[offset]] = inflated;
+        offset = entry.next;
+    }
+    minigit::PackEntryView past_end;
+    EXPECT_FALSE(reader.entry_at(offset, past_end));
+    EXPECT_EQ(objects[h1], std::string("blob 5\0alpha", 12));
+    EXPECT_EQ(objects[h2], std::string("blob 4\0beta", 11));
+}
+
+// 追加一个 MPK1 条目："40 位哈希 + u32 大端长度 + 压缩数据"
+static void append_mpk1_entry(std::string& pack, const std::string& hash,
+                              const std::string& content) {
+    std::string compressed = minigit::zlib_compress(content);
+    pack.append(hash);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        pack.push_back(static_cast<char>((compressed.size() >> shift) & 0xff));
+    }
+    pack.append(compressed);
+}
+
+TEST(PackfileTest, ReadsLegacyMpk1AndRepacksAsMpk2) {
+    char repo_tmpl[] = "/tmp/minigit_pack_legacyXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    ASSERT_TRUE(fs.ensure_directory("objects/pack"));
+
+    std::string base_body(300, 'x');
+    std::string target_body = base_body + "tail";
+    std::string base = "blob " + std::to_string(base_body.size()) + std::string(1, '\0') + base_body;
+    std::string target =
+        "blob " + std::to_string(target_body.size()) + std::string(1, '\0') + target_body;
+    std::string base_hash = minigit::sha1_hex(base);
+    std::string target_hash = minigit::sha1_hex(target);
+    minigit::DeltaIndex delta_index(base.data(), base.size());
+    std::string delta;
+    ASSERT_TRUE(minigit::create_delta(delta_index, target.data(), target.size(), 0, delta));
+    std::string legacy_delta = "delta " + std::to_string(40 + delta.size()) +
+                               std::string(1, '\0') + base_hash + delta;
+
+    std::string pack("MPK1\0\0\0\2", 8);
+    append_mpk1_entry(pack, base_hash, base);
+    append_mpk1_entry(pack, target_hash, legacy_delta);
+    // 与旧版 pack 命令写出的文件一致，MPK1 没有末尾校验和
+    ASSERT_TRUE(fs.write_file("objects/pack/pack-legacy.mpk", pack));
+
+    std::map<std::string, minigit::PackedEntry> entries;
+    ASSERT_TRUE(minigit::read_pack_file(fs, "objects/pack/pack-legacy.mpk", entries));
+    EXPECT_EQ(entries.size(), 2U);
+
+    {
+        minigit::ObjectStore store(root);
+        std::string body;
+        ASSERT_TRUE(store.read_object(target_hash, body));
+        EXPECT_EQ(body, target_body);
+    }
+
+    // 条目占用之和覆盖包头之后的全部字节，反向索引与整个文件的 SHA-1 绑定
+    std::vector<minigit::PackObjectSize> sizes;
+    ASSERT_TRUE(minigit::pack_object_sizes(fs, "objects/pack/pack-legacy.mpk", sizes));
+    ASSERT_EQ(sizes.size(), 2U);
+    EXPECT_EQ(sizes[0].disk_size + sizes[1].disk_size, pack.size() - 8U);
+    {
+        minigit::PackReader legacy;
+        ASSERT_TRUE(legacy.open(fs.make_path("objects/pack/pack-legacy.mpk")));
+        EXPECT_EQ(legacy.checksum(), nullptr);
+        minigit::Sha1 sha;
+        sha.update(pack.data(), pack.size());
+        unsigned char whole[20];
+        sha.final_raw(whole);
+        minigit::PackReverseIndex rev;
+        EXPECT_TRUE(rev.open(fs.make_path("objects/pack/pack-legacy.rev"), 2U, whole));
+    }
+
+    // 合并后的新包为 MPK2，MPK1 的 delta 转换为按偏移引用基准的 delta
+    minigit::PackOptions options;
+    options.all = true;
+    minigit::PackStats stats;
+    std::string path;
+    std::string other = minigit::ObjectStore(root).store_blob("fresh");
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, 3U);
+    EXPECT_EQ(stats.deltas, 1U);
+    EXPECT_FALSE(fs.exists("objects/pack/pack-legacy.mpk"));
+
+    minigit::PackReader reader;
+    ASSERT_TRUE(reader.open(fs.make_path(path)));
+    EXPECT_EQ(reader.version(), 2);
+    entries.clear();
+    ASSERT_TRUE(minigit::read_pack_file(fs, path, entries));
+    ASSERT_EQ(entries.size(), 3U);
+    EXPECT_EQ(minigit::zlib_decompress(entries[target_hash].compressed), target);
+
+    minigit::ObjectStore store(root);
+    std::string body;
+    ASSERT_TRUE(store.read_object(target_hash, body));
+    EXPECT_EQ(body, target_body);
+    ASSERT_TRUE(store.read_object(other, body));
+    EXPECT_EQ(body, "fresh");
+}
+
+// 统计 objects/pack 下的包文件数量
+static std::size_t count_packs(const minigit::FileSystem& fs) {
+    std::size_t n = 0;
+    DIR* d = opendir(fs.make_path("objects/pack").c_str());
+    if (!d) {
+        return 0;
+    }
+    while (dirent* de = readdir(d)) {
+        std::string name = de->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mpk") == 0) {
+            ++n;
+        }
+    }
+    closedir(d);
+    return n;
+}
+
+TEST(PackfileTest, IncrementalRepackKeepsGeometricProgression) {
+    char repo_tmpl[] = "/tmp/minigit_pack_geometricXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::PackOptions options;
+    minigit::PackStats stats;
+    std::string path;
+    std::vector<std::string> hashes;
+
+    minigit::ObjectStore store(root);
+    for (int i = 0; i < 12; ++i) {
+        hashes.push_back(store.store_blob("object " + std::to_string(i)));
+    }
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, 12U);
+    EXPECT_FALSE(fs.exists("objects/" + hashes[0].substr(0, 2) + "/" + hashes[0].substr(2)));
+
+    // 没有新对象时不写入新包
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_TRUE(path.empty());
+
+    // 新对象远少于已有的包：单独成包，大包保持不动
+    hashes.push_back(store.store_blob("small 1"));
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, 1U);
+    EXPECT_EQ(stats.merged_packs, 0U);
+    EXPECT_EQ(count_packs(fs), 2U);
+
+    // 再来一个对象：只与最小的包合并
+    hashes.push_back(store.store_blob("small 2"));
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, 2U);
+    EXPECT_EQ(stats.merged_packs, 1U);
+    EXPECT_EQ(count_packs(fs), 2U);
+
+    // 新对象足够多时逐级吸收全部较小的包
+    for (int i = 0; i < 20; ++i) {
+        hashes.push_back(store.store_blob("batch " + std::to_string(i)));
+    }
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, hashes.size());
+    EXPECT_EQ(stats.merged_packs, 2U);
+    EXPECT_EQ(count_packs(fs), 1U);
+
+    minigit::ObjectStore reopened(root);
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        std::string body;
+        EXPECT_TRUE(reopened.read_object(hashes[i], body));
+    }
+}
+
+TEST(PackfileTest, ThreadedPackingIsDeterministic) {
+    char repo_tmpl[] = "/tmp/minigit_pack_threadsXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+
+    // 600 个相似的对象跨越多个 256 个对象的分段，段内可以互相做 delta
+    std::string body;
+    for (int line = 0; line < 40; ++line) {
+        body += "shared line " + std::to_string(line) + " of the sample document\n";
+    }
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 600; ++i) {
+        std::string data = body + "revision " + std::to_string(i) + "\n";
+        expected[store.store_blob(data)] = data;
+    }
+
+    minigit::PackOptions options;
+    minigit::PackStats single;
+    minigit::PackStats threaded;
+    options.threads = 1;
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/single.mpk", options, single));
+    options.threads = 4;
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/threaded.mpk", options, threaded));
+    EXPECT_EQ(single.objects, 600U);
+    EXPECT_EQ(threaded.objects, 600U);
+    EXPECT_GT(threaded.deltas, 0U);
+    EXPECT_EQ(threaded.deltas, single.deltas);
+
+    std::string single_bytes;
+    std::string threaded_bytes;
+    ASSERT_TRUE(fs.read_file("objects/pack/single.mpk", single_bytes));
+    ASSERT_TRUE(fs.read_file("objects/pack/threaded.mpk", threaded_bytes));
+    EXPECT_TRUE(single_bytes == threaded_bytes);
+
+    minigit::PackSet packs(root);
+    for (std::map<std::string, std::string>::const_iterator it = expected.begin();
+         it != expected.end(); ++it) {
+        std::string inflated;
+        ASSERT_TRUE(packs.read_object(it->first, inflated));
+        minigit::ObjectType type = minigit::ObjectType::kNone;
+        std::size_t size = 0;
+        std::size_t header_len = 0;
+        ASSERT_TRUE(minigit::parse_object_header(inflated.data(), inflated.size(), type, size,
+                                                 header_len));
+        EXPECT_EQ(inflated.substr(header_len), it->second);
+    }
+}
+
+TEST(PackfileTest, PackSetDropsPacksRemovedByRepack) {
+    char repo_tmpl[] = "/tmp/minigit_pack_refreshXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::PackOptions options;
+    minigit::PackStats stats;
+    std::string path;
+
+    minigit::ObjectStore store(root);
+    std::string first = store.store_blob("first");
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    minigit::PackSet packs(root);
+    ASSERT_TRUE(packs.contains(first));
+
+    // 全量重打包删除旧包后，只应从新包中找到对象，不再保留旧包的映射
+    std::string second = store.store_blob("second");
+    options.all = true;
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.merged_packs, 1U);
+    EXPECT_TRUE(packs.contains(second));
+    std::vector<std::string> matches;
+    packs.find_prefix(first, 4, matches);
+    EXPECT_EQ(matches.size(), 1U);
+    std::string body;
+    EXPECT_TRUE(packs.read_object(first, body));
+}
+
+TEST(PackfileTest, RepackKeepsLooseObjectsThatWereNotPacked) {
+    char repo_tmpl[] = "/tmp/minigit_pack_pruneXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::PackOptions options;
+    minigit::PackStats stats;
+    std::string path;
+
+    minigit::ObjectStore store(root);
+    std::string good = store.store_blob("packed");
+    std::string bad = store.store_blob("damaged");
+    std::string bad_rel = "objects/" + bad.substr(0, 2) + "/" + bad.substr(2);
+    ASSERT_TRUE(fs.write_file(bad_rel, "not zlib"));
+
+    // 无法读取的松散对象不会进入新包，也不能被当作已入包而删除
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, path));
+    EXPECT_EQ(stats.objects, 1U);
+    EXPECT_FALSE(fs.exists("objects/" + good.substr(0, 2) + "/" + good.substr(2)));
+    EXPECT_TRUE(fs.exists(bad_rel));
+
+    std::unordered_set<std::string> keep;
+    keep.insert(good);
+    keep.insert(bad);
+    ASSERT_TRUE(minigit::repack_objects(fs, options, keep, stats, path));
+    EXPECT_TRUE(fs.exists(bad_rel));
+    minigit::ObjectStore reopened(root);
+    std::string body;
+    EXPECT_TRUE(reopened.read_object(good, body));
+}
+
+TEST(PackfileTest, RepackCopiesEntriesVerbatimAndChecksCrc) {
+    char repo_tmpl[] = "/tmp/minigit_pack_reuseXXXXXX";
+    char* repo_dir_c = mkdtemp(repo_tmpl);
+    ASSERT_NE(repo_dir_c, nullptr);
+    std::string root = std::string(repo_dir_c) + "/.minigit";
+    minigit::FileSystem fs(root);
+    minigit::ObjectStore store(root);
+    std::string text;
+    for (int i = 0; i < 10; ++i) {
+        text += "line " + std::to_string(i) + " of a file that grows a little each version\n";
+        store.store_blob(text);
+    }
+    minigit::PackOptions options;
+    minigit::PackStats stats;
+    std::string first;
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, first));
+    std::size_t deltas = stats.deltas;
+    EXPECT_GT(deltas, 0U);
+
+    // 合并时旧包的条目全部原样复制，delta 保持为 delta
+    store.store_blob("fresh object");
+    options.all = true;
+    std::string second;
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, second));
+    EXPECT_EQ(stats.objects, 11U);
+    EXPECT_EQ(stats.reused, 10U);
+    EXPECT_EQ(stats.deltas, deltas);
+
+    // 条目数据损坏时 CRC 校验失败，不会生成新包，旧包保持不动
+    std::string data;
+    ASSERT_TRUE(fs.read_file(second, data));
+    data[12] = static_cast<char>(data[12] ^ 0x55);
+    ::chmod(fs.make_path(second).c_str(), 0644);
+    ASSERT_TRUE(fs.write_file(second, data));
+    store.store_blob("another object");
+    std::string third;
+    EXPECT_FALSE(minigit::repack_incremental(fs, options, stats, third));
+    EXPECT_TRUE(fs.exists(second));
+}
+
+// 验证包内先是按时间由新到旧的提交，再是按检出顺序排列的 tree 与 blob
+TEST(PackfileTest, WritesObjectsInAccessOrder) {
+    char tmpl[] = "/tmp/minigit_pack_orderXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::ObjectStore store(root);
+    minigit::FileSystem fs(root);
+
+    std::vector<std::string> expected_commits;
+    std::vector<std::string> expected_objects;
+    std::string parent;
+    for (int i = 0; i < 3; ++i) {
+        std::string n = std::to_string(i);
+        std::vector<minigit::TreeEntry> sub(1);
+        sub[0].mode = "100644";
+        sub[0].name = "b.txt";
+        sub[0].hash = store.store_blob("b " + n + "\n");
+        std::vector<minigit::TreeEntry> top(2);
+        top[0].mode = "100644";
+        top[0].name = "a.txt";
+        top[0].hash = store.store_blob("a " + n + "\n");
+        top[1].mode = "40000";
+        top[1].name = "dir";
+        top[1].hash = store.store_tree(minigit::build_tree_object(sub));
+        minigit::Commit commit;
+        commit.tree = store.store_tree(minigit::build_tree_object(top));
+        if (!parent.empty()) {
+            commit.parents.push_back(parent);
+        }
+        commit.author = "A <a@example.com> " + std::to_string(1000 + i) + " +0000";
+        commit.committer = commit.author;
+        commit.message = "c" + n + "\n";
+        parent = minigit::write_commit(store, commit);
+        expected_commits.insert(expected_commits.begin(), parent);
+        const std::string checkout[] = {commit.tree, top[0].hash, top[1].hash, sub[0].hash};
+        expected_objects.insert(expected_objects.begin(), checkout, checkout + 4);
+    }
+
+    minigit::PackOptions options;
+    options.window = 0;
+    minigit::PackStats stats;
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/order.mpk", options, stats));
+    std::vector<minigit::PackObjectSize> sizes;
+    ASSERT_TRUE(minigit::pack_object_sizes(fs, "objects/pack/order.mpk", sizes));
+    std::vector<std::string> order;
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        order.push_back(sizes[i].hash);
+    }
+    std::vector<std::string> expected(expected_commits);
+    expected.insert(expected.end(), expected_objects.begin(), expected_objects.end());
+    EXPECT_EQ(order, expected);
+}
+
+// 验证提交与 tree 以未压缩条目存放并可原地读取，已有包在重打包时随之转换
+TEST(PackfileTest, StoresMetadataUncompressed) {
+    char tmpl[] = "/tmp/minigit_pack_storedXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+
+    std::vector<std::string> commits;
+    std::set<std::string> metadata;
+    std::string payload(4096, 'x');
+    {
+        minigit::ObjectStore store(root);
+        for (int i = 0; i < 8; ++i) {
+            std::vector<minigit::TreeEntry> entries(2);
+            entries[0].mode = "100644";
+            entries[0].name = "a-rather-long-file-name-that-makes-trees-delta-well.txt";
+            entries[0].hash = store.store_blob(payload + std::to_string(i));
+            entries[1].mode = "100644";
+            entries[1].name = "another-rather-long-file-name-for-the-same-reason.txt";
+            entries[1].hash = store.store_blob("counter " + std::to_string(i) + "\n");
+            minigit::Commit commit;
+            commit.tree = store.store_tree(minigit::build_tree_object(entries));
+            if (!commits.empty()) {
+                commit.parents.push_back(commits.back());
+            }
+            commit.author = "A <a@example.com> 0 +0000";
+            commit.committer = commit.author;
+            commit.message = "a commit message long enough to be worth a delta " +
+                             std::to_string(i) + "\n";
+            commits.push_back(minigit::write_commit(store, commit));
+            metadata.insert(commits.back());
+            metadata.insert(commit.tree);
+        }
+    }
+    minigit::PackOptions options;
+    minigit::PackStats stats;
+    std::string pack;
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, pack));
+
+    minigit::PackIndex index;
+    ASSERT_TRUE(index.open(fs.make_path(minigit::pack_sibling_path(pack, ".idx"))));
+    std::unordered_set<std::string> keep;
+    for (std::size_t i = 0; i < index.count(); ++i) {
+        keep.insert(index.hash_at(i));
+    }
+    options.uncompressed_metadata = true;
+    std::string old_pack = pack;
+    ASSERT_TRUE(minigit::repack_objects(fs, options, keep, stats, pack));
+    // 对象集合不变但内容不同：包按校验和命名，得到新名字并删除旧包，而不是原地覆盖
+    EXPECT_EQ(stats.objects, 32U);
+    EXPECT_EQ(stats.merged_packs, 1U);
+    EXPECT_NE(pack, old_pack);
+    EXPECT_FALSE(fs.exists(old_pack));
+    EXPECT_FALSE(fs.exists(minigit::pack_sibling_path(old_pack, ".idx")));
+    minigit::PackReader reader;
+    ASSERT_TRUE(index.open(fs.make_path(minigit::pack_sibling_path(pack, ".idx"))));
+    ASSERT_TRUE(reader.open(fs.make_path(pack)));
+    std::size_t stored = 0;
+    std::size_t blob_deltas = 0;
+    for (std::size_t i = 0; i < index.count(); ++i) {
+        minigit::PackEntryView entry;
+        ASSERT_TRUE(reader.entry_at(index.offset_at(i), entry));
+        bool is_metadata = metadata.count(index.hash_at(i)) != 0;
+        EXPECT_EQ(entry.type == minigit::PackEntryType::kStored, is_metadata);
+        stored += entry.type == minigit::PackEntryType::kStored ? 1U : 0U;
+        blob_deltas += entry.type == minigit::PackEntryType::kOfsDelta ? 1U : 0U;
+    }
+    EXPECT_EQ(stored, 16U);
+    EXPECT_GT(blob_deltas, 0U);
+
+    // 未压缩条目直接在映射区域中解析，不使用上下文的解压缓冲区
+    minigit::ObjectStore store(root);
+    minigit::ReadContext ctx;
+    minigit::ObjectView view;
+    ASSERT_TRUE(store.read_object(commits.back(), ctx, view));
+    EXPECT_EQ(view.type, minigit::ObjectType::kCommit);
+    EXPECT_TRUE(ctx.inflated.empty());
+    minigit::Commit commit;
+    ASSERT_TRUE(minigit::parse_commit_object(view, commit));
+    EXPECT_EQ(commit.parents, std::vector<std::string>(1, commits[6]));
+    minigit::ObjectType type = minigit::ObjectType::kNone;
+    std::size_t size = 0;
+    ASSERT_TRUE(store.read_object_info(commit.tree, ctx, type, size));
+    EXPECT_EQ(type, minigit::ObjectType::kTree);
+    std::string content;
+    ASSERT_TRUE(store.read_object(commits[0], content));
+    EXPECT_EQ(content.find("tree "), 0U);
+
+    // 视图所在的包被重打包删除并移出包集合后，上下文持有的映射仍然有效
+    minigit::ReadContext held;
+    ASSERT_TRUE(store.read_object(commits.back(), held, view));
+    EXPECT_TRUE(held.mapping != nullptr);
+    std::string copy(view.data, view.size);
+    std::string fresh = store.store_blob("fresh object");
+    options.all = true;
+    std::string viewed_pack = pack;
+    ASSERT_TRUE(minigit::repack_incremental(fs, options, stats, pack));
+    EXPECT_FALSE(fs.exists(viewed_pack));
+    ASSERT_TRUE(store.read_object(fresh, content));
+    EXPECT_EQ(std::string(view.data, view.size), copy);
+}
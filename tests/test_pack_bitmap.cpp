@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "commit.h"
+#include "ewah.h"
+#include "filesystem.h"
+#include "object_store.h"
+#include "pack.h"
+#include "pack_bitmap.h"
+#include "tree.h"
+
+// 本文件包含针对 EWAH 编码与可达性位图的单元测试
+
+// 验证包含连续段与稀疏位的位图编码后可以原样解码，集合运算结果正确
+TEST(PackBitmapTest, EwahRoundtripAndSetOperations) {
+    minigit::Bitmap a;
+    for (std::size_t i = 0; i < 300; ++i) {
+        a.set(i);
+    }
+    a.set(1000);
+    a.set(70000);
+    std::string encoded;
+    minigit::ewah_encode(a, encoded);
+    EXPECT_LT(encoded.size(), 100U);
+
+    minigit::Bitmap decoded;
+    std::size_t used = 0;
+    ASSERT_TRUE(minigit::ewah_decode(encoded.data(), encoded.size(), decoded, used));
+    EXPECT_EQ(used, encoded.size());
+    EXPECT_EQ(decoded.words(), a.words());
+    EXPECT_EQ(decoded.count(), 302U);
+    EXPECT_FALSE(minigit::ewah_decode(encoded.data(), encoded.size() - 1, decoded, used));
+
+    minigit::Bitmap b;
+    b.set(5);
+    b.set(1000);
+    a.and_not(b);
+    EXPECT_EQ(a.count(), 300U);
+    EXPECT_FALSE(a.get(5));
+    std::vector<std::size_t> positions;
+    a.positions(positions);
+    ASSERT_EQ(positions.size(), 300U);
+    EXPECT_EQ(positions[4], 4U);
+    EXPECT_EQ(positions[5], 6U);
+    EXPECT_EQ(positions.back(), 70000U);
+}
+
+// 验证位图回答的可达性查询与逐个对象遍历的结果一致
+TEST(PackBitmapTest, BitmapsMatchTraversal) {
+    char tmpl[] = "/tmp/minigit_bitmapXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+
+    std::vector<std::string> commits;
+    {
+        minigit::ObjectStore store(root);
+        std::string shared = store.store_blob("shared\n");
+        for (int i = 0; i < 150; ++i) {
+            std::vector<minigit::TreeEntry> entries(2);
+            entries[0].mode = "100644";
+            entries[0].name = "counter";
+            entries[0].hash = store.store_blob("value " + std::to_string(i) + "\n");
+            entries[1].mode = "100644";
+            entries[1].name = "shared";
+            entries[1].hash = shared;
+            minigit::Commit commit;
+            commit.tree = store.store_tree(minigit::build_tree_object(entries));
+            if (!commits.empty()) {
+                commit.parents.push_back(commits.back());
+            }
+            commit.author = "A <a@example.com> 0 +0000";
+            commit.committer = commit.author;
+            commit.message = "c" + std::to_string(i) + "\n";
+            commits.push_back(minigit::write_commit(store, commit));
+        }
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-bitmap.mpk"));
+
+    minigit::ObjectStore store(root);
+    std::vector<std::string> tips(1, commits.back());
+    std::size_t written = 0;
+    ASSERT_TRUE(minigit::write_pack_bitmap(store, fs, "objects/pack/pack-bitmap.mpk", tips,
+                                           written));
+    EXPECT_EQ(written, 2U);
+
+    minigit::PackBitmapIndex bitmaps;
+    ASSERT_TRUE(bitmaps.open_any(fs));
+    EXPECT_EQ(bitmaps.bitmap_count(), 2U);
+    EXPECT_EQ(bitmaps.type_bitmap(minigit::ObjectType::kCommit).count(), 150U);
+
+    std::vector<std::string> include(1, commits.back());
+    std::vector<std::string> exclude(1, commits[50]);
+    minigit::Bitmap wanted;
+    minigit::Bitmap unwanted;
+    ASSERT_TRUE(bitmaps.reachable(store, include, wanted));
+    ASSERT_TRUE(bitmaps.reachable(store, exclude, unwanted));
+    wanted.and_not(unwanted);
+
+    std::vector<std::string> listed;
+    ASSERT_TRUE(minigit::list_reachable_objects(store, include, exclude, true, listed));
+    EXPECT_EQ(listed.size(), 99U * 3U);
+    std::vector<std::size_t> positions;
+    wanted.positions(positions);
+    std::set<std::string> from_bitmap;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        from_bitmap.insert(bitmaps.hash_at(positions[i]));
+    }
+    EXPECT_EQ(from_bitmap, std::set<std::string>(listed.begin(), listed.end()));
+}
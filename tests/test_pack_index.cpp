@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "filesystem.h"
+#include "object_store.h"
+#include "pack.h"
+#include "pack_index.h"
+
+// 本文件包含针对包索引（.idx）的单元测试
+
+// 验证索引写出后可按哈希查找，并保持按 ID 排序
+TEST(PackIndexTest, WriteAndFind) {
+    char tmpl[] = "/tmp/minigit_pack_indexXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string path = std::string(dir) + "/test.idx";
+
+    std::vector<minigit::PackIndexEntry> entries;
+    const char* hashes[] = {"ff00000000000000000000000000000000000000",
+                            "00aa000000000000000000000000000000000000",
+                            "0a00000000000000000000000000000000000001",
+                            "0a00000000000000000000000000000000000000"};
+    for (std::size_t i = 0; i < 4; ++i) {
+        minigit::PackIndexEntry e;
+        e.hash = hashes[i];
+        e.offset = 8 + i * 100;
+        e.crc = static_cast<std::uint32_t>(i + 1);
+        entries.push_back(e);
+    }
+    ASSERT_TRUE(minigit::write_pack_index(path, entries));
+
+    minigit::PackIndex index;
+    ASSERT_TRUE(index.open(path));
+    ASSERT_EQ(index.count(), 4U);
+    EXPECT_EQ(index.hash_at(0), hashes[1]);
+    EXPECT_EQ(index.hash_at(3), hashes[0]);
+
+    std::uint64_t offset = 0;
+    std::uint32_t crc = 0;
+    ASSERT_TRUE(index.find(hashes[2], offset, crc));
+    EXPECT_EQ(offset, 208U);
+    EXPECT_EQ(crc, 3U);
+    EXPECT_FALSE(index.find("0a00000000000000000000000000000000000002", offset, crc));
+    EXPECT_FALSE(index.find("not-a-hash", offset, crc));
+}
+
+// 验证超过 31 位的偏移写入大偏移表后仍能按原值读出
+TEST(PackIndexTest, LargeOffsetsUseSecondTable) {
+    char tmpl[] = "/tmp/minigit_pack_index_largeXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string path = std::string(dir) + "/large.idx";
+
+    const std::uint64_t offsets[] = {8U, 0x7fffffffULL, 0x80000000ULL, 0x123456789aULL};
+    std::vector<minigit::PackIndexEntry> entries;
+    for (std::size_t i = 0; i < 4; ++i) {
+        minigit::PackIndexEntry e;
+        e.hash = std::string(39, '0') + static_cast<char>('1' + i);
+        e.offset = offsets[i];
+        e.crc = 0;
+        entries.push_back(e);
+    }
+    ASSERT_TRUE(minigit::write_pack_index(path, entries));
+
+    minigit::PackIndex index;
+    ASSERT_TRUE(index.open(path));
+    for (std::size_t i = 0; i < 4; ++i) {
+        std::uint64_t offset = 0;
+        std::uint32_t crc = 0;
+        ASSERT_TRUE(index.find(std::string(39, '0') + static_cast<char>('1' + i), offset, crc));
+        EXPECT_EQ(offset, offsets[i]);
+    }
+}
+
+// 验证包文件生成同名索引后，删除松散对象仍可通过索引读取
+TEST(PackIndexTest, StoreReadsThroughIndex) {
+    char tmpl[] = "/tmp/minigit_pack_index_storeXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    std::string h;
+    {
+        minigit::ObjectStore store(root);
+        h = store.store_blob("indexed");
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-test.mpk"));
+    ASSERT_TRUE(fs.exists("objects/pack/pack-test.idx"));
+    std::string loose = fs.make_path("objects/" + h.substr(0, 2) + "/" + h.substr(2));
+    ASSERT_EQ(::unlink(loose.c_str()), 0);
+
+    minigit::ObjectStore store(root);
+    std::string body;
+    ASSERT_TRUE(store.read_object(h, body));
+    EXPECT_EQ(body, "indexed");
+    EXPECT_TRUE(store.has_object(h));
+}
+
+// 验证多包索引覆盖全部包，新增包时增量更新，删除的包从索引中移除
+TEST(PackIndexTest, MultiPackIndexCoversAllPacks) {
+    char tmpl[] = "/tmp/minigit_midxXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    std::string midx_path = fs.make_path("objects/pack/multi-pack-index");
+    std::vector<std::string> hashes;
+    {
+        minigit::ObjectStore store(root);
+        hashes.push_back(store.store_blob("first"));
+        ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-a.mpk"));
+        hashes.push_back(store.store_blob("second"));
+        ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-b.mpk"));
+    }
+    ASSERT_TRUE(minigit::update_multi_pack_index(fs));
+    {
+        minigit::MultiPackIndex midx;
+        ASSERT_TRUE(midx.open(midx_path));
+        EXPECT_EQ(midx.pack_count(), 2U);
+        EXPECT_EQ(midx.count(), 2U);
+        std::uint32_t pack = 0;
+        std::uint64_t offset = 0;
+        ASSERT_TRUE(midx.find(hashes[1], pack, offset));
+        EXPECT_EQ(midx.pack_name(pack), "pack-b.mpk");
+    }
+
+    {
+        minigit::ObjectStore store(root);
+        hashes.push_back(store.store_blob("third"));
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-c.mpk"));
+    ASSERT_EQ(::unlink(fs.make_path("objects/pack/pack-a.mpk").c_str()), 0);
+    ASSERT_TRUE(minigit::update_multi_pack_index(fs));
+    {
+        minigit::MultiPackIndex midx;
+        ASSERT_TRUE(midx.open(midx_path));
+        EXPECT_EQ(midx.pack_count(), 2U);
+        EXPECT_EQ(midx.count(), 3U);
+        std::uint32_t pack = 0;
+        std::uint64_t offset = 0;
+        ASSERT_TRUE(midx.find(hashes[0], pack, offset));
+        EXPECT_EQ(midx.pack_name(pack), "pack-b.mpk");
+        ASSERT_TRUE(midx.find(hashes[2], pack, offset));
+        EXPECT_EQ(midx.pack_name(pack), "pack-c.mpk");
+    }
+
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        const std::string& h = hashes[i];
+        ::unlink(fs.make_path("objects/" + h.substr(0, 2) + "/" + h.substr(2)).c_str());
+    }
+    minigit::ObjectStore store(root);
+    std::string body;
+    ASSERT_TRUE(store.read_object(hashes[2], body));
+    EXPECT_EQ(body, "third");
+}
+
+// 验证反向索引按偏移排列对象，条目占用之和等于包中全部条目的长度
+TEST(PackIndexTest, ReverseIndexGivesOnDiskSizes) {
+    char tmpl[] = "/tmp/minigit_revXXXXXX";
+    char* dir = mkdtemp(tmpl);
+    ASSERT_NE(dir, nullptr);
+    std::string root = std::string(dir) + "/.minigit";
+    minigit::FileSystem fs(root);
+    {
+        minigit::ObjectStore store(root);
+        for (int i = 0; i < 20; ++i) {
+            store.store_blob(std::string(static_cast<std::size_t>(i) * 37U, 'x') +
+                             std::to_string(i));
+        }
+    }
+    ASSERT_TRUE(minigit::write_pack_file(fs, "objects/pack/pack-rev.mpk"));
+    ASSERT_TRUE(fs.exists("objects/pack/pack-rev.rev"));
+
+    struct stat st;
+    ASSERT_EQ(::stat(fs.make_path("objects/pack/pack-rev.mpk").c_str(), &st), 0);
+    for (int round = 0; round < 2; ++round) {
+        std::vector<minigit::PackObjectSize> sizes;
+        ASSERT_TRUE(minigit::pack_object_sizes(fs, "objects/pack/pack-rev.mpk", sizes));
+        ASSERT_EQ(sizes.size(), 20U);
+        EXPECT_EQ(sizes[0].offset, 8U);
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < sizes.size(); ++i) {
+            if (i > 0) {
+                EXPECT_EQ(sizes[i].offset, sizes[i - 1].offset + sizes[i - 1].disk_size);
+            }
+            total += sizes[i].disk_size;
+        }
+        EXPECT_EQ(total, static_cast<std::uint64_t>(st.st_size) - 8U - 20U);
+        if (round == 0) {
+            // 删除反向索引，第二轮验证会重新生成
+            ASSERT_EQ(::unlink(fs.make_path("objects/pack/pack-rev.rev").c_str()), 0);
+        }
+    }
+    EXPECT_TRUE(fs.exists("objects/pack/pack-rev.rev"));
+}
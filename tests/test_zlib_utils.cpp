@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <unistd.h>
+
 #include "zlib_utils.h"
 
 // 本文件包含针对 zlib 压缩/解压工具函数的单元测试
@@ -11,3 +18,52 @@ TEST(ZlibUtilsTest, Roundtrip) {
     std::string decompressed = minigit::zlib_decompress(compressed);
     EXPECT_EQ(original, decompressed);
 }
+
+// 验证多段切片流式压缩写入文件后可以解压还原为拼接结果
+TEST(ZlibUtilsTest, DeflateSlicesToFd) {
+    char tmpl[] = "/tmp/minigit_zlibXXXXXX";
+    int fd = mkstemp(tmpl);
+    ASSERT_GE(fd, 0);
+
+    std::string header = "blob 11";
+    header.push_back('\0');
+    std::string body = "hello slice";
+    minigit::ByteSlice slices[2] = {minigit::make_slice(header),
+                                    minigit::make_slice(body)};
+    ASSERT_TRUE(minigit::zlib_deflate_to_fd(slices, 2, fd));
+    ::close(fd);
+
+    std::ifstream ifs(tmpl, std::ios::binary);
+    std::string compressed((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+    ::unlink(tmpl);
+
+    EXPECT_EQ(minigit::zlib_decompress(compressed), header + body);
+}
+
+// 同一个解压器与缓冲区交替解压大对象、损坏数据与小对象，结果都应正确
+TEST(ZlibUtilsTest, ReusableInflaterAcrossSizesAndErrors) {
+    std::string large(1U << 20, 'x');
+    for (std::size_t i = 0; i < large.size(); i += 97U) {
+        large[i] = static_cast<char>('a' + i % 26U);
+    }
+    std::string small = "commit 3";
+    small.push_back('\0');
+    small += "abc";
+    std::string large_z = minigit::zlib_compress(large);
+    std::string small_z = minigit::zlib_compress(small);
+
+    minigit::ZlibInflater inflater;
+    std::string out;
+    ASSERT_TRUE(inflater.inflate_into(large_z.data(), large_z.size(), out));
+    EXPECT_EQ(out, large);
+    ASSERT_TRUE(inflater.inflate_into(small_z.data(), small_z.size(), out));
+    EXPECT_EQ(out, small);
+    EXPECT_FALSE(inflater.inflate_into(large_z.data(), large_z.size() / 2U, out));
+    std::string corrupt = small_z;
+    corrupt[corrupt.size() / 2U] ^= 0x55;
+    corrupt[2] ^= 0x55;
+    EXPECT_FALSE(inflater.inflate_into(corrupt.data(), corrupt.size(), out));
+    ASSERT_TRUE(inflater.inflate_into(small_z.data(), small_z.size(), out));
+    EXPECT_EQ(out, small);
+}